@@ -0,0 +1,1119 @@
+#include "BigFloat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+using Limbs = std::vector<uint32_t>;
+
+constexpr uint32_t kBase = 1000000000;
+constexpr int kBaseDigits = 9;
+// Limbs carried beyond the requested precision
+constexpr size_t kGuardLimbs = 2;
+
+constexpr size_t kKaratsubaThreshold = 40;
+constexpr size_t kNttThreshold = 400;
+// Longest transform of the smallest prime below; the coefficients of
+// such a product still fit under the product of the three primes
+constexpr size_t kNttMaxLength = size_t(1) << 23;
+
+// Largest |x| exp accepts; the result exponent stays far from overflow
+constexpr double kMaxExpArgument = 1e15;
+
+size_t limbsFor(size_t digits) {
+  return (digits + kBaseDigits - 1) / kBaseDigits + kGuardLimbs;
+}
+
+// ==================== Limb arithmetic ====================
+
+// r[0, n) += a[0, na) with na <= n; returns the carry out of r[n - 1]
+uint32_t addInto(uint32_t *r, size_t n, const uint32_t *a, size_t na) {
+  uint32_t carry = 0;
+  size_t i = 0;
+  for (; i < na; ++i) {
+    uint32_t sum = r[i] + a[i] + carry;
+    carry = sum >= kBase;
+    r[i] = carry ? sum - kBase : sum;
+  }
+  for (; carry && i < n; ++i) {
+    carry = r[i] == kBase - 1;
+    r[i] = carry ? 0 : r[i] + 1;
+  }
+  return carry;
+}
+
+// r[0, n) -= a[0, na); the result must not be negative
+void subInto(uint32_t *r, size_t n, const uint32_t *a, size_t na) {
+  uint32_t borrow = 0;
+  size_t i = 0;
+  for (; i < na; ++i) {
+    int64_t diff = int64_t(r[i]) - a[i] - borrow;
+    borrow = diff < 0;
+    r[i] = static_cast<uint32_t>(borrow ? diff + kBase : diff);
+  }
+  for (; borrow && i < n; ++i) {
+    borrow = r[i] == 0;
+    r[i] = borrow ? kBase - 1 : r[i] - 1;
+  }
+}
+
+size_t significant(const uint32_t *a, size_t n) {
+  while (n > 0 && a[n - 1] == 0)
+    --n;
+  return n;
+}
+
+void mulMagnitude(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                  uint32_t *r);
+
+void mulSchoolbook(const uint32_t *a, size_t na, const uint32_t *b,
+                   size_t nb, uint32_t *r) {
+  std::fill(r, r + na + nb, 0);
+  for (size_t i = 0; i < na; ++i) {
+    const uint64_t ai = a[i];
+    uint64_t carry = 0;
+    for (size_t j = 0; j < nb; ++j) {
+      uint64_t cur = r[i + j] + ai * b[j] + carry;
+      r[i + j] = static_cast<uint32_t>(cur % kBase);
+      carry = cur / kBase;
+    }
+    r[i + nb] = static_cast<uint32_t>(carry);
+  }
+}
+
+// na >= nb
+void mulKaratsuba(const uint32_t *a, size_t na, const uint32_t *b,
+                  size_t nb, uint32_t *r) {
+  const size_t m = (na + 1) / 2;
+  if (nb <= m) {
+    // Unbalanced: multiply b by slices of a as long as b
+    std::fill(r, r + na + nb, 0);
+    Limbs part(2 * nb);
+    for (size_t offset = 0; offset < na; offset += nb) {
+      size_t len = std::min(nb, na - offset);
+      mulMagnitude(a + offset, len, b, nb, part.data());
+      addInto(r + offset, na + nb - offset, part.data(), len + nb);
+    }
+    return;
+  }
+
+  // a = a1 * B^m + a0, b = b1 * B^m + b0:
+  // a * b = z2 * B^2m + (z1 - z2 - z0) * B^m + z0
+  const size_t na1 = na - m, nb1 = nb - m;
+  mulMagnitude(a, m, b, m, r);
+  mulMagnitude(a + m, na1, b + m, nb1, r + 2 * m);
+
+  Limbs sa(a, a + m), sb(b, b + m);
+  sa.push_back(addInto(sa.data(), m, a + m, na1));
+  sb.push_back(addInto(sb.data(), m, b + m, nb1));
+  Limbs z1(2 * m + 2);
+  mulMagnitude(sa.data(), m + 1, sb.data(), m + 1, z1.data());
+  subInto(z1.data(), z1.size(), r, 2 * m);
+  subInto(z1.data(), z1.size(), r + 2 * m, na1 + nb1);
+  addInto(r + m, na + nb - m, z1.data(), significant(z1.data(), z1.size()));
+}
+
+// ==================== Number theoretic transform ====================
+
+template <uint32_t Mod> uint32_t mulMod(uint32_t a, uint32_t b) {
+  return static_cast<uint32_t>(uint64_t(a) * b % Mod);
+}
+
+template <uint32_t Mod> uint32_t powMod(uint32_t base, uint64_t exponent) {
+  uint32_t result = 1;
+  for (; exponent; exponent >>= 1) {
+    if (exponent & 1)
+      result = mulMod<Mod>(result, base);
+    base = mulMod<Mod>(base, base);
+  }
+  return result;
+}
+
+// In-place transform of length 2^k; 3 generates the multiplicative group
+// of every prime used
+template <uint32_t Mod> void transform(Limbs &a, bool inverse) {
+  const size_t n = a.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(a[i], a[j]);
+  }
+
+  Limbs roots(n / 2);
+  for (size_t len = 2; len <= n; len <<= 1) {
+    uint32_t step = powMod<Mod>(3, (Mod - 1) / len);
+    if (inverse)
+      step = powMod<Mod>(step, Mod - 2);
+    const size_t half = len / 2;
+    roots[0] = 1;
+    for (size_t i = 1; i < half; ++i)
+      roots[i] = mulMod<Mod>(roots[i - 1], step);
+    for (size_t i = 0; i < n; i += len) {
+      for (size_t j = 0; j < half; ++j) {
+        uint32_t u = a[i + j];
+        uint32_t v = mulMod<Mod>(a[i + j + half], roots[j]);
+        a[i + j] = u + v >= Mod ? u + v - Mod : u + v;
+        a[i + j + half] = u >= v ? u - v : u + Mod - v;
+      }
+    }
+  }
+
+  if (inverse) {
+    const uint32_t scale = powMod<Mod>(static_cast<uint32_t>(n % Mod), Mod - 2);
+    for (auto &x : a)
+      x = mulMod<Mod>(x, scale);
+  }
+}
+
+// Cyclic convolution of a and b modulo Mod, length n
+template <uint32_t Mod>
+Limbs convolve(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+               size_t n) {
+  Limbs fa(n, 0);
+  for (size_t i = 0; i < na; ++i)
+    fa[i] = a[i] % Mod;
+  transform<Mod>(fa, false);
+  if (a == b && na == nb) {
+    for (auto &x : fa)
+      x = mulMod<Mod>(x, x);
+  } else {
+    Limbs fb(n, 0);
+    for (size_t i = 0; i < nb; ++i)
+      fb[i] = b[i] % Mod;
+    transform<Mod>(fb, false);
+    for (size_t i = 0; i < n; ++i)
+      fa[i] = mulMod<Mod>(fa[i], fb[i]);
+  }
+  transform<Mod>(fa, true);
+  return fa;
+}
+
+constexpr uint32_t kMod1 = 998244353; // 119 * 2^23 + 1
+constexpr uint32_t kMod2 = 167772161; // 5 * 2^25 + 1
+constexpr uint32_t kMod3 = 469762049; // 7 * 2^26 + 1
+
+// Convolution modulo three primes, combined by the Chinese remainder
+// theorem (Garner's form) into exact coefficients, then carried into limbs
+void mulNtt(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+            uint32_t *r) {
+  size_t n = 1;
+  while (n < na + nb)
+    n <<= 1;
+  const Limbs r1 = convolve<kMod1>(a, na, b, nb, n);
+  const Limbs r2 = convolve<kMod2>(a, na, b, nb, n);
+  const Limbs r3 = convolve<kMod3>(a, na, b, nb, n);
+
+  static const uint32_t inv1 = powMod<kMod2>(kMod1 % kMod2, kMod2 - 2);
+  static const uint32_t inv12 = powMod<kMod3>(
+      mulMod<kMod3>(kMod1 % kMod3, kMod2 % kMod3), kMod3 - 2);
+  const unsigned __int128 mod12 = uint64_t(kMod1) * kMod2;
+
+  unsigned __int128 carry = 0;
+  for (size_t i = 0; i < na + nb; ++i) {
+    const uint32_t v1 = r1[i];
+    const uint32_t v2 =
+        mulMod<kMod2>((r2[i] + kMod2 - v1 % kMod2) % kMod2, inv1);
+    const uint64_t low = v1 + uint64_t(v2) * kMod1;
+    const uint32_t v3 = mulMod<kMod3>(
+        static_cast<uint32_t>((r3[i] + kMod3 - low % kMod3) % kMod3), inv12);
+    carry += low + mod12 * v3;
+    r[i] = static_cast<uint32_t>(carry % kBase);
+    carry /= kBase;
+  }
+}
+
+// r[0, na + nb) = a * b
+void mulMagnitude(const uint32_t *a, size_t na, const uint32_t *b, size_t nb,
+                  uint32_t *r) {
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (nb == 0) {
+    std::fill(r, r + na, 0);
+  } else if (nb < kKaratsubaThreshold) {
+    mulSchoolbook(a, na, b, nb, r);
+  } else if (nb >= kNttThreshold && na + nb <= kNttMaxLength) {
+    mulNtt(a, na, b, nb, r);
+  } else {
+    mulKaratsuba(a, na, b, nb, r);
+  }
+}
+
+// ==================== Series ====================
+
+// A hypergeometric series
+//   S = sum_{n=1}^{N} a(n) * prod_{k=1}^{n} p(k) / q(k)
+// is summed by binary splitting: with P and Q the products of p and q
+// over a range of k, and T the sum scaled by Q, two halves combine as
+// P = P1 P2, Q = Q1 Q2, T = T1 Q2 + P1 T2, so S = T / Q is found with
+// exact integer products of balanced size.
+struct Split {
+  BigFloat p, q, t;
+};
+
+struct Term {
+  BigFloat p, q, a;
+};
+
+template <typename TermFn>
+Split splitSeries(uint64_t lo, uint64_t hi, const TermFn &term,
+                  bool needP) {
+  if (hi - lo == 1) {
+    Term leaf = term(hi);
+    BigFloat t = leaf.p * leaf.a;
+    return {std::move(leaf.p), std::move(leaf.q), std::move(t)};
+  }
+  const uint64_t mid = lo + (hi - lo) / 2;
+  Split left = splitSeries(lo, mid, term, true);
+  Split right = splitSeries(mid, hi, term, needP);
+  Split result;
+  result.t = left.t * right.q + left.p * right.t;
+  result.q = left.q * right.q;
+  if (needP)
+    result.p = left.p * right.p;
+  return result;
+}
+
+// Smallest n for which |x|^(step n) / (step n)! is below 10^-digits,
+// where log10x = log10 |x|
+uint64_t termsNeeded(double log10x, size_t digits, int step) {
+  double logTerm = 0;
+  uint64_t n = 0;
+  while (logTerm > -static_cast<double>(digits) - 2 || n == 0) {
+    ++n;
+    for (int i = 0; i < step; ++i) {
+      const double k = static_cast<double>(step * (n - 1) + i + 1);
+      logTerm += log10x - std::log10(k);
+    }
+  }
+  return n;
+}
+
+const BigFloat &half() {
+  static const BigFloat value = BigFloat::parse("0.5");
+  return value;
+}
+} // namespace
+
+// ==================== Construction ====================
+
+BigFloat::BigFloat(long long value) : negative_(value < 0) {
+  uint64_t magnitude = static_cast<uint64_t>(value);
+  if (value < 0)
+    magnitude = 0 - magnitude;
+  while (magnitude) {
+    limbs_.push_back(static_cast<uint32_t>(magnitude % kBase));
+    magnitude /= kBase;
+  }
+  normalize();
+}
+
+BigFloat::BigFloat(Limbs limbs, int64_t exponent, bool negative)
+    : limbs_(std::move(limbs)), exponent_(exponent), negative_(negative) {
+  normalize();
+}
+
+BigFloat BigFloat::parse(std::string_view text) {
+  auto invalid = [&] {
+    return std::invalid_argument("Invalid number: " + std::string(text));
+  };
+  size_t i = 0;
+  bool negative = false;
+  if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+    negative = text[i++] == '-';
+
+  std::string digits;
+  int64_t exponent10 = 0;
+  bool anyDigit = false, point = false;
+  for (; i < text.size(); ++i) {
+    const char c = text[i];
+    if (c >= '0' && c <= '9') {
+      anyDigit = true;
+      if (!digits.empty() || c != '0')
+        digits += c;
+      if (point)
+        --exponent10;
+    } else if (c == '.' && !point) {
+      point = true;
+    } else {
+      break;
+    }
+  }
+  if (!anyDigit)
+    throw invalid();
+
+  if (i < text.size() && (text[i] == 'e' || text[i] == 'E')) {
+    ++i;
+    bool negativeExponent = false;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+      negativeExponent = text[i++] == '-';
+    if (i == text.size())
+      throw invalid();
+    int64_t value = 0;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+      if (value > 1000000000000000LL)
+        throw std::out_of_range("Exponent out of range: " + std::string(text));
+      value = value * 10 + (text[i] - '0');
+    }
+    exponent10 += negativeExponent ? -value : value;
+  }
+  if (i != text.size())
+    throw invalid();
+
+  // Pad to a whole number of limbs below the decimal point
+  int64_t pad = ((exponent10 % kBaseDigits) + kBaseDigits) % kBaseDigits;
+  digits.append(static_cast<size_t>(pad), '0');
+  exponent10 -= pad;
+
+  Limbs limbs;
+  for (size_t end = digits.size(); end > 0;) {
+    const size_t begin = end >= kBaseDigits ? end - kBaseDigits : 0;
+    uint32_t limb = 0;
+    for (size_t k = begin; k < end; ++k)
+      limb = limb * 10 + (digits[k] - '0');
+    limbs.push_back(limb);
+    end = begin;
+  }
+  return BigFloat(std::move(limbs), exponent10 / kBaseDigits, negative);
+}
+
+BigFloat BigFloat::fromDouble(double value) {
+  if (!std::isfinite(value))
+    throw std::invalid_argument("Number is not finite");
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+  return parse(buffer);
+}
+
+void BigFloat::normalize() {
+  while (!limbs_.empty() && limbs_.back() == 0)
+    limbs_.pop_back();
+  size_t zeros = 0;
+  while (zeros < limbs_.size() && limbs_[zeros] == 0)
+    ++zeros;
+  if (zeros) {
+    limbs_.erase(limbs_.begin(), limbs_.begin() + zeros);
+    exponent_ += static_cast<int64_t>(zeros);
+  }
+  if (limbs_.empty()) {
+    exponent_ = 0;
+    negative_ = false;
+  }
+}
+
+void BigFloat::truncate(size_t limbs) {
+  if (limbs == 0 || limbs_.size() <= limbs)
+    return;
+  const size_t drop = limbs_.size() - limbs;
+  limbs_.erase(limbs_.begin(), limbs_.begin() + drop);
+  exponent_ += static_cast<int64_t>(drop);
+  normalize();
+}
+
+BigFloat BigFloat::shifted(int64_t limbs) const {
+  BigFloat result = *this;
+  if (!result.isZero())
+    result.exponent_ += limbs;
+  return result;
+}
+
+BigFloat BigFloat::integerPart() const {
+  if (exponent_ >= 0)
+    return *this;
+  if (top() <= 0)
+    return BigFloat();
+  return BigFloat(Limbs(limbs_.begin() - exponent_, limbs_.end()), 0,
+                  negative_);
+}
+
+void BigFloat::leading(double &mantissa, int64_t &exponent) const {
+  mantissa = 0;
+  for (size_t i = 0; i < 3 && i < limbs_.size(); ++i)
+    mantissa += limbs_[limbs_.size() - 1 - i] * std::pow(1e-9, double(i));
+  if (negative_)
+    mantissa = -mantissa;
+  exponent = top() - 1;
+}
+
+double BigFloat::log10Magnitude() const {
+  double mantissa;
+  int64_t exponent;
+  leading(mantissa, exponent);
+  return std::log10(std::fabs(mantissa)) +
+         static_cast<double>(exponent) * kBaseDigits;
+}
+
+BigFloat BigFloat::fromLeading(double mantissa, int64_t exponent) {
+  return fromDouble(mantissa).shifted(exponent);
+}
+
+// ==================== Comparison ====================
+
+int BigFloat::compareMagnitude(const BigFloat &a, const BigFloat &b) {
+  if (a.isZero() || b.isZero())
+    return a.isZero() == b.isZero() ? 0 : (a.isZero() ? -1 : 1);
+  if (a.top() != b.top())
+    return a.top() < b.top() ? -1 : 1;
+  size_t i = a.limbs_.size(), j = b.limbs_.size();
+  while (i > 0 && j > 0) {
+    --i;
+    --j;
+    if (a.limbs_[i] != b.limbs_[j])
+      return a.limbs_[i] < b.limbs_[j] ? -1 : 1;
+  }
+  // Limbs are non-zero at the low end, so the longer one is larger
+  return i > 0 ? 1 : (j > 0 ? -1 : 0);
+}
+
+int BigFloat::compare(const BigFloat &a, const BigFloat &b) {
+  if (a.negative_ != b.negative_)
+    return a.negative_ ? -1 : 1;
+  const int magnitude = compareMagnitude(a, b);
+  return a.negative_ ? -magnitude : magnitude;
+}
+
+bool BigFloat::isInteger() const { return exponent_ >= 0; }
+
+BigFloat BigFloat::operator-() const {
+  BigFloat result = *this;
+  if (!result.isZero())
+    result.negative_ = !result.negative_;
+  return result;
+}
+
+// ==================== Arithmetic ====================
+
+BigFloat BigFloat::addLimbs(const BigFloat &a, const BigFloat &b,
+                            bool subtract, size_t limbs) {
+  const bool bNegative = b.negative_ != subtract;
+  if (b.isZero()) {
+    BigFloat result = a;
+    result.truncate(limbs);
+    return result;
+  }
+  if (a.isZero()) {
+    BigFloat result = b;
+    result.negative_ = bNegative;
+    result.truncate(limbs);
+    return result;
+  }
+
+  // Limbs more than `limbs` + 1 below the larger operand cannot reach
+  // the result
+  const int64_t hi = std::max(a.top(), b.top());
+  int64_t lo = std::min(a.exponent_, b.exponent_);
+  if (limbs)
+    lo = std::max(lo, hi - static_cast<int64_t>(limbs) - 1);
+
+  // Copy `x` restricted to [lo, hi) into `out`
+  auto window = [&](const BigFloat &x, Limbs &out) {
+    out.assign(static_cast<size_t>(hi - lo + 1), 0);
+    for (size_t i = 0; i < x.limbs_.size(); ++i) {
+      const int64_t position = x.exponent_ + static_cast<int64_t>(i);
+      if (position >= lo)
+        out[static_cast<size_t>(position - lo)] = x.limbs_[i];
+    }
+  };
+  Limbs x, y;
+  window(a, x);
+  window(b, y);
+
+  bool negative = a.negative_;
+  if (a.negative_ == bNegative) {
+    addInto(x.data(), x.size(), y.data(), y.size());
+  } else {
+    const size_t n = x.size();
+    if (std::lexicographical_compare(x.rbegin(), x.rend(), y.rbegin(),
+                                     y.rend())) {
+      std::swap(x, y);
+      negative = bNegative;
+    }
+    subInto(x.data(), n, y.data(), n);
+  }
+  BigFloat result(std::move(x), lo, negative);
+  result.truncate(limbs);
+  return result;
+}
+
+BigFloat BigFloat::add(const BigFloat &a, const BigFloat &b, size_t digits) {
+  return addLimbs(a, b, false, digits ? limbsFor(digits) : 0);
+}
+
+BigFloat BigFloat::sub(const BigFloat &a, const BigFloat &b, size_t digits) {
+  return addLimbs(a, b, true, digits ? limbsFor(digits) : 0);
+}
+
+BigFloat BigFloat::mulLimbs(const BigFloat &a, const BigFloat &b,
+                            size_t limbs) {
+  if (a.isZero() || b.isZero())
+    return BigFloat();
+  // Limbs below the top `limbs` + 1 of either operand cannot reach the
+  // result
+  const size_t keep = limbs ? limbs + 1 : std::numeric_limits<size_t>::max();
+  const size_t na = std::min(a.limbs_.size(), keep);
+  const size_t nb = std::min(b.limbs_.size(), keep);
+  const uint32_t *pa = a.limbs_.data() + (a.limbs_.size() - na);
+  const uint32_t *pb = b.limbs_.data() + (b.limbs_.size() - nb);
+  const int64_t exponent =
+      a.exponent_ + static_cast<int64_t>(a.limbs_.size() - na) + b.exponent_ +
+      static_cast<int64_t>(b.limbs_.size() - nb);
+
+  Limbs product(na + nb);
+  mulMagnitude(pa, na, pb, nb, product.data());
+  BigFloat result(std::move(product), exponent, a.negative_ != b.negative_);
+  result.truncate(limbs);
+  return result;
+}
+
+BigFloat BigFloat::mul(const BigFloat &a, const BigFloat &b, size_t digits) {
+  return mulLimbs(a, b, digits ? limbsFor(digits) : 0);
+}
+
+// Newton's iteration r += r (1 - x r) doubles the correct limbs of
+// r ~ 1/x each step, so each step runs at twice the previous precision
+BigFloat BigFloat::reciprocal(const BigFloat &x, size_t limbs) {
+  std::vector<size_t> steps;
+  for (size_t p = limbs; p > 1; p = (p + 1) / 2)
+    steps.push_back(p);
+
+  double mantissa;
+  int64_t exponent;
+  x.leading(mantissa, exponent);
+  BigFloat r = fromLeading(1.0 / mantissa, -exponent);
+  const BigFloat one(1);
+  for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+    const size_t p = *it + 1;
+    BigFloat error = addLimbs(one, mulLimbs(x, r, p), true, p);
+    r = addLimbs(r, mulLimbs(r, error, p), false, p);
+  }
+  return r;
+}
+
+// The quotient of the mantissas, scaled to `limbs` limbs, is computed as
+// an integer via the reciprocal and corrected by its remainder, so it is
+// exactly the truncated quotient (and exact when the division is)
+BigFloat BigFloat::divLimbs(const BigFloat &a, const BigFloat &b,
+                            size_t limbs) {
+  if (b.isZero())
+    throw std::runtime_error("Division by zero");
+  if (a.isZero())
+    return BigFloat();
+
+  // Limbs of b below the top `limbs` + 2 cannot reach the result
+  BigFloat divisor = b;
+  divisor.truncate(limbs + 2);
+  const BigFloat denominator(divisor.limbs_, 0, false);
+  const size_t nb = divisor.limbs_.size();
+
+  BigFloat numerator = a.abs();
+  numerator.truncate(limbs + nb + 1);
+  // numerator * B^shift / denominator has at least `limbs` + 1 limbs
+  const int64_t shift =
+      static_cast<int64_t>(limbs + nb) + 1 - numerator.top();
+  numerator = numerator.shifted(shift);
+
+  BigFloat quotient =
+      mulLimbs(numerator, reciprocal(denominator, limbs + 2), limbs + 2)
+          .integerPart();
+  BigFloat remainder = numerator - quotient * denominator;
+  const BigFloat one(1);
+  while (remainder.isNegative()) {
+    quotient = quotient - one;
+    remainder = remainder + denominator;
+  }
+  while (compare(remainder, denominator) >= 0) {
+    quotient = quotient + one;
+    remainder = remainder - denominator;
+  }
+
+  quotient = quotient.shifted(-shift - divisor.exponent_);
+  quotient.negative_ = !quotient.isZero() && a.negative_ != b.negative_;
+  quotient.truncate(limbs);
+  return quotient;
+}
+
+BigFloat BigFloat::div(const BigFloat &a, const BigFloat &b, size_t digits) {
+  return divLimbs(a, b, limbsFor(digits));
+}
+
+BigFloat BigFloat::mod(const BigFloat &a, const BigFloat &b) {
+  if (b.isZero())
+    throw std::runtime_error("Division by zero");
+  if (a.isZero())
+    return BigFloat();
+  const size_t limbs =
+      static_cast<size_t>(std::max<int64_t>(0, a.top() - b.top())) + 2;
+  BigFloat r = a - divLimbs(a, b, limbs).floor() * b;
+  // The truncated quotient can be one off; the result takes b's sign
+  while (!r.isZero() && r.isNegative() != b.isNegative())
+    r = r + b;
+  while (compareMagnitude(r, b) >= 0)
+    r = r - b;
+  return r;
+}
+
+// 1/sqrt(x) by Newton's iteration y += y (1 - x y^2) / 2 with doubling
+// precision, then sqrt(x) = x y as an integer square root corrected by
+// its remainder, as in division
+BigFloat BigFloat::sqrt(const BigFloat &x, size_t digits) {
+  if (x.isNegative())
+    throw std::invalid_argument("Square root of negative number");
+  if (x.isZero())
+    return BigFloat();
+  const size_t limbs = limbsFor(digits);
+
+  // sqrt(x) = sqrt(n) / B^(shift / 2) with n = x * B^shift an integer of
+  // at least 2 * limbs + 2 limbs and shift even
+  BigFloat n = x;
+  n.truncate(2 * limbs + 2);
+  int64_t shift = std::max(-n.exponent_,
+                           static_cast<int64_t>(2 * limbs + 2) - n.top());
+  if (shift % 2 != 0)
+    ++shift;
+  n = n.shifted(shift);
+
+  std::vector<size_t> steps;
+  for (size_t p = limbs + 1; p > 1; p = (p + 1) / 2)
+    steps.push_back(p);
+  double mantissa;
+  int64_t exponent;
+  n.leading(mantissa, exponent);
+  if (exponent % 2 != 0) {
+    mantissa *= kBase;
+    --exponent;
+  }
+  BigFloat y = fromLeading(1.0 / std::sqrt(mantissa), -exponent / 2);
+  const BigFloat one(1);
+  for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+    const size_t p = *it + 1;
+    BigFloat error =
+        addLimbs(one, mulLimbs(n, mulLimbs(y, y, p), p), true, p);
+    y = addLimbs(y, mulLimbs(mulLimbs(y, error, p), half(), p), false, p);
+  }
+
+  BigFloat root = mulLimbs(n, y, limbs + 2).integerPart();
+  BigFloat remainder = n - root * root;
+  while (remainder.isNegative()) {
+    remainder = remainder + root + root - one;
+    root = root - one;
+  }
+  while (compare(remainder, root + root) > 0) {
+    root = root + one;
+    remainder = remainder - root - root + one;
+  }
+
+  root = root.shifted(-shift / 2);
+  root.truncate(limbs);
+  return root;
+}
+
+BigFloat BigFloat::powInteger(const BigFloat &base, uint64_t exponent,
+                              size_t limbs) {
+  BigFloat result(1), square = base;
+  for (; exponent; exponent >>= 1) {
+    if (exponent & 1)
+      result = mulLimbs(result, square, limbs);
+    if (exponent > 1)
+      square = mulLimbs(square, square, limbs);
+  }
+  return result;
+}
+
+BigFloat BigFloat::abs() const {
+  BigFloat result = *this;
+  result.negative_ = false;
+  return result;
+}
+
+// ==================== Transcendental functions ====================
+
+// y = c0 + c1 + c2 + ... where c0 holds the integer part and the first
+// limb after the point, and chunk j >= 1 the limbs 2^(j-1) + 1 .. 2^j
+// after the point: c_j = p_j / B^(2^j) with p_j an integer of at most
+// 2^(j-1) limbs. Small chunks need many series terms of small numbers,
+// long chunks few terms, which balances the binary splitting work.
+std::vector<std::pair<BigFloat, int64_t>>
+BigFloat::burstChunks(const BigFloat &y, size_t limbs) {
+  std::vector<std::pair<BigFloat, int64_t>> chunks;
+  int64_t lo = -1, hi = std::numeric_limits<int64_t>::max();
+  while (true) {
+    Limbs part;
+    int64_t base = std::numeric_limits<int64_t>::max();
+    for (size_t i = 0; i < y.limbs_.size(); ++i) {
+      const int64_t position = y.exponent_ + static_cast<int64_t>(i);
+      if (position >= lo && position < hi) {
+        base = std::min(base, position);
+        part.push_back(y.limbs_[i]);
+      }
+    }
+    if (!part.empty()) {
+      BigFloat chunk(std::move(part), base - lo, y.negative_);
+      chunks.emplace_back(std::move(chunk), -lo);
+    }
+    if (lo <= -static_cast<int64_t>(limbs) || lo <= y.exponent_)
+      break;
+    hi = lo;
+    lo = 2 * lo;
+  }
+  return chunks;
+}
+
+BigFloat BigFloat::expLimbs(const BigFloat &x, size_t limbs) {
+  if (x.isZero())
+    return BigFloat(1);
+  const double magnitude = std::fabs(x.toDouble());
+  if (magnitude > kMaxExpArgument)
+    throw std::overflow_error("Result out of range");
+
+  // exp(x) = exp(x / 2^s)^(2^s) with |x / 2^s| < 1; squaring multiplies
+  // the relative error by 2^s, which the extra limbs absorb
+  const int halvings = magnitude >= 0.5 ? std::ilogb(magnitude) + 2 : 0;
+  const size_t work = limbs + 1 + static_cast<size_t>(halvings) / 29;
+  BigFloat y = x;
+  if (halvings)
+    y = mulLimbs(x, powInteger(half(), halvings, 0), work);
+  y.truncate(static_cast<size_t>(std::max<int64_t>(y.top(), 0)) + work);
+
+  BigFloat result(1);
+  for (const auto &[p, shift] : burstChunks(y, work)) {
+    // exp(p / B^shift) - 1 = sum_{n>=1} prod_{k<=n} p / (k B^shift)
+    const uint64_t terms = termsNeeded(
+        p.log10Magnitude() - static_cast<double>(shift) * kBaseDigits,
+        work * kBaseDigits, 1);
+    auto term = [&](uint64_t k) {
+      return Term{p, BigFloat(static_cast<long long>(k)).shifted(shift),
+                  BigFloat(1)};
+    };
+    Split sum = splitSeries(0, terms, term, false);
+    BigFloat chunkExp =
+        addLimbs(BigFloat(1), divLimbs(sum.t, sum.q, work), false, work);
+    result = mulLimbs(result, chunkExp, work);
+  }
+  for (int i = 0; i < halvings; ++i)
+    result = mulLimbs(result, result, work);
+  result.truncate(limbs);
+  return result;
+}
+
+BigFloat BigFloat::exp(const BigFloat &x, size_t digits) {
+  return expLimbs(x, limbsFor(digits));
+}
+
+// ln(m) for m > 0 of moderate size by Newton's iteration on exp:
+// y += m exp(-y) - 1, doubling the precision each step
+BigFloat BigFloat::logNewton(const BigFloat &m, size_t limbs) {
+  const BigFloat one(1);
+  const BigFloat offset = m - one;
+  if (offset.isZero())
+    return BigFloat();
+  // Near 1 the result is small; keep its relative precision
+  const size_t work =
+      limbs + static_cast<size_t>(std::max<int64_t>(0, -offset.top()));
+
+  std::vector<size_t> steps;
+  for (size_t p = work; p > 1; p = (p + 1) / 2)
+    steps.push_back(p);
+  BigFloat y = fromDouble(std::log1p(offset.toDouble()));
+  for (auto it = steps.rbegin(); it != steps.rend(); ++it) {
+    const size_t p = *it + 1;
+    BigFloat correction = addLimbs(mulLimbs(m, expLimbs(-y, p), p), one,
+                                   true, p);
+    y = addLimbs(y, correction, false, p);
+  }
+  y.truncate(limbs);
+  return y;
+}
+
+// x = m * B^e with 1 <= m < B, so ln(x) = ln(m) + e ln(B)
+BigFloat BigFloat::logLimbs(const BigFloat &x, size_t limbs) {
+  if (x.isNegative() || x.isZero())
+    throw std::invalid_argument("Logarithm of non-positive number");
+  const int64_t e = x.top() - 1;
+  const BigFloat m = x.shifted(-e);
+  if (e == 0)
+    return logNewton(m, limbs);
+
+  const size_t work = limbs + 1 +
+                      static_cast<size_t>(std::log10(std::fabs(double(e))) /
+                                          kBaseDigits);
+  BigFloat result = addLimbs(
+      logNewton(m, work),
+      mulLimbs(BigFloat(e), logNewton(BigFloat(kBase), work), work), false,
+      work);
+  result.truncate(limbs);
+  return result;
+}
+
+BigFloat BigFloat::log(const BigFloat &x, size_t digits) {
+  return logLimbs(x, limbsFor(digits));
+}
+
+// Chudnovsky:
+//   1/pi = 12 / 640320^(3/2) * sum_n (-1)^n (6n)! (13591409 + 545140134 n)
+//          / ((3n)! (n!)^3 640320^(3n))
+// summed by binary splitting; each term adds about 14 digits
+BigFloat BigFloat::piLimbs(size_t limbs) {
+  thread_local size_t cachedLimbs = 0;
+  thread_local BigFloat cached;
+  if (cachedLimbs >= limbs) {
+    BigFloat result = cached;
+    result.truncate(limbs);
+    return result;
+  }
+
+  const size_t work = limbs + 1;
+  const uint64_t terms =
+      static_cast<uint64_t>(work * kBaseDigits / 14.181647462725477) + 2;
+  const BigFloat c3Over24(10939058860032000LL);
+  auto term = [&](uint64_t k) {
+    const long long n = static_cast<long long>(k);
+    BigFloat p = BigFloat(6 * n - 5) * BigFloat((2 * n - 1) * (6 * n - 1));
+    BigFloat q = BigFloat(n * n) * BigFloat(n) * c3Over24;
+    return Term{-p, std::move(q), BigFloat(13591409 + 545140134LL * n)};
+  };
+  Split sum = splitSeries(0, terms, term, false);
+
+  const BigFloat numerator = mulLimbs(
+      mulLimbs(sum.q, BigFloat(426880), work), sqrt(BigFloat(10005),
+                                                    work * kBaseDigits),
+      work);
+  const BigFloat denominator =
+      addLimbs(mulLimbs(sum.q, BigFloat(13591409), 0), sum.t, false, work);
+  BigFloat result = divLimbs(numerator, denominator, work);
+
+  cached = result;
+  cachedLimbs = work;
+  result.truncate(limbs);
+  return result;
+}
+
+BigFloat BigFloat::pi(size_t digits) { return piLimbs(limbsFor(digits)); }
+
+void BigFloat::sinCos(const BigFloat &x, size_t limbs, BigFloat *sine,
+                      BigFloat *cosine) {
+  // r = x - 2 pi k with |r| <= pi
+  const size_t work = limbs + 1 +
+                      static_cast<size_t>(std::max<int64_t>(0, x.top()));
+  BigFloat r = x;
+  if (std::fabs(x.toDouble()) > 3) {
+    const BigFloat twoPi = mulLimbs(piLimbs(work), BigFloat(2), work);
+    const BigFloat k =
+        addLimbs(divLimbs(x, twoPi, work), half(), false, work).floor();
+    r = addLimbs(x, mulLimbs(k, twoPi, work), true, work);
+  }
+  // sin(r) ~ r for small r: keep its relative precision
+  const size_t series =
+      work + static_cast<size_t>(std::max<int64_t>(0, -r.top()));
+  r.truncate(static_cast<size_t>(std::max<int64_t>(r.top(), 0)) + series);
+
+  BigFloat s, c(1);
+  const BigFloat one(1);
+  for (const auto &[p, shift] : burstChunks(r, series)) {
+    // sin(t) = t (1 + sum_{n>=1} prod_{k<=n} -t^2 / ((2k)(2k+1)))
+    // cos(t) = 1 + sum_{n>=1} prod_{k<=n} -t^2 / ((2k-1)(2k))
+    // with t = p / B^shift
+    const BigFloat p2 = -(p * p);
+    const uint64_t terms = termsNeeded(
+        p.log10Magnitude() - static_cast<double>(shift) * kBaseDigits,
+        series * kBaseDigits, 2);
+    auto sinTerm = [&](uint64_t k) {
+      const long long n = static_cast<long long>(k);
+      return Term{p2, BigFloat(2 * n * (2 * n + 1)).shifted(2 * shift),
+                  one};
+    };
+    auto cosTerm = [&](uint64_t k) {
+      const long long n = static_cast<long long>(k);
+      return Term{p2, BigFloat((2 * n - 1) * 2 * n).shifted(2 * shift), one};
+    };
+    Split sinSum = splitSeries(0, terms, sinTerm, false);
+    Split cosSum = splitSeries(0, terms, cosTerm, false);
+    const BigFloat t = p.shifted(-shift);
+    const BigFloat chunkSin = mulLimbs(
+        t, addLimbs(one, divLimbs(sinSum.t, sinSum.q, series), false, series),
+        series);
+    const BigFloat chunkCos =
+        addLimbs(one, divLimbs(cosSum.t, cosSum.q, series), false, series);
+
+    // Angle addition
+    BigFloat nextSin =
+        addLimbs(mulLimbs(s, chunkCos, series), mulLimbs(c, chunkSin, series),
+                 false, series);
+    c = addLimbs(mulLimbs(c, chunkCos, series), mulLimbs(s, chunkSin, series),
+                 true, series);
+    s = std::move(nextSin);
+  }
+  s.truncate(limbs);
+  c.truncate(limbs);
+  if (sine)
+    *sine = std::move(s);
+  if (cosine)
+    *cosine = std::move(c);
+}
+
+BigFloat BigFloat::sin(const BigFloat &x, size_t digits) {
+  BigFloat result;
+  sinCos(x, limbsFor(digits), &result, nullptr);
+  return result;
+}
+
+BigFloat BigFloat::cos(const BigFloat &x, size_t digits) {
+  BigFloat result;
+  sinCos(x, limbsFor(digits), nullptr, &result);
+  return result;
+}
+
+BigFloat BigFloat::tan(const BigFloat &x, size_t digits) {
+  BigFloat sine, cosine;
+  const size_t limbs = limbsFor(digits);
+  sinCos(x, limbs + 1, &sine, &cosine);
+  return divLimbs(sine, cosine, limbs);
+}
+
+BigFloat BigFloat::pow(const BigFloat &base, const BigFloat &exponent,
+                       size_t digits) {
+  if (base.isZero())
+    return BigFloat();
+  if (exponent.isZero())
+    return BigFloat(1);
+  const bool integer = exponent.isInteger();
+  if (base.isNegative() && !integer)
+    throw std::invalid_argument("Negative base with non-integer exponent");
+
+  const size_t limbs = limbsFor(digits);
+  const bool odd = integer && exponent.exponent_ == 0 &&
+                   (exponent.limbs_[0] & 1) != 0;
+  BigFloat result;
+  if (integer && exponent.top() <= 2) {
+    // Repeated squaring; the relative error grows with the exponent
+    uint64_t n = 0;
+    for (int64_t position = exponent.top() - 1; position >= 0; --position) {
+      const int64_t index = position - exponent.exponent_;
+      n = n * kBase + (index >= 0 ? exponent.limbs_[index] : 0);
+    }
+    const size_t work = limbs + 2 + (n >= kBase ? 1 : 0);
+    result = powInteger(base.abs(), n, work);
+    if (exponent.isNegative())
+      result = divLimbs(BigFloat(1), result, work);
+  } else {
+    const size_t work =
+        limbs + 1 + static_cast<size_t>(std::max<int64_t>(0, exponent.top()));
+    result = expLimbs(
+        mulLimbs(exponent, logLimbs(base.abs(), work), work), work);
+  }
+  if (base.isNegative() && odd)
+    result.negative_ = true;
+  result.truncate(limbs);
+  return result;
+}
+
+BigFloat BigFloat::floor() const {
+  BigFloat result = integerPart();
+  if (negative_ && !isInteger())
+    result = result - BigFloat(1);
+  return result;
+}
+
+BigFloat BigFloat::factorial(uint32_t n) {
+  // Product of lo..hi, split in balanced halves so that the big
+  // multiplications have operands of equal size
+  auto product = [](auto &self, uint32_t lo, uint32_t hi) -> BigFloat {
+    if (hi - lo < 16) {
+      BigFloat result(1);
+      uint64_t run = 1;
+      for (uint64_t k = lo; k <= hi; ++k) {
+        if (run > std::numeric_limits<uint64_t>::max() / k / 2) {
+          result = result * BigFloat(static_cast<long long>(run));
+          run = 1;
+        }
+        run *= k;
+      }
+      return result * BigFloat(static_cast<long long>(run));
+    }
+    const uint32_t mid = lo + (hi - lo) / 2;
+    return self(self, lo, mid) * self(self, mid + 1, hi);
+  };
+  return n < 2 ? BigFloat(1) : product(product, 2, n);
+}
+
+// ==================== Conversion ====================
+
+std::string BigFloat::toString(size_t digits) const {
+  if (isZero())
+    return "0";
+
+  std::string text = std::to_string(limbs_.back());
+  char buffer[32];
+  for (size_t i = limbs_.size() - 1; i-- > 0;) {
+    std::snprintf(buffer, sizeof(buffer), "%09u", limbs_[i]);
+    text += buffer;
+  }
+  // value = d.ddd * 10^exponent10
+  int64_t exponent10 =
+      static_cast<int64_t>(text.size()) - 1 + exponent_ * kBaseDigits;
+
+  if (digits && text.size() > digits) {
+    const bool roundUp = text[digits] >= '5';
+    text.resize(digits);
+    if (roundUp) {
+      size_t i = digits;
+      while (i > 0 && text[i - 1] == '9')
+        text[--i] = '0';
+      if (i == 0) {
+        text.insert(text.begin(), '1');
+        text.pop_back();
+        ++exponent10;
+      } else {
+        ++text[i - 1];
+      }
+    }
+  }
+  while (text.size() > 1 && text.back() == '0')
+    text.pop_back();
+
+  std::string result = negative_ ? "-" : "";
+  const int64_t shown = static_cast<int64_t>(text.size());
+  const bool plain = exponent10 >= -5 &&
+                     (digits == 0 ||
+                      exponent10 < std::max<int64_t>(
+                                       static_cast<int64_t>(digits), shown));
+  if (!plain) {
+    result += text[0];
+    if (shown > 1) {
+      result += '.';
+      result.append(text, 1, std::string::npos);
+    }
+    std::snprintf(buffer, sizeof(buffer), "e%c%02lld",
+                  exponent10 < 0 ? '-' : '+',
+                  static_cast<long long>(std::llabs(exponent10)));
+    return result + buffer;
+  }
+  if (exponent10 < 0) {
+    result += "0.";
+    result.append(static_cast<size_t>(-exponent10 - 1), '0');
+    return result + text;
+  }
+  const size_t integerDigits = static_cast<size_t>(exponent10) + 1;
+  if (text.size() <= integerDigits) {
+    result += text;
+    result.append(integerDigits - text.size(), '0');
+    return result;
+  }
+  result.append(text, 0, integerDigits);
+  result += '.';
+  result.append(text, integerDigits, std::string::npos);
+  return result;
+}
+
+double BigFloat::toDouble() const {
+  if (isZero())
+    return 0;
+  return std::strtod(toString(20).c_str(), nullptr);
+}
@@ -0,0 +1,197 @@
+#ifndef BIGFLOAT_H
+#define BIGFLOAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Arbitrary-precision decimal floating-point number
+ *
+ * The value is sign * mantissa * 10^(9 * exponent), with the mantissa
+ * held in base-10^9 limbs, so decimal input and output are exact and
+ * cheap. Sums, differences and products of integers are exact; the
+ * operations taking a `digits` argument round towards zero to at least
+ * that many significant decimal digits.
+ *
+ * Multiplication picks schoolbook, Karatsuba or a three-prime number
+ * theoretic transform by operand size. Division and square root are
+ * Newton iterations on the reciprocal (square root) that double the
+ * working precision each step. exp, sin and cos sum their Taylor series
+ * by binary splitting over the bits of the argument ("bit-burst"), log is
+ * a Newton iteration on exp, and pi uses the Chudnovsky series, again
+ * by binary splitting.
+ */
+class BigFloat {
+public:
+  BigFloat() = default;
+  BigFloat(long long value);
+
+  /**
+   * @brief Parse a decimal number such as "-12.5e-3" exactly
+   * @throws std::invalid_argument if the text is not such a number
+   */
+  static BigFloat parse(std::string_view text);
+
+  /**
+   * @brief `value` to 17 significant digits, which read back as `value`
+   * @throws std::invalid_argument for infinities and NaN
+   */
+  static BigFloat fromDouble(double value);
+
+  /**
+   * @brief Sum, difference and product; `digits` 0 keeps them exact
+   */
+  static BigFloat add(const BigFloat &a, const BigFloat &b,
+                      size_t digits = 0);
+  static BigFloat sub(const BigFloat &a, const BigFloat &b,
+                      size_t digits = 0);
+  static BigFloat mul(const BigFloat &a, const BigFloat &b,
+                      size_t digits = 0);
+
+  /**
+   * @throws std::runtime_error on division by zero
+   */
+  static BigFloat div(const BigFloat &a, const BigFloat &b, size_t digits);
+
+  /**
+   * @brief a - b * floor(a / b); exact when a and b are
+   * @throws std::runtime_error if b is zero
+   */
+  static BigFloat mod(const BigFloat &a, const BigFloat &b);
+
+  /**
+   * @throws std::invalid_argument for negative numbers
+   */
+  static BigFloat sqrt(const BigFloat &x, size_t digits);
+
+  /**
+   * @throws std::overflow_error if the result exponent would not fit
+   */
+  static BigFloat exp(const BigFloat &x, size_t digits);
+
+  /**
+   * @brief Natural logarithm
+   * @throws std::invalid_argument for non-positive numbers
+   */
+  static BigFloat log(const BigFloat &x, size_t digits);
+
+  // Arguments in radians
+  static BigFloat sin(const BigFloat &x, size_t digits);
+  static BigFloat cos(const BigFloat &x, size_t digits);
+  static BigFloat tan(const BigFloat &x, size_t digits);
+
+  /**
+   * @brief base^exponent with MathUtils::my_pow's conventions
+   *
+   * 0^y is 0 and x^0 is 1; integer exponents use repeated squaring, other
+   * exponents exp(y * log(x)).
+   * @throws std::invalid_argument for a negative base with a non-integer
+   *         exponent
+   */
+  static BigFloat pow(const BigFloat &base, const BigFloat &exponent,
+                      size_t digits);
+
+  static BigFloat pi(size_t digits);
+
+  /**
+   * @brief n! exactly, by a balanced product tree
+   */
+  static BigFloat factorial(uint32_t n);
+
+  /**
+   * @brief Decimal text rounded to `digits` significant digits
+   *
+   * Plain notation while the decimal exponent is between -5 and the
+   * number of digits shown, scientific ("1.5e+100") otherwise. Trailing
+   * zeros after the decimal point are dropped. `digits` 0 prints every
+   * digit of the mantissa.
+   */
+  std::string toString(size_t digits = 0) const;
+
+  double toDouble() const;
+
+  BigFloat abs() const;
+  /**
+   * @brief Largest integer not above the value
+   */
+  BigFloat floor() const;
+
+  bool isZero() const { return limbs_.empty(); }
+  bool isNegative() const { return negative_; }
+  bool isInteger() const;
+
+  BigFloat operator-() const;
+  friend BigFloat operator+(const BigFloat &a, const BigFloat &b) {
+    return add(a, b);
+  }
+  friend BigFloat operator-(const BigFloat &a, const BigFloat &b) {
+    return sub(a, b);
+  }
+  friend BigFloat operator*(const BigFloat &a, const BigFloat &b) {
+    return mul(a, b);
+  }
+
+  /**
+   * @brief -1, 0 or 1 as a is less than, equal to or greater than b
+   */
+  static int compare(const BigFloat &a, const BigFloat &b);
+  friend bool operator==(const BigFloat &a, const BigFloat &b) {
+    return compare(a, b) == 0;
+  }
+  friend bool operator<(const BigFloat &a, const BigFloat &b) {
+    return compare(a, b) < 0;
+  }
+
+private:
+  using Limbs = std::vector<uint32_t>;
+
+  // Least significant limb first; no zero limbs at either end
+  Limbs limbs_;
+  // Power of 10^9 of limbs_[0]
+  int64_t exponent_ = 0;
+  bool negative_ = false;
+
+  BigFloat(Limbs limbs, int64_t exponent, bool negative);
+
+  // Power of 10^9 just above the most significant limb
+  int64_t top() const {
+    return exponent_ + static_cast<int64_t>(limbs_.size());
+  }
+  void normalize();
+  // Keep the `limbs` most significant limbs (all if 0)
+  void truncate(size_t limbs);
+  // Value times 10^(9 * limbs)
+  BigFloat shifted(int64_t limbs) const;
+  // Toward zero
+  BigFloat integerPart() const;
+  // value ~ mantissa * 10^(9 * exponent), 1 <= |mantissa| < 10^9
+  void leading(double &mantissa, int64_t &exponent) const;
+  double log10Magnitude() const;
+  static BigFloat fromLeading(double mantissa, int64_t exponent);
+  static int compareMagnitude(const BigFloat &a, const BigFloat &b);
+
+  // Working precisions below are in limbs, 0 meaning exact
+  static BigFloat addLimbs(const BigFloat &a, const BigFloat &b,
+                           bool subtract, size_t limbs);
+  static BigFloat mulLimbs(const BigFloat &a, const BigFloat &b,
+                           size_t limbs);
+  static BigFloat divLimbs(const BigFloat &a, const BigFloat &b,
+                           size_t limbs);
+  static BigFloat reciprocal(const BigFloat &x, size_t limbs);
+  static BigFloat powInteger(const BigFloat &base, uint64_t exponent,
+                             size_t limbs);
+  static BigFloat expLimbs(const BigFloat &x, size_t limbs);
+  static BigFloat logNewton(const BigFloat &m, size_t limbs);
+  static BigFloat logLimbs(const BigFloat &x, size_t limbs);
+  static BigFloat piLimbs(size_t limbs);
+  static void sinCos(const BigFloat &x, size_t limbs, BigFloat *sine,
+                     BigFloat *cosine);
+  static std::vector<std::pair<BigFloat, int64_t>>
+  burstChunks(const BigFloat &y, size_t limbs);
+};
+
+#endif // BIGFLOAT_H
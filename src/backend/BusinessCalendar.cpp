@@ -0,0 +1,232 @@
+#include "BusinessCalendar.h"
+#include <algorithm>
+#include <bitset>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+int64_t floorDiv(int64_t value, int64_t divisor) {
+  return (value >= 0 ? value : value - divisor + 1) / divisor;
+}
+
+int32_t narrowDay(int64_t day) {
+  if (day < INT32_MIN || day > INT32_MAX)
+    throw std::out_of_range("Date outside the business calendar range");
+  return static_cast<int32_t>(day);
+}
+
+int popcount(uint64_t word) {
+  return static_cast<int>(std::bitset<64>(word).count());
+}
+
+} // namespace
+
+BusinessCalendar::BusinessCalendar(uint8_t weekend) : weekend_(weekend) {
+  workdaysPerWeek_ = 0;
+  workdaysBefore_[0] = 0;
+  for (int offset = 0; offset < 7; ++offset) {
+    if (!(weekend & (1 << offset)))
+      workdayOffset_[workdaysPerWeek_++] = offset;
+    workdaysBefore_[offset + 1] = workdaysPerWeek_;
+  }
+  if (workdaysPerWeek_ == 0)
+    throw std::invalid_argument("Calendar has no business days");
+}
+
+int32_t BusinessCalendar::dayNumber(const CivilDate &date) {
+  return narrowDay(date.toDays());
+}
+
+void BusinessCalendar::addHoliday(const CivilDate &date) {
+  int32_t day = dayNumber(date);
+  addHolidays(&day, 1);
+}
+
+void BusinessCalendar::addHolidays(const int32_t *days, size_t n) {
+  uint8_t weekdays[64];
+  for (size_t start = 0; start < n; start += 64) {
+    size_t count = std::min<size_t>(n - start, 64);
+    BusinessCalendar::weekdays(days + start, weekdays, count);
+
+    for (size_t i = 0; i < count; ++i) {
+      if (weekend_ & (1 << (weekdays[i] - 1)))
+        continue;
+      int64_t day = days[start + i];
+      // Grow the bitset in whole words to cover the day
+      int64_t word = floorDiv(day, 64);
+      if (holidayBits_.empty()) {
+        holidayBase_ = static_cast<int32_t>(word * 64);
+        holidayBits_.push_back(0);
+      }
+      int64_t first = floorDiv(holidayBase_, 64);
+      if (word < first) {
+        holidayBits_.insert(holidayBits_.begin(),
+                            static_cast<size_t>(first - word), 0);
+        holidayBase_ = static_cast<int32_t>(word * 64);
+        first = word;
+      }
+      size_t index = static_cast<size_t>(word - first);
+      if (index >= holidayBits_.size())
+        holidayBits_.resize(index + 1, 0);
+
+      uint64_t bit = uint64_t(1) << (day - word * 64);
+      if (!(holidayBits_[index] & bit)) {
+        holidayBits_[index] |= bit;
+        ++holidayTotal_;
+      }
+    }
+  }
+  rebuildRanks();
+}
+
+size_t BusinessCalendar::loadHolidays(const std::string &filename) {
+  std::ifstream file(filename);
+  if (!file) {
+    throw std::runtime_error("Failed to open file: " + filename);
+  }
+
+  std::vector<int32_t> days;
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(file, line)) {
+    ++lineNumber;
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#')
+      continue;
+    CivilDate date;
+    if (!CivilDate::tryParse(line, date)) {
+      throw std::runtime_error("Invalid holiday date on line " +
+                               std::to_string(lineNumber) + ": " + line);
+    }
+    int64_t day = date.toDays();
+    if (day < INT32_MIN || day > INT32_MAX) {
+      throw std::runtime_error("Holiday date out of range on line " +
+                               std::to_string(lineNumber) + ": " + line);
+    }
+    days.push_back(static_cast<int32_t>(day));
+  }
+
+  addHolidays(days.data(), days.size());
+  return days.size();
+}
+
+bool BusinessCalendar::isBusinessDay(int32_t day) const {
+  uint8_t result;
+  isBusinessDay(&day, &result, 1);
+  return result != 0;
+}
+
+int32_t BusinessCalendar::addBusinessDays(int32_t day, int32_t n) const {
+  // Business days counted from day + 1 forwards, or up to day backwards
+  int64_t forward = n > 0;
+  int64_t k = businessDaysBefore(day + forward) + n - forward;
+  return narrowDay(selectBusinessDay(k));
+}
+
+void BusinessCalendar::weekdays(const int32_t *in, uint8_t *out, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    // 32-bit remainders so the loop vectorizes; 1970-01-01 was a Thursday
+    int32_t fromMonday = (in[i] % 7 + 10) % 7;
+    out[i] = static_cast<uint8_t>(fromMonday + 1);
+  }
+}
+
+void BusinessCalendar::isBusinessDay(const int32_t *in, uint8_t *out,
+                                     size_t n) const {
+  const int64_t bits = static_cast<int64_t>(holidayBits_.size()) * 64;
+  for (size_t i = 0; i < n; ++i) {
+    int32_t fromMonday = (in[i] % 7 + 10) % 7;
+    bool workday = !((weekend_ >> fromMonday) & 1);
+
+    int64_t offset = static_cast<int64_t>(in[i]) - holidayBase_;
+    bool holiday = offset >= 0 && offset < bits &&
+                   ((holidayBits_[offset >> 6] >> (offset & 63)) & 1);
+    out[i] = workday && !holiday;
+  }
+}
+
+void BusinessCalendar::businessDaysBetween(const int32_t *from,
+                                           const int32_t *to, int64_t *out,
+                                           size_t n) const {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = businessDaysBefore(to[i]) - businessDaysBefore(from[i]);
+}
+
+void BusinessCalendar::addBusinessDays(const int32_t *in,
+                                       const int32_t *offsets, int32_t *out,
+                                       size_t n) const {
+  for (size_t i = 0; i < n; ++i)
+    out[i] = addBusinessDays(in[i], offsets[i]);
+}
+
+void BusinessCalendar::endOfMonth(const int32_t *in, int32_t *out,
+                                  size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    CivilDate date = CivilDate::fromDays(in[i]);
+    int32_t remaining = static_cast<int32_t>(
+        CivilDate::daysInMonth(date.year, date.month) - date.day);
+    out[i] = narrowDay(int64_t(in[i]) + remaining);
+  }
+}
+
+void BusinessCalendar::addMonths(const int32_t *in, int32_t months,
+                                 int32_t *out, size_t n,
+                                 bool endOfMonthRule) {
+  for (size_t i = 0; i < n; ++i) {
+    CivilDate date = CivilDate::fromDays(in[i]);
+    bool lastDay = date.day == CivilDate::daysInMonth(date.year, date.month);
+
+    int64_t month = static_cast<int64_t>(date.year) * 12 + date.month - 1 +
+                    months;
+    date.year = static_cast<int>(floorDiv(month, 12));
+    date.month = static_cast<unsigned>(month - int64_t(date.year) * 12 + 1);
+    unsigned length = CivilDate::daysInMonth(date.year, date.month);
+    date.day = endOfMonthRule && lastDay ? length : std::min(date.day, length);
+    out[i] = narrowDay(date.toDays());
+  }
+}
+
+int64_t BusinessCalendar::workdaysBefore(int64_t day) const {
+  int64_t sinceMonday = day - kMonday0;
+  int64_t weeks = floorDiv(sinceMonday, 7);
+  return weeks * workdaysPerWeek_ + workdaysBefore_[sinceMonday - weeks * 7];
+}
+
+int64_t BusinessCalendar::holidaysBefore(int64_t day) const {
+  int64_t offset = day - holidayBase_;
+  if (offset <= 0)
+    return 0;
+  if (offset >= static_cast<int64_t>(holidayBits_.size()) * 64)
+    return holidayTotal_;
+  size_t word = static_cast<size_t>(offset >> 6);
+  uint64_t below = (uint64_t(1) << (offset & 63)) - 1;
+  return holidayRanks_[word] + popcount(holidayBits_[word] & below);
+}
+
+int64_t BusinessCalendar::selectWorkday(int64_t k) const {
+  int64_t weeks = floorDiv(k, workdaysPerWeek_);
+  int64_t index = k - weeks * workdaysPerWeek_;
+  return kMonday0 + weeks * 7 + workdayOffset_[index];
+}
+
+int64_t BusinessCalendar::selectBusinessDay(int64_t k) const {
+  // The k-th workday, pushed later by the holidays up to it until no
+  // more holidays are passed; each step moves forward monotonically
+  int64_t day = selectWorkday(k);
+  while (true) {
+    int64_t next = selectWorkday(k + holidaysBefore(day + 1));
+    if (next == day)
+      return day;
+    day = next;
+  }
+}
+
+void BusinessCalendar::rebuildRanks() {
+  holidayRanks_.resize(holidayBits_.size());
+  int64_t rank = 0;
+  for (size_t i = 0; i < holidayBits_.size(); ++i) {
+    holidayRanks_[i] = rank;
+    rank += popcount(holidayBits_[i]);
+  }
+}
@@ -0,0 +1,145 @@
+#ifndef BUSINESSCALENDAR_H
+#define BUSINESSCALENDAR_H
+
+#include "CivilDate.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Business-day arithmetic over arrays of day numbers
+ *
+ * Days are CivilDate day numbers (days since 1970-01-01) as int32_t,
+ * which covers about +-5.8 million years. A day is a business day unless
+ * its weekday is in the weekend mask or it is a holiday.
+ *
+ * Every count is answered in O(1) from a closed form: the number of
+ * business days before day x is
+ *   weeks(x) * workdaysPerWeek + workdaysInPartialWeek(x) - holidays(x),
+ * where holidays(x) is a rank query on a bitset of the weekday holidays
+ * (popcount of one word plus a per-word prefix sum). Adding business
+ * days inverts that function with a short fixed-point iteration. The
+ * batch loops are branch-free apart from the holiday range check, so
+ * the compiler can vectorize them.
+ *
+ * Batch functions write out[i] for i < n from in[i]; in and out may
+ * alias when they have the same type.
+ */
+class BusinessCalendar {
+public:
+  // Weekend mask bits, by ISO weekday
+  static constexpr uint8_t kMonday = 1 << 0;
+  static constexpr uint8_t kTuesday = 1 << 1;
+  static constexpr uint8_t kWednesday = 1 << 2;
+  static constexpr uint8_t kThursday = 1 << 3;
+  static constexpr uint8_t kFriday = 1 << 4;
+  static constexpr uint8_t kSaturday = 1 << 5;
+  static constexpr uint8_t kSunday = 1 << 6;
+
+  /**
+   * @throws std::invalid_argument if every day is a weekend day
+   */
+  explicit BusinessCalendar(uint8_t weekend = kSaturday | kSunday);
+
+  /**
+   * @brief Day number of `date` as used by the calendar
+   * @throws std::out_of_range if it does not fit int32_t
+   */
+  static int32_t dayNumber(const CivilDate &date);
+
+  /**
+   * @brief Add holidays; holidays falling on a weekend are ignored
+   * @throws std::out_of_range if `date` does not fit the day range
+   */
+  void addHoliday(const CivilDate &date);
+  void addHolidays(const int32_t *days, size_t n);
+
+  /**
+   * @brief Add the holidays listed in a file, one date per line
+   *
+   * Dates use the DateMode formats; blank lines and lines starting with
+   * '#' are skipped.
+   * @return Number of dates read
+   * @throws std::runtime_error if the file cannot be opened or a line is
+   *         not a date in the day range
+   */
+  size_t loadHolidays(const std::string &filename);
+
+  /**
+   * @brief Number of weekday holidays
+   */
+  size_t holidayCount() const { return holidayTotal_; }
+
+  bool isBusinessDay(int32_t day) const;
+
+  /**
+   * @brief Business days in [from, to); negative if to < from
+   */
+  int64_t businessDaysBetween(int32_t from, int32_t to) const {
+    return businessDaysBefore(to) - businessDaysBefore(from);
+  }
+
+  /**
+   * @brief The n-th business day after `day` (before it for negative n)
+   *
+   * n = 0 rolls a non-business day forward to the next business day.
+   * @throws std::out_of_range if the result does not fit int32_t
+   */
+  int32_t addBusinessDays(int32_t day, int32_t n) const;
+
+  // ISO weekday (1 = Monday .. 7 = Sunday)
+  static void weekdays(const int32_t *in, uint8_t *out, size_t n);
+  void isBusinessDay(const int32_t *in, uint8_t *out, size_t n) const;
+  void businessDaysBetween(const int32_t *from, const int32_t *to,
+                           int64_t *out, size_t n) const;
+  // These three throw std::out_of_range when a result does not fit
+  // int32_t; out[] is then partly written
+  void addBusinessDays(const int32_t *in, const int32_t *offsets,
+                       int32_t *out, size_t n) const;
+
+  // Last day of the month of in[i]
+  static void endOfMonth(const int32_t *in, int32_t *out, size_t n);
+
+  /**
+   * @brief Shift by whole months, clamping the day to the month length
+   *
+   * With `endOfMonthRule`, a date on the last day of its month maps to
+   * the last day of the target month (28/02/2023 + 1 month = 31/03/2023).
+   */
+  static void addMonths(const int32_t *in, int32_t months, int32_t *out,
+                        size_t n, bool endOfMonthRule = true);
+
+private:
+  // Day number of a Monday; weeks are counted from it
+  static constexpr int32_t kMonday0 = 4;
+
+  // Days are int64_t here so that steps past the int32_t range do not
+  // wrap; public results are range-checked before narrowing
+  int64_t businessDaysBefore(int64_t day) const {
+    return workdaysBefore(day) - holidaysBefore(day);
+  }
+  int64_t workdaysBefore(int64_t day) const;
+  int64_t holidaysBefore(int64_t day) const;
+  // Smallest day with businessDaysBefore(day + 1) > k
+  int64_t selectBusinessDay(int64_t k) const;
+  // Same, ignoring holidays
+  int64_t selectWorkday(int64_t k) const;
+  void rebuildRanks();
+
+  int32_t workdaysPerWeek_;
+  // Workdays among the first i days of a week starting on Monday
+  int32_t workdaysBefore_[8];
+  // Weekday offset (0 = Monday) of the i-th workday of a week
+  int32_t workdayOffset_[7];
+  uint8_t weekend_;
+
+  // Bit d - holidayBase_ is set for each weekday holiday d
+  int32_t holidayBase_ = 0;
+  std::vector<uint64_t> holidayBits_;
+  // Holidays in the words before each word
+  std::vector<int64_t> holidayRanks_;
+  int64_t holidayTotal_ = 0;
+};
+
+#endif // BUSINESSCALENDAR_H
@@ -78,7 +78,8 @@ void CalculatorEngine::calculate() {
   }
 
   try {
-    double result = ExpressionEvaluator::evaluate(fullExpr);
+    double result = cache_ ? ExpressionEvaluator::evaluate(fullExpr, *cache_)
+                           : ExpressionEvaluator::evaluate(fullExpr);
     lastResult_ = result;
 
     addToHistory(fullExpr, result);
@@ -172,6 +173,10 @@ CalculatorEngine::getHistory() const {
 
 void CalculatorEngine::clearHistory() { history_.clear(); }
 
+void CalculatorEngine::setResultCache(std::shared_ptr<ResultCache> cache) {
+  cache_ = std::move(cache);
+}
+
 void CalculatorEngine::setError(const std::string &msg) {
   hasError_ = true;
   errorMessage_ = msg;
@@ -1,9 +1,12 @@
 #ifndef CALCULATORENGINE_H
 #define CALCULATORENGINE_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
+class ResultCache;
+
 class CalculatorEngine {
 public:
   CalculatorEngine();
@@ -30,6 +33,16 @@ public:
   std::vector<std::pair<std::string, double>> getHistory() const;
   void clearHistory();
 
+  /**
+   * @brief Memoize calculate() results in `cache`, or stop if null
+   *
+   * The cache may be shared by engines on different threads.
+   */
+  void setResultCache(std::shared_ptr<ResultCache> cache);
+  const std::shared_ptr<ResultCache> &resultCache() const {
+    return cache_;
+  }
+
 private:
   std::string currentInput_;
   std::string currentExpression_;
@@ -38,6 +51,7 @@ private:
   std::string errorMessage_;
   bool justCalculated_;
   std::vector<std::pair<std::string, double>> history_;
+  std::shared_ptr<ResultCache> cache_;
 
   void setError(const std::string &msg);
   void clearError();
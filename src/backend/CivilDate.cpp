@@ -0,0 +1,83 @@
+#include "CivilDate.h"
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+
+namespace {
+
+enum class ParseResult { Ok, BadFormat, BadValues };
+
+bool isSeparator(char c) { return c == '/' || c == '-' || c == '.'; }
+
+// Reads 1..maxDigits digits at text[pos]
+bool readNumber(std::string_view text, size_t &pos, size_t maxDigits,
+                int64_t &value) {
+  size_t start = pos;
+  value = 0;
+  while (pos < text.size() && pos - start < maxDigits && text[pos] >= '0' &&
+         text[pos] <= '9') {
+    value = value * 10 + (text[pos] - '0');
+    ++pos;
+  }
+  return pos > start;
+}
+
+ParseResult parseDate(std::string_view text, CivilDate &date) {
+  size_t pos = 0;
+  while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t'))
+    ++pos;
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t' ||
+                           text.back() == '\r' || text.back() == '\n'))
+    text.remove_suffix(1);
+
+  int64_t day, month, year;
+  if (!readNumber(text, pos, 2, day) || pos == text.size() ||
+      !isSeparator(text[pos++]) || !readNumber(text, pos, 2, month) ||
+      pos == text.size() || !isSeparator(text[pos++]) ||
+      !readNumber(text, pos, 9, year) || pos != text.size())
+    return ParseResult::BadFormat;
+
+  date.year = static_cast<int>(year);
+  date.month = static_cast<unsigned>(month);
+  date.day = static_cast<unsigned>(day);
+  return date.isValid() ? ParseResult::Ok : ParseResult::BadValues;
+}
+
+} // namespace
+
+CivilDate CivilDate::parse(std::string_view text) {
+  CivilDate date;
+  switch (parseDate(text, date)) {
+  case ParseResult::BadFormat:
+    throw std::runtime_error("Invalid date format. Use DD/MM/YYYY");
+  case ParseResult::BadValues:
+    throw std::runtime_error("Invalid date values");
+  default:
+    return date;
+  }
+}
+
+bool CivilDate::tryParse(std::string_view text, CivilDate &date) {
+  return parseDate(text, date) == ParseResult::Ok;
+}
+
+CivilDate CivilDate::today() {
+  std::time_t now = std::time(nullptr);
+  std::tm local = {};
+#ifdef _WIN32
+  localtime_s(&local, &now);
+#else
+  localtime_r(&now, &local);
+#endif
+  CivilDate date;
+  date.year = local.tm_year + 1900;
+  date.month = static_cast<unsigned>(local.tm_mon + 1);
+  date.day = static_cast<unsigned>(local.tm_mday);
+  return date;
+}
+
+std::string CivilDate::toString() const {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%02u/%02u/%d", day, month, year);
+  return buffer;
+}
@@ -0,0 +1,182 @@
+#ifndef CIVILDATE_H
+#define CIVILDATE_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Calendar date in the proleptic Gregorian calendar
+ *
+ * Dates convert to and from a serial day number (days since 1970-01-01)
+ * with Howard Hinnant's days_from_civil / civil_from_days algorithms:
+ * a few integer operations, no time zone, no DST, no libc calls and no
+ * shared state, so everything except parse/today is constexpr and safe
+ * to use from any thread. Years are astronomical (year 0 is 1 BC) and
+ * may be anything that fits an int, so day numbers range from kMinDays
+ * to kMaxDays; the checked functions reject results outside that range.
+ */
+struct CivilDate {
+  // Day numbers of 01/01/INT_MIN and 31/12/INT_MAX
+  static constexpr int64_t kMinDays = -784353015833;
+  static constexpr int64_t kMaxDays = 784351576776;
+
+  int year = 1970;
+  unsigned month = 1; // 1..12
+  unsigned day = 1;   // 1..daysInMonth(year, month)
+
+  static constexpr bool isLeapYear(int year) {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+  }
+
+  static constexpr unsigned daysInMonth(int year, unsigned month) {
+    constexpr unsigned kDays[] = {31, 28, 31, 30, 31, 30,
+                                  31, 31, 30, 31, 30, 31};
+    return month == 2 && isLeapYear(year) ? 29 : kDays[month - 1];
+  }
+
+  constexpr bool isValid() const {
+    return month >= 1 && month <= 12 && day >= 1 &&
+           day <= daysInMonth(year, month);
+  }
+
+  /**
+   * @brief Days since 1970-01-01 (negative before it)
+   */
+  constexpr int64_t toDays() const {
+    // Years start in March so that the leap day ends the year
+    int64_t y = static_cast<int64_t>(year) - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yearOfEra = y - era * 400;
+    int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 +
+                        day - 1;
+    int64_t dayOfEra =
+        yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+  }
+
+  /**
+   * @brief Date `days` days after 1970-01-01
+   *
+   * `days` must lie in [kMinDays, kMaxDays]; fromDaysChecked verifies it.
+   */
+  static constexpr CivilDate fromDays(int64_t days) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 -
+                         dayOfEra / 146096) /
+                        365;
+    int64_t dayOfYear =
+        dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t shiftedMonth = (5 * dayOfYear + 2) / 153; // 0 is March
+    CivilDate date;
+    date.day = static_cast<unsigned>(dayOfYear - (153 * shiftedMonth + 2) / 5 +
+                                     1);
+    date.month = static_cast<unsigned>(
+        shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9);
+    date.year = static_cast<int>(yearOfEra + era * 400 + (date.month <= 2));
+    return date;
+  }
+
+  /**
+   * @throws std::out_of_range if `days` is outside [kMinDays, kMaxDays]
+   */
+  static constexpr CivilDate fromDaysChecked(int64_t days) {
+    if (days < kMinDays || days > kMaxDays)
+      throw std::out_of_range("Date out of range");
+    return fromDays(days);
+  }
+
+  /**
+   * @brief Unchecked: the result's year must fit an int
+   */
+  constexpr CivilDate addDays(int64_t days) const {
+    return fromDays(toDays() + days);
+  }
+
+  /**
+   * @brief addDays() without exceptions or overflow
+   * @return false if the result's year does not fit an int; `result` is
+   *         then unset
+   */
+  constexpr bool tryAddDays(int64_t days, CivilDate &result) const {
+    // toDays() is within [kMinDays, kMaxDays], so neither bound overflows
+    int64_t start = toDays();
+    if (days < kMinDays - start || days > kMaxDays - start)
+      return false;
+    result = fromDays(start + days);
+    return true;
+  }
+
+  /**
+   * @throws std::out_of_range if the result's year does not fit an int
+   */
+  constexpr CivilDate addDaysChecked(int64_t days) const {
+    CivilDate result;
+    if (!tryAddDays(days, result))
+      throw std::out_of_range("Date out of range");
+    return result;
+  }
+
+  /**
+   * @brief Days from `from` to `to`; negative if `to` is earlier
+   */
+  static constexpr int64_t difference(const CivilDate &from,
+                                      const CivilDate &to) {
+    return to.toDays() - from.toDays();
+  }
+
+  /**
+   * @brief ISO weekday: 1 is Monday, 7 is Sunday
+   */
+  constexpr unsigned weekday() const {
+    int64_t days = toDays();
+    // 1970-01-01 was a Thursday
+    int64_t fromMonday = (days % 7 + 7 + 3) % 7;
+    return static_cast<unsigned>(fromMonday + 1);
+  }
+
+  /**
+   * @brief Parse DD/MM/YYYY; '-' or '.' may separate the fields too
+   * @throws std::runtime_error for malformed text or a day that does
+   *         not exist
+   */
+  static CivilDate parse(std::string_view text);
+
+  /**
+   * @brief parse() without exceptions
+   * @return false if the text is not a valid date; `date` is then unset
+   */
+  static bool tryParse(std::string_view text, CivilDate &date);
+
+  /**
+   * @brief Today in the local time zone
+   */
+  static CivilDate today();
+
+  /**
+   * @brief DD/MM/YYYY
+   */
+  std::string toString() const;
+
+  friend constexpr bool operator==(const CivilDate &a, const CivilDate &b) {
+    return a.year == b.year && a.month == b.month && a.day == b.day;
+  }
+  friend constexpr bool operator!=(const CivilDate &a, const CivilDate &b) {
+    return !(a == b);
+  }
+  friend constexpr bool operator<(const CivilDate &a, const CivilDate &b) {
+    if (a.year != b.year)
+      return a.year < b.year;
+    if (a.month != b.month)
+      return a.month < b.month;
+    return a.day < b.day;
+  }
+  friend constexpr bool operator<=(const CivilDate &a, const CivilDate &b) {
+    return !(b < a);
+  }
+};
+
+#endif // CIVILDATE_H
@@ -0,0 +1,340 @@
+#include "CompiledExpression.h"
+#include "MathUtils.h"
+#include "ResultCache.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+// Same special cases as MathUtils::my_pow (0^y is 0, x^0 is 1) but exact
+// square-and-multiply instead of exp/log
+double powInt(double base, int32_t exponent) {
+  if (base == 0)
+    return 0;
+  uint32_t n = exponent < 0 ? 0u - static_cast<uint32_t>(exponent)
+                            : static_cast<uint32_t>(exponent);
+  double result = 1;
+  for (; n != 0; n >>= 1) {
+    if (n & 1)
+      result *= base;
+    base *= base;
+  }
+  return exponent < 0 ? 1 / result : result;
+}
+} // namespace
+
+double CompiledExpression::evaluate() const {
+  if (!variables_.empty())
+    throw std::runtime_error("Unknown variable: " + variables_.front());
+  return evaluate(nullptr);
+}
+
+double CompiledExpression::evaluate(const double *variables) const {
+  if (code_.empty())
+    throw std::runtime_error("Invalid expression");
+  if (maxStackDepth_ + tempCount_ <= kInlineStackSize) {
+    double stack[kInlineStackSize];
+    return run(stack, variables);
+  }
+  std::vector<double> stack(maxStackDepth_ + tempCount_);
+  return run(stack.data(), variables);
+}
+
+double CompiledExpression::evaluate(const std::vector<double> &variables) const {
+  if (variables.size() != variables_.size())
+    throw std::invalid_argument("Variable count mismatch");
+  return evaluate(variables.data());
+}
+
+double CompiledExpression::evaluate(const double *variables,
+                                    ResultCache &cache) const {
+  // Reused per thread so hits do not allocate
+  thread_local std::string key;
+  ResultCache::treeKey(*this, variables, key);
+  if (auto cached = cache.lookup(key))
+    return *cached;
+  double result = evaluate(variables);
+  cache.insert(key, result);
+  return result;
+}
+
+void CompiledExpression::evaluateBatch(const double *const *columns,
+                                       size_t rows, double *out) const {
+  if (code_.empty())
+    throw std::runtime_error("Invalid expression");
+  if (rows == 0)
+    return;
+
+  // One block-sized slice per stack slot, allocated once per call
+  std::vector<double> stack((maxStackDepth_ + tempCount_) * kBatchBlockSize);
+
+  for (size_t first = 0; first < rows; first += kBatchBlockSize) {
+    size_t count = std::min(kBatchBlockSize, rows - first);
+    runBlock(stack.data(), columns, first, count);
+    std::memcpy(out + first, stack.data(), count * sizeof(double));
+  }
+}
+
+double CompiledExpression::apply(OpCode op, double lhs, double rhs,
+                                 uint32_t operand) {
+  switch (op) {
+  case OpCode::Add:
+    return lhs + rhs;
+  case OpCode::Sub:
+    return lhs - rhs;
+  case OpCode::Mul:
+    return lhs * rhs;
+  case OpCode::Div:
+    if (rhs == 0)
+      throw std::runtime_error("Division by zero");
+    return lhs / rhs;
+  case OpCode::Pow:
+    return MathUtils::my_pow(lhs, rhs);
+  case OpCode::PowInt:
+    return powInt(lhs, static_cast<int32_t>(operand));
+  case OpCode::Sqrt:
+    return MathUtils::my_sqrt(lhs);
+  case OpCode::Sin:
+    return MathUtils::my_sin(MathUtils::to_radians(lhs));
+  case OpCode::Cos:
+    return MathUtils::my_cos(MathUtils::to_radians(lhs));
+  case OpCode::Tan:
+    return MathUtils::my_tan(MathUtils::to_radians(lhs));
+  case OpCode::Log:
+    return MathUtils::my_log(lhs);
+  case OpCode::Exp:
+    return MathUtils::my_exp(lhs);
+  default:
+    throw std::logic_error("Opcode has no arithmetic result");
+  }
+}
+
+size_t CompiledExpression::variableIndex(const std::string &name) const {
+  auto it = std::find(variables_.begin(), variables_.end(), name);
+  return it == variables_.end() ? npos : it - variables_.begin();
+}
+
+void CompiledExpression::clear() {
+  code_.clear();
+  constants_.clear();
+  variables_.clear();
+  maxStackDepth_ = 0;
+  tempCount_ = 0;
+}
+
+double CompiledExpression::run(double *stack, const double *variables) const {
+  // Stack balance is validated by ExpressionEvaluator::compile, so the
+  // loop does no bounds checking.
+  double *top = stack - 1;
+  double *temps = stack + maxStackDepth_;
+
+  for (const auto &ins : code_) {
+    switch (ins.op) {
+    case OpCode::PushConst:
+      *++top = constants_[ins.operand];
+      break;
+    case OpCode::LoadVar:
+      *++top = variables[ins.operand];
+      break;
+    case OpCode::Add:
+      top[-1] += top[0];
+      --top;
+      break;
+    case OpCode::Sub:
+      top[-1] -= top[0];
+      --top;
+      break;
+    case OpCode::Mul:
+      top[-1] *= top[0];
+      --top;
+      break;
+    case OpCode::Div:
+      if (top[0] == 0)
+        throw std::runtime_error("Division by zero");
+      top[-1] /= top[0];
+      --top;
+      break;
+    case OpCode::Pow:
+      top[-1] = MathUtils::my_pow(top[-1], top[0]);
+      --top;
+      break;
+    case OpCode::Sqrt:
+      *top = MathUtils::my_sqrt(*top);
+      break;
+    case OpCode::Sin:
+      // Convert degrees to radians for user convenience
+      *top = MathUtils::my_sin(MathUtils::to_radians(*top));
+      break;
+    case OpCode::Cos:
+      *top = MathUtils::my_cos(MathUtils::to_radians(*top));
+      break;
+    case OpCode::Tan:
+      *top = MathUtils::my_tan(MathUtils::to_radians(*top));
+      break;
+    case OpCode::Log:
+      *top = MathUtils::my_log(*top);
+      break;
+    case OpCode::Exp:
+      *top = MathUtils::my_exp(*top);
+      break;
+    case OpCode::Dup:
+      top[1] = top[0];
+      ++top;
+      break;
+    case OpCode::PowInt:
+      *top = powInt(*top, static_cast<int32_t>(ins.operand));
+      break;
+    case OpCode::Store:
+      temps[ins.operand] = *top;
+      break;
+    case OpCode::LoadTemp:
+      *++top = temps[ins.operand];
+      break;
+    }
+  }
+
+  return *top;
+}
+
+void CompiledExpression::runBlock(double *stack, const double *const *columns,
+                                  size_t first, size_t count) const {
+  // Same program as run(), but every stack slot holds a whole block of
+  // rows and each opcode is a flat loop the compiler can vectorize.
+  const size_t n = count;
+  double *top = stack - kBatchBlockSize;
+  double *temps = stack + maxStackDepth_ * kBatchBlockSize;
+
+  for (const auto &ins : code_) {
+    double *a = top - kBatchBlockSize;
+    switch (ins.op) {
+    case OpCode::PushConst: {
+      top += kBatchBlockSize;
+      std::fill(top, top + n, constants_[ins.operand]);
+      break;
+    }
+    case OpCode::LoadVar:
+      top += kBatchBlockSize;
+      std::memcpy(top, columns[ins.operand] + first, n * sizeof(double));
+      break;
+    case OpCode::Add:
+      for (size_t i = 0; i < n; ++i)
+        a[i] += top[i];
+      top = a;
+      break;
+    case OpCode::Sub:
+      for (size_t i = 0; i < n; ++i)
+        a[i] -= top[i];
+      top = a;
+      break;
+    case OpCode::Mul:
+      for (size_t i = 0; i < n; ++i)
+        a[i] *= top[i];
+      top = a;
+      break;
+    case OpCode::Div:
+      for (size_t i = 0; i < n; ++i) {
+        if (top[i] == 0)
+          throw std::runtime_error("Division by zero");
+      }
+      for (size_t i = 0; i < n; ++i)
+        a[i] /= top[i];
+      top = a;
+      break;
+    case OpCode::Pow: {
+      bool positiveBases = true;
+      for (size_t i = 0; i < n; ++i)
+        positiveBases &= a[i] > 0;
+      if (positiveBases) {
+        // a^b = e^(b * ln a), same identity as my_pow but vectorized
+        MathUtils::log(a, a, n);
+        for (size_t i = 0; i < n; ++i)
+          a[i] *= top[i];
+        MathUtils::exp(a, a, n);
+      } else {
+        for (size_t i = 0; i < n; ++i)
+          a[i] = MathUtils::my_pow(a[i], top[i]);
+      }
+      top = a;
+      break;
+    }
+    case OpCode::Sqrt:
+      for (size_t i = 0; i < n; ++i) {
+        if (top[i] < 0)
+          throw std::invalid_argument("Square root of negative number");
+      }
+      MathUtils::sqrt(top, top, n);
+      break;
+    case OpCode::Sin:
+      for (size_t i = 0; i < n; ++i)
+        top[i] = MathUtils::to_radians(top[i]);
+      MathUtils::sin(top, top, n);
+      break;
+    case OpCode::Cos:
+      for (size_t i = 0; i < n; ++i)
+        top[i] = MathUtils::to_radians(top[i]);
+      MathUtils::cos(top, top, n);
+      break;
+    case OpCode::Tan: {
+      double cosines[kBatchBlockSize];
+      for (size_t i = 0; i < n; ++i)
+        top[i] = MathUtils::to_radians(top[i]);
+      MathUtils::cos(top, cosines, n);
+      for (size_t i = 0; i < n; ++i) {
+        if (MathUtils::my_abs(cosines[i]) < 1e-10)
+          throw std::invalid_argument("Tangent undefined");
+      }
+      MathUtils::sin(top, top, n);
+      for (size_t i = 0; i < n; ++i)
+        top[i] /= cosines[i];
+      break;
+    }
+    case OpCode::Log:
+      for (size_t i = 0; i < n; ++i) {
+        if (top[i] <= 0)
+          throw std::invalid_argument("Logarithm of non-positive number");
+      }
+      MathUtils::log(top, top, n);
+      break;
+    case OpCode::Exp:
+      MathUtils::exp(top, top, n);
+      break;
+    case OpCode::Dup:
+      std::memcpy(top + kBatchBlockSize, top, n * sizeof(double));
+      top += kBatchBlockSize;
+      break;
+    case OpCode::PowInt: {
+      // powInt() with the exponent bits as the outer loop, so each step
+      // is a flat multiply over the block
+      const auto exponent = static_cast<int32_t>(ins.operand);
+      uint32_t bits = exponent < 0 ? 0u - static_cast<uint32_t>(exponent)
+                                   : static_cast<uint32_t>(exponent);
+      double bases[kBatchBlockSize];
+      double result[kBatchBlockSize];
+      std::memcpy(bases, top, n * sizeof(double));
+      std::fill(result, result + n, 1.0);
+      for (; bits != 0; bits >>= 1) {
+        if (bits & 1) {
+          for (size_t i = 0; i < n; ++i)
+            result[i] *= bases[i];
+        }
+        for (size_t i = 0; i < n; ++i)
+          bases[i] *= bases[i];
+      }
+      for (size_t i = 0; i < n; ++i) {
+        double value = exponent < 0 ? 1 / result[i] : result[i];
+        top[i] = top[i] == 0 ? 0 : value;
+      }
+      break;
+    }
+    case OpCode::Store:
+      std::memcpy(temps + ins.operand * kBatchBlockSize, top,
+                  n * sizeof(double));
+      break;
+    case OpCode::LoadTemp:
+      top += kBatchBlockSize;
+      std::memcpy(top, temps + ins.operand * kBatchBlockSize,
+                  n * sizeof(double));
+      break;
+    }
+  }
+}
@@ -0,0 +1,141 @@
+#ifndef COMPILEDEXPRESSION_H
+#define COMPILEDEXPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ResultCache;
+
+/**
+ * @brief Expression parsed once into compact bytecode
+ *
+ * Produced by ExpressionEvaluator::compile(). Literals are stored in a
+ * constant pool and operators/functions are encoded as opcodes, so the
+ * expression can be evaluated many times without touching strings.
+ *
+ * The bytecode is simplified by ExpressionOptimizer before use: constant
+ * subexpressions are precomputed, identities removed, integer powers
+ * turned into multiplications and repeated subexpressions computed once.
+ *
+ * Identifiers that are not function names (x, y, rate, ...) become
+ * variables. They are numbered in order of first appearance and bound at
+ * evaluation time, either per call or column-wise for bulk evaluation.
+ */
+class CompiledExpression {
+public:
+  enum class OpCode : uint8_t {
+    PushConst,
+    LoadVar,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+    Sqrt,
+    Sin,
+    Cos,
+    Tan,
+    Log,
+    Exp,
+    // Emitted only by ExpressionOptimizer
+    Dup,      // push a copy of the top
+    PowInt,   // top ^ operand (a signed exponent), by repeated multiply
+    Store,    // copy the top into temporary `operand`
+    LoadTemp  // push temporary `operand`
+  };
+
+  struct Instruction {
+    OpCode op;
+    // Constant pool index for PushConst, variable slot for LoadVar,
+    // exponent for PowInt, temporary for Store/LoadTemp
+    uint32_t operand;
+  };
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /**
+   * @brief Evaluate an expression without variables
+   * @throws std::runtime_error on division by zero or if the expression
+   *         references variables
+   * @throws std::invalid_argument on domain errors from MathUtils
+   */
+  double evaluate() const;
+
+  /**
+   * @brief Evaluate with variables bound by slot
+   * @param variables One value per entry of variables(), in the same order
+   */
+  double evaluate(const double *variables) const;
+  double evaluate(const std::vector<double> &variables) const;
+
+  /**
+   * @brief Evaluate through a result cache
+   *
+   * Keyed on the bytecode plus the variable values (see
+   * ResultCache::treeKey), so only a miss runs the code.
+   */
+  double evaluate(const double *variables, ResultCache &cache) const;
+
+  /**
+   * @brief Evaluate over many rows of struct-of-arrays input
+   * @param columns columns[i] points to `rows` values of variables()[i]
+   * @param rows Number of rows
+   * @param out Receives `rows` results
+   *
+   * Rows are processed in blocks, each opcode running as a tight loop
+   * over the whole block instead of once per row. Functions use the
+   * vectorized MathUtils batch kernels.
+   * @throws std::runtime_error if any row divides by zero
+   * @throws std::invalid_argument if any row hits a domain error
+   */
+  void evaluateBatch(const double *const *columns, size_t rows,
+                     double *out) const;
+
+  /**
+   * @brief Result of one arithmetic opcode, as evaluation computes it
+   * @param lhs The operand of unary opcodes, the left one of binary ones
+   * @param operand Exponent for PowInt
+   * @throws std::runtime_error on division by zero
+   * @throws std::invalid_argument on domain errors from MathUtils
+   * @throws std::logic_error for stack and load opcodes
+   */
+  static double apply(OpCode op, double lhs, double rhs = 0,
+                      uint32_t operand = 0);
+
+  /**
+   * @brief Slot of a variable name, or npos if not referenced
+   */
+  size_t variableIndex(const std::string &name) const;
+
+  const std::vector<std::string> &variables() const { return variables_; }
+  const std::vector<Instruction> &code() const { return code_; }
+  const std::vector<double> &constants() const { return constants_; }
+  size_t maxStackDepth() const { return maxStackDepth_; }
+  size_t tempCount() const { return tempCount_; }
+  bool empty() const { return code_.empty(); }
+
+private:
+  friend class ExpressionEvaluator;
+  friend class ExpressionOptimizer;
+
+  // Expressions deeper than this fall back to a heap-allocated stack
+  static constexpr size_t kInlineStackSize = 64;
+  // Rows per block in evaluateBatch
+  static constexpr size_t kBatchBlockSize = 256;
+
+  std::vector<Instruction> code_;
+  std::vector<double> constants_;
+  std::vector<std::string> variables_;
+  size_t maxStackDepth_ = 0;
+  // Temporaries live in the evaluation stack buffer, after the stack
+  size_t tempCount_ = 0;
+
+  void clear();
+  double run(double *stack, const double *variables) const;
+  void runBlock(double *stack, const double *const *columns, size_t first,
+                size_t count) const;
+};
+
+#endif
@@ -1,159 +1,499 @@
 #include "ExpressionEvaluator.h"
-#include "MathUtils.h"
+#include "ExpressionOptimizer.h"
 #include <algorithm>
 #include <cctype>
-#include <sstream>
+#include <cerrno>
+#include <cstdlib>
 #include <stdexcept>
+#include <vector>
+
+namespace {
+// Names and numbers may contain spaces ("1 2" is 12); drop them
+std::string compact(std::string_view text) {
+  std::string result;
+  for (char c : text) {
+    if (!std::isspace(static_cast<unsigned char>(c)))
+      result += c;
+  }
+  return result;
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Powers of ten that are exact doubles
+constexpr double kExactPowersOf10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// std::stod semantics: longest valid prefix, out_of_range on overflow or
+// underflow. Only reached for rare input, so it may allocate.
+double parseNumberSlow(std::string_view text) {
+  std::string digits = compact(text);
+  char *end = nullptr;
+  errno = 0;
+  double value = std::strtod(digits.c_str(), &end);
+  if (end == digits.c_str())
+    throw std::invalid_argument("stod");
+  if (errno == ERANGE)
+    throw std::out_of_range("stod");
+  return value;
+}
+
+// Trig functions take degrees. The angle is reduced exactly to [0, 360),
+// so multiples of 90 degrees give exact results.
+BigFloat trigDegrees(CompiledExpression::OpCode op, const BigFloat &degrees,
+                     size_t digits) {
+  using OpCode = CompiledExpression::OpCode;
+  const BigFloat angle = BigFloat::mod(degrees, 360);
+  if (BigFloat::mod(angle, 90).isZero()) {
+    static const int kSin[] = {0, 1, 0, -1};
+    const int quadrant = static_cast<int>(angle.toDouble()) / 90;
+    const int sine = kSin[quadrant], cosine = kSin[(quadrant + 1) % 4];
+    if (op == OpCode::Sin)
+      return sine;
+    if (op == OpCode::Cos)
+      return cosine;
+    // Same error as MathUtils::my_tan
+    if (cosine == 0)
+      throw std::invalid_argument("Tangent undefined");
+    return sine * cosine;
+  }
+
+  const size_t work = digits + 5;
+  const BigFloat radians =
+      BigFloat::div(BigFloat::mul(angle, BigFloat::pi(work), work), 180, work);
+  if (op == OpCode::Sin)
+    return BigFloat::sin(radians, digits);
+  if (op == OpCode::Cos)
+    return BigFloat::cos(radians, digits);
+  return BigFloat::tan(radians, digits);
+}
+
+BigFloat applyPrecise(CompiledExpression::OpCode op, const BigFloat &lhs,
+                      const BigFloat &rhs, size_t digits) {
+  using OpCode = CompiledExpression::OpCode;
+  switch (op) {
+  case OpCode::Add:
+    return BigFloat::add(lhs, rhs, digits);
+  case OpCode::Sub:
+    return BigFloat::sub(lhs, rhs, digits);
+  case OpCode::Mul:
+    return BigFloat::mul(lhs, rhs, digits);
+  case OpCode::Div:
+    return BigFloat::div(lhs, rhs, digits);
+  case OpCode::Pow:
+    return BigFloat::pow(lhs, rhs, digits);
+  case OpCode::Sqrt:
+    return BigFloat::sqrt(lhs, digits);
+  case OpCode::Sin:
+  case OpCode::Cos:
+  case OpCode::Tan:
+    return trigDegrees(op, lhs, digits);
+  case OpCode::Log:
+    return BigFloat::log(lhs, digits);
+  case OpCode::Exp:
+    return BigFloat::exp(lhs, digits);
+  default:
+    throw std::logic_error("Opcode has no arithmetic result");
+  }
+}
+} // namespace
 
 double ExpressionEvaluator::evaluate(const std::string &expression) {
-  auto tokens = tokenize(expression);
-  auto rpn = toRPN(tokens);
+  TokenList tokens, rpn;
+  tokenize(expression, tokens);
+  toRPN(tokens, rpn);
+  checkStackDepth(rpn);
+  for (const Token &token : rpn) {
+    if (token.kind == Token::Kind::Variable)
+      throw std::runtime_error("Unknown variable: " + compact(token.text));
+  }
   return evaluateRPN(rpn);
 }
 
-std::vector<std::string>
-ExpressionEvaluator::tokenize(const std::string &expr) {
-  std::vector<std::string> tokens;
-  std::string current;
+double ExpressionEvaluator::evaluate(const std::string &expression,
+                                     ResultCache &cache) {
+  // Reused per thread so hits do not allocate
+  thread_local std::string key;
+  ResultCache::normalize(expression, key);
+  if (auto cached = cache.lookup(key))
+    return *cached;
+  double result = evaluate(expression);
+  cache.insert(key, result);
+  return result;
+}
+
+BigFloat ExpressionEvaluator::evaluatePrecise(const std::string &expression,
+                                              size_t digits) {
+  TokenList tokens, rpn;
+  tokenize(expression, tokens);
+  toRPN(tokens, rpn);
+  // Numbers beyond double range are fine here
+  for (Token &token : rpn)
+    token.outOfRange = false;
+  checkStackDepth(rpn);
+  for (const Token &token : rpn) {
+    if (token.kind == Token::Kind::Variable)
+      throw std::runtime_error("Unknown variable: " + compact(token.text));
+  }
+
+  std::vector<BigFloat> stack;
+  stack.reserve(rpn.size());
+  for (const Token &token : rpn) {
+    switch (token.kind) {
+    case Token::Kind::Number:
+      stack.push_back(parsePrecise(token));
+      break;
+    case Token::Kind::Function:
+      stack.back() = applyPrecise(token.op, stack.back(), {}, digits);
+      break;
+    case Token::Kind::Operator: {
+      BigFloat rhs = std::move(stack.back());
+      stack.pop_back();
+      stack.back() = applyPrecise(token.op, stack.back(), rhs, digits);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return stack.back();
+}
+
+CompiledExpression ExpressionEvaluator::compile(const std::string &expression) {
+  CompiledExpression compiled;
+  compile(expression, compiled);
+  return compiled;
+}
+
+void ExpressionEvaluator::compile(const std::string &expression,
+                                  CompiledExpression &out) {
+  TokenList tokens, rpn;
+  tokenize(expression, tokens);
+  toRPN(tokens, rpn);
+  emitBytecode(rpn, out);
+  ExpressionOptimizer::optimize(out);
+}
+
+void ExpressionEvaluator::tokenize(std::string_view expr, TokenList &tokens) {
+  // Current name or number: expr[start, end), possibly with spaces inside
+  size_t start = std::string_view::npos;
+  size_t end = 0;
+  bool spaced = false;
+  auto flush = [&]() {
+    if (start != std::string_view::npos) {
+      tokens.push_back(classifyWord(expr.substr(start, end - start), spaced));
+      start = std::string_view::npos;
+    }
+  };
 
-  for (size_t i = 0; i < expr.length(); ++i) {
-    char c = expr[i];
+  for (size_t i = 0; i < expr.size(); ++i) {
+    auto c = static_cast<unsigned char>(expr[i]);
 
     if (std::isspace(c))
       continue;
 
-    if (std::isdigit(c) || c == '.') {
-      current += c;
-    } else if (std::isalpha(c)) {
-      current += c;
-    } else {
-      if (!current.empty()) {
-        tokens.push_back(current);
-        current.clear();
+    if (std::isalnum(c) || c == '.' || c == '_') {
+      if (start == std::string_view::npos) {
+        start = i;
+        spaced = false;
+      } else if (i != end) {
+        spaced = true;
       }
-      tokens.push_back(std::string(1, c));
+      end = i + 1;
+      continue;
+    }
+
+    flush();
+    Token token{};
+    token.kind = Token::Kind::Operator;
+    switch (c) {
+    case '(':
+      token.kind = Token::Kind::LeftParen;
+      break;
+    case ')':
+      token.kind = Token::Kind::RightParen;
+      break;
+    case '+':
+      token.op = OpCode::Add;
+      break;
+    case '-':
+      token.op = OpCode::Sub;
+      break;
+    case '*':
+      token.op = OpCode::Mul;
+      break;
+    case '/':
+      token.op = OpCode::Div;
+      break;
+    case '^':
+      token.op = OpCode::Pow;
+      break;
+    default:
+      token.kind = Token::Kind::Other;
+    }
+    tokens.push_back(token);
+  }
+  flush();
+}
+
+ExpressionEvaluator::Token
+ExpressionEvaluator::classifyWord(std::string_view text, bool spaced) {
+  Token token{};
+  token.spaced = spaced;
+  token.text = text;
+
+  if (isDigit(text[0])) {
+    token.kind = Token::Kind::Number;
+    try {
+      token.value = parseNumber(text, spaced);
+    } catch (const std::out_of_range &) {
+      token.outOfRange = true;
+    }
+    return token;
+  }
+
+  // Function names are at most four letters; compare without spaces
+  char name[5] = {};
+  size_t length = 0;
+  for (char c : text) {
+    if (std::isspace(static_cast<unsigned char>(c)))
+      continue;
+    if (length == 4) {
+      length = 0;
+      break;
     }
+    name[length++] = c;
   }
+  static constexpr struct {
+    std::string_view name;
+    OpCode op;
+  } kFunctions[] = {{"sqrt", OpCode::Sqrt}, {"sin", OpCode::Sin},
+                    {"cos", OpCode::Cos},   {"tan", OpCode::Tan},
+                    {"log", OpCode::Log},   {"exp", OpCode::Exp}};
+  for (const auto &function : kFunctions) {
+    if (function.name == std::string_view(name, length)) {
+      token.kind = Token::Kind::Function;
+      token.op = function.op;
+      return token;
+    }
+  }
+
+  token.kind = std::isalpha(static_cast<unsigned char>(text[0])) ||
+                       text[0] == '_'
+                   ? Token::Kind::Variable
+                   : Token::Kind::Other;
+  return token;
+}
 
-  if (!current.empty()) {
-    tokens.push_back(current);
+double ExpressionEvaluator::parseNumber(std::string_view text, bool spaced) {
+  // Hexadecimal and spaced numbers are rare; let strtod handle them
+  if (spaced || (text.size() > 1 && text[0] == '0' &&
+                 (text[1] == 'x' || text[1] == 'X')))
+    return parseNumberSlow(text);
+
+  // Clinger's fast path: with at most 2^53 as the digits and a power of
+  // ten up to 1e22, both are exact doubles and one multiplication or
+  // division rounds correctly, giving the same result as strtod
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  size_t i = 0;
+  for (; i < text.size() && isDigit(text[i]); ++i) {
+    if (mantissa != 0 || text[i] != '0')
+      ++digits;
+    mantissa = mantissa * 10 + (text[i] - '0');
+    if (digits > 19)
+      return parseNumberSlow(text);
+  }
+  if (i < text.size() && text[i] == '.') {
+    for (++i; i < text.size() && isDigit(text[i]); ++i) {
+      if (mantissa != 0 || text[i] != '0')
+        ++digits;
+      mantissa = mantissa * 10 + (text[i] - '0');
+      --exponent;
+      if (digits > 19)
+        return parseNumberSlow(text);
+    }
+  }
+  // Like strtod, an 'e' without digits after it is not part of the number
+  if (i + 1 < text.size() && (text[i] == 'e' || text[i] == 'E') &&
+      isDigit(text[i + 1])) {
+    int power = 0;
+    for (++i; i < text.size() && isDigit(text[i]); ++i) {
+      power = power * 10 + (text[i] - '0');
+      if (power > 1000)
+        return parseNumberSlow(text);
+    }
+    exponent += power;
   }
 
-  return tokens;
+  if (mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+    return parseNumberSlow(text);
+  double value = static_cast<double>(mantissa);
+  return exponent < 0 ? value / kExactPowersOf10[-exponent]
+                      : value * kExactPowersOf10[exponent];
 }
 
-std::vector<std::string>
-ExpressionEvaluator::toRPN(const std::vector<std::string> &tokens) {
-  std::vector<std::string> output;
-  std::stack<std::string> operators;
+void ExpressionEvaluator::toRPN(const TokenList &tokens, TokenList &rpn) {
+  using Kind = Token::Kind;
+  SmallVector<Token, 32> operators;
 
-  for (const auto &token : tokens) {
-    if (std::isdigit(token[0]) ||
-        (token.length() > 1 && token[0] == '-' && std::isdigit(token[1]))) {
-      output.push_back(token);
-    } else if (isFunction(token)) {
-      operators.push(token);
-    } else if (token == "(") {
-      operators.push(token);
-    } else if (token == ")") {
-      while (!operators.empty() && operators.top() != "(") {
-        output.push_back(operators.top());
-        operators.pop();
+  for (const Token &token : tokens) {
+    switch (token.kind) {
+    case Kind::Number:
+    case Kind::Variable:
+      rpn.push_back(token);
+      break;
+    case Kind::Function:
+    case Kind::LeftParen:
+      operators.push_back(token);
+      break;
+    case Kind::RightParen:
+      while (!operators.empty() && operators.back().kind != Kind::LeftParen) {
+        rpn.push_back(operators.back());
+        operators.pop_back();
       }
       if (!operators.empty())
-        operators.pop();
-      if (!operators.empty() && isFunction(operators.top())) {
-        output.push_back(operators.top());
-        operators.pop();
+        operators.pop_back();
+      if (!operators.empty() && operators.back().kind == Kind::Function) {
+        rpn.push_back(operators.back());
+        operators.pop_back();
       }
-    } else if (isOperator(token)) {
-      while (!operators.empty() && operators.top() != "(" &&
-             precedence(operators.top()) >= precedence(token)) {
-        output.push_back(operators.top());
-        operators.pop();
+      break;
+    case Kind::Operator:
+      while (!operators.empty() && operators.back().kind != Kind::LeftParen &&
+             precedence(operators.back()) >= precedence(token)) {
+        rpn.push_back(operators.back());
+        operators.pop_back();
       }
-      operators.push(token);
+      operators.push_back(token);
+      break;
+    case Kind::Other:
+      break;
     }
   }
 
   while (!operators.empty()) {
-    output.push_back(operators.top());
-    operators.pop();
+    rpn.push_back(operators.back());
+    operators.pop_back();
   }
-
-  return output;
 }
 
-double ExpressionEvaluator::evaluateRPN(const std::vector<std::string> &rpn) {
-  std::stack<double> values;
-
-  for (const auto &token : rpn) {
-    if (std::isdigit(token[0]) ||
-        (token.length() > 1 && token[0] == '-' && std::isdigit(token[1]))) {
-      values.push(std::stod(token));
-    } else if (isFunction(token)) {
-      if (values.empty())
+void ExpressionEvaluator::checkStackDepth(const TokenList &rpn) {
+  size_t depth = 0;
+  for (const Token &token : rpn) {
+    switch (token.kind) {
+    case Token::Kind::Number:
+      if (token.outOfRange)
+        parseNumber(token.text, token.spaced); // throws std::out_of_range
+      ++depth;
+      break;
+    case Token::Kind::Variable:
+      ++depth;
+      break;
+    case Token::Kind::Function:
+      if (depth < 1)
         throw std::runtime_error("Invalid expression");
-      double val = values.top();
-      values.pop();
-
-      if (token == "sqrt")
-        values.push(MathUtils::my_sqrt(val));
-      else if (token == "sin")
-        // Convert degrees to radians for user convenience
-        values.push(MathUtils::my_sin(MathUtils::to_radians(val)));
-      else if (token == "cos")
-        values.push(MathUtils::my_cos(MathUtils::to_radians(val)));
-      else if (token == "tan")
-        values.push(MathUtils::my_tan(MathUtils::to_radians(val)));
-      else if (token == "log")
-        values.push(MathUtils::my_log(val));
-      else if (token == "exp")
-        values.push(MathUtils::my_exp(val));
-    } else if (isOperator(token)) {
-      if (values.size() < 2)
+      break;
+    case Token::Kind::Operator:
+      if (depth < 2)
         throw std::runtime_error("Invalid expression");
-      double b = values.top();
-      values.pop();
-      double a = values.top();
-      values.pop();
-
-      if (token == "+")
-        values.push(a + b);
-      else if (token == "-")
-        values.push(a - b);
-      else if (token == "*")
-        values.push(a * b);
-      else if (token == "/") {
-        if (b == 0)
-          throw std::runtime_error("Division by zero");
-        values.push(a / b);
-      } else if (token == "^")
-        values.push(MathUtils::my_pow(a, b));
-    }
-  }
-
-  if (values.size() != 1)
+      --depth;
+      break;
+    default:
+      break;
+    }
+  }
+  if (depth != 1)
     throw std::runtime_error("Invalid expression");
-  return values.top();
 }
 
-int ExpressionEvaluator::precedence(const std::string &op) {
-  if (op == "+" || op == "-")
-    return 1;
-  if (op == "*" || op == "/")
-    return 2;
-  if (op == "^")
-    return 3;
-  return 0;
+double ExpressionEvaluator::evaluateRPN(const TokenList &rpn) {
+  // Folding every operation as it comes is exactly what compiling and
+  // optimizing would do with an expression of constants
+  SmallVector<double, kInlineTokens> stack;
+  for (const Token &token : rpn) {
+    switch (token.kind) {
+    case Token::Kind::Number:
+      stack.push_back(token.value);
+      break;
+    case Token::Kind::Function:
+      stack.back() = ExpressionOptimizer::fold(token.op, stack.back());
+      break;
+    case Token::Kind::Operator: {
+      double rhs = stack.back();
+      stack.pop_back();
+      stack.back() = ExpressionOptimizer::fold(token.op, stack.back(), rhs);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return stack.back();
+}
+
+BigFloat ExpressionEvaluator::parsePrecise(const Token &token) {
+  try {
+    return BigFloat::parse(compact(token.text));
+  } catch (const std::invalid_argument &) {
+    // Hex and other text std::stod reads a prefix of
+    return BigFloat::fromDouble(parseNumber(token.text, token.spaced));
+  }
 }
 
-bool ExpressionEvaluator::isOperator(const std::string &token) {
-  return token == "+" || token == "-" || token == "*" || token == "/" ||
-         token == "^";
+void ExpressionEvaluator::emitBytecode(const TokenList &rpn,
+                                       CompiledExpression &out) {
+  out.clear();
+  checkStackDepth(rpn);
+  out.code_.reserve(rpn.size());
+
+  size_t depth = 0;
+  for (const Token &token : rpn) {
+    switch (token.kind) {
+    case Token::Kind::Number:
+      out.code_.push_back(
+          {OpCode::PushConst, static_cast<uint32_t>(out.constants_.size())});
+      out.constants_.push_back(token.value);
+      ++depth;
+      break;
+    case Token::Kind::Variable: {
+      std::string name = compact(token.text);
+      size_t slot = out.variableIndex(name);
+      if (slot == CompiledExpression::npos) {
+        slot = out.variables_.size();
+        out.variables_.push_back(std::move(name));
+      }
+      out.code_.push_back({OpCode::LoadVar, static_cast<uint32_t>(slot)});
+      ++depth;
+      break;
+    }
+    case Token::Kind::Function:
+      out.code_.push_back({token.op, 0});
+      break;
+    case Token::Kind::Operator:
+      out.code_.push_back({token.op, 0});
+      --depth;
+      break;
+    default:
+      break;
+    }
+    out.maxStackDepth_ = std::max(out.maxStackDepth_, depth);
+  }
 }
 
-bool ExpressionEvaluator::isFunction(const std::string &token) {
-  return token == "sqrt" || token == "sin" || token == "cos" ||
-         token == "tan" || token == "log" || token == "exp";
+int ExpressionEvaluator::precedence(const Token &token) {
+  if (token.kind != Token::Kind::Operator)
+    return 0;
+  switch (token.op) {
+  case OpCode::Add:
+  case OpCode::Sub:
+    return 1;
+  case OpCode::Mul:
+  case OpCode::Div:
+    return 2;
+  default:
+    return 3;
+  }
 }
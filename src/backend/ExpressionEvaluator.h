@@ -1,21 +1,75 @@
 #ifndef EXPRESSIONEVALUATOR_H
 #define EXPRESSIONEVALUATOR_H
 
-#include <stack>
+#include "BigFloat.h"
+#include "CompiledExpression.h"
+#include "ResultCache.h"
+#include "SmallVector.h"
 #include <string>
-#include <vector>
+#include <string_view>
 
 class ExpressionEvaluator {
 public:
+  // Evaluates straight from the token stream. Expressions of up to
+  // kInlineTokens tokens are parsed and evaluated without heap allocation.
   static double evaluate(const std::string &expression);
+  // Memoized on the expression with whitespace removed; only a cache miss
+  // parses and evaluates
+  static double evaluate(const std::string &expression, ResultCache &cache);
+
+  // Same syntax and functions, in arbitrary precision: every operation is
+  // rounded to at least `digits` significant digits. Numbers are read
+  // exactly, and trig functions of multiples of 90 degrees are exact.
+  static BigFloat evaluatePrecise(const std::string &expression,
+                                  size_t digits);
+
+  // Parse once, evaluate many times via CompiledExpression::evaluate().
+  // Identifiers other than function names compile to variables.
+  static CompiledExpression compile(const std::string &expression);
+  // Same as above but reuses the buffers already owned by `out`
+  static void compile(const std::string &expression, CompiledExpression &out);
 
 private:
-  static std::vector<std::string> tokenize(const std::string &expr);
-  static std::vector<std::string> toRPN(const std::vector<std::string> &tokens);
-  static double evaluateRPN(const std::vector<std::string> &rpn);
-  static int precedence(const std::string &op);
-  static bool isOperator(const std::string &token);
-  static bool isFunction(const std::string &token);
+  using OpCode = CompiledExpression::OpCode;
+
+  /**
+   * @brief One token; names and numbers refer into the source text
+   *
+   * Whitespace does not end a name or number ("1 2" reads as 12, as it
+   * always has), so `spaced` marks text that still contains spaces.
+   */
+  struct Token {
+    enum class Kind : uint8_t {
+      Number,
+      Variable,
+      Function,
+      Operator,
+      LeftParen,
+      RightParen,
+      Other // ignored by the parser
+    };
+
+    Kind kind;
+    bool spaced;
+    // Number out of double range; reported in RPN order like other errors
+    bool outOfRange;
+    OpCode op;             // Function, Operator
+    double value;          // Number
+    std::string_view text; // Number, Variable
+  };
+
+  static constexpr size_t kInlineTokens = 64;
+  using TokenList = SmallVector<Token, kInlineTokens>;
+
+  static void tokenize(std::string_view expr, TokenList &tokens);
+  static void toRPN(const TokenList &tokens, TokenList &rpn);
+  static void checkStackDepth(const TokenList &rpn);
+  static double evaluateRPN(const TokenList &rpn);
+  static void emitBytecode(const TokenList &rpn, CompiledExpression &out);
+  static Token classifyWord(std::string_view text, bool spaced);
+  static double parseNumber(std::string_view text, bool spaced);
+  static BigFloat parsePrecise(const Token &token);
+  static int precedence(const Token &token);
 };
 
 #endif
@@ -0,0 +1,266 @@
+#include "ExpressionOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace {
+using OpCode = CompiledExpression::OpCode;
+
+constexpr int32_t kNone = -1;
+
+struct Node {
+  OpCode op;
+  // Variable slot for LoadVar, exponent bits for PowInt
+  uint32_t operand = 0;
+  // Value for PushConst
+  double value = 0;
+  int32_t left = kNone;
+  int32_t right = kNone;
+};
+
+bool isBinary(OpCode op) {
+  return op == OpCode::Add || op == OpCode::Sub || op == OpCode::Mul ||
+         op == OpCode::Div || op == OpCode::Pow;
+}
+
+uint64_t bitsOf(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+std::optional<int32_t> integerExponent(double value) {
+  if (value != std::trunc(value) ||
+      std::fabs(value) > std::numeric_limits<int32_t>::max())
+    return std::nullopt;
+  return static_cast<int32_t>(value);
+}
+} // namespace
+
+// Expression DAG with hash-consing: building a node equal to an existing
+// one returns the existing id, which is what makes repeated
+// subexpressions shared
+class ExpressionOptimizer::Graph {
+public:
+  std::vector<Node> nodes;
+
+  int32_t constant(double value) {
+    Node node{OpCode::PushConst};
+    node.value = value;
+    return intern(node);
+  }
+
+  int32_t variable(uint32_t slot) {
+    Node node{OpCode::LoadVar};
+    node.operand = slot;
+    return intern(node);
+  }
+
+  int32_t unary(OpCode op, int32_t child, uint32_t operand = 0) {
+    if (nodes[child].op == OpCode::PushConst) {
+      try {
+        return constant(
+            CompiledExpression::apply(op, nodes[child].value, 0, operand));
+      } catch (const std::exception &) {
+        // Left in the code to throw when evaluated
+      }
+    }
+    Node node{op};
+    node.operand = operand;
+    node.left = child;
+    return intern(node);
+  }
+
+  int32_t binary(OpCode op, int32_t left, int32_t right) {
+    if (nodes[left].op == OpCode::PushConst &&
+        nodes[right].op == OpCode::PushConst) {
+      try {
+        return constant(ExpressionOptimizer::fold(op, nodes[left].value,
+                                                  nodes[right].value));
+      } catch (const std::exception &) {
+        // Left in the code to throw when evaluated
+      }
+    }
+
+    if (op == OpCode::Pow && nodes[right].op == OpCode::PushConst) {
+      if (auto exponent = integerExponent(nodes[right].value)) {
+        if (*exponent == 1)
+          return left;
+        if (*exponent == 2)
+          return binary(OpCode::Mul, left, left);
+        return unary(OpCode::PowInt, left, static_cast<uint32_t>(*exponent));
+      }
+    }
+
+    switch (op) {
+    case OpCode::Add:
+      if (isConstant(right, 0))
+        return left;
+      if (isConstant(left, 0))
+        return right;
+      break;
+    case OpCode::Sub:
+      if (isConstant(right, 0))
+        return left;
+      break;
+    case OpCode::Mul:
+      if (isConstant(right, 1))
+        return left;
+      if (isConstant(left, 1))
+        return right;
+      break;
+    case OpCode::Div:
+      if (isConstant(right, 1))
+        return left;
+      break;
+    default:
+      break;
+    }
+
+    Node node{op};
+    node.left = left;
+    node.right = right;
+    return intern(node);
+  }
+
+private:
+  using Key = std::tuple<OpCode, uint32_t, uint64_t, int32_t, int32_t>;
+  std::map<Key, int32_t> ids_;
+
+  int32_t intern(const Node &node) {
+    Key key{node.op, node.operand, bitsOf(node.value), node.left, node.right};
+    auto [it, added] = ids_.emplace(key, static_cast<int32_t>(nodes.size()));
+    if (added)
+      nodes.push_back(node);
+    return it->second;
+  }
+
+  bool isConstant(int32_t id, double value) const {
+    return nodes[id].op == OpCode::PushConst && nodes[id].value == value;
+  }
+
+};
+
+void ExpressionOptimizer::optimize(CompiledExpression &expression) {
+  if (expression.code_.empty())
+    return;
+
+  // Lift the stack code into the DAG, simplifying as nodes are built
+  Graph graph;
+  std::vector<int32_t> stack;
+  for (const auto &ins : expression.code_) {
+    if (ins.op == OpCode::PushConst) {
+      stack.push_back(graph.constant(expression.constants_[ins.operand]));
+    } else if (ins.op == OpCode::LoadVar) {
+      stack.push_back(graph.variable(ins.operand));
+    } else if (isBinary(ins.op)) {
+      int32_t right = stack.back();
+      stack.pop_back();
+      stack.back() = graph.binary(ins.op, stack.back(), right);
+    } else {
+      stack.back() = graph.unary(ins.op, stack.back(), ins.operand);
+    }
+  }
+  const int32_t root = stack.back();
+  const auto &nodes = graph.nodes;
+
+  // Children always have smaller ids than their parents, so one backward
+  // pass counts how many reachable parents use each node. An operation
+  // whose operands are the same node uses it once (via Dup).
+  std::vector<uint32_t> uses(nodes.size(), 0);
+  uses[root] = 1;
+  for (int32_t id = root; id >= 0; --id) {
+    if (uses[id] == 0)
+      continue;
+    const Node &node = nodes[id];
+    if (node.left != kNone)
+      ++uses[node.left];
+    if (node.right != kNone && node.right != node.left)
+      ++uses[node.right];
+  }
+
+  // Emit post-order with an explicit stack; long chains such as
+  // x+x+...+x would overflow a recursive walk
+  std::vector<CompiledExpression::Instruction> code;
+  std::vector<double> constants;
+  std::map<uint64_t, uint32_t> constantSlots;
+  std::vector<int32_t> temps(nodes.size(), kNone);
+  uint32_t tempCount = 0;
+  size_t depth = 0, maxDepth = 0;
+  auto emit = [&](OpCode op, uint32_t operand, int delta) {
+    code.push_back({op, operand});
+    depth += delta;
+    maxDepth = std::max(maxDepth, depth);
+  };
+
+  struct Frame {
+    int32_t id;
+    int stage;
+  };
+  std::vector<Frame> frames{{root, 0}};
+  while (!frames.empty()) {
+    Frame &frame = frames.back();
+    const int32_t id = frame.id;
+    const Node &node = nodes[id];
+
+    if (frame.stage == 0) {
+      if (temps[id] != kNone) {
+        emit(OpCode::LoadTemp, temps[id], 1);
+        frames.pop_back();
+      } else if (node.op == OpCode::PushConst) {
+        auto [it, added] = constantSlots.emplace(
+            bitsOf(node.value), static_cast<uint32_t>(constants.size()));
+        if (added)
+          constants.push_back(node.value);
+        emit(OpCode::PushConst, it->second, 1);
+        frames.pop_back();
+      } else if (node.op == OpCode::LoadVar) {
+        emit(OpCode::LoadVar, node.operand, 1);
+        frames.pop_back();
+      } else {
+        frame.stage = 1;
+        frames.push_back({node.left, 0});
+      }
+      continue;
+    }
+
+    if (frame.stage == 1 && node.right != kNone && node.right != node.left) {
+      frame.stage = 2;
+      frames.push_back({node.right, 0});
+      continue;
+    }
+
+    if (node.right == node.left)
+      emit(OpCode::Dup, 0, 1);
+    emit(node.op, node.operand, node.right != kNone ? -1 : 0);
+    if (uses[id] > 1) {
+      temps[id] = static_cast<int32_t>(tempCount++);
+      emit(OpCode::Store, temps[id], 0);
+    }
+    frames.pop_back();
+  }
+
+  expression.code_ = std::move(code);
+  expression.constants_ = std::move(constants);
+  expression.maxStackDepth_ = maxDepth;
+  expression.tempCount_ = tempCount;
+}
+
+double ExpressionOptimizer::fold(OpCode op, double lhs, double rhs) {
+  if (op == OpCode::Pow) {
+    if (auto exponent = integerExponent(rhs)) {
+      if (*exponent == 1)
+        return lhs;
+      if (*exponent == 2)
+        return lhs * lhs;
+      return CompiledExpression::apply(OpCode::PowInt, lhs, 0,
+                                       static_cast<uint32_t>(*exponent));
+    }
+  }
+  return CompiledExpression::apply(op, lhs, rhs);
+}
@@ -0,0 +1,40 @@
+#ifndef EXPRESSIONOPTIMIZER_H
+#define EXPRESSIONOPTIMIZER_H
+
+#include "CompiledExpression.h"
+
+/**
+ * @brief Rewrites compiled bytecode into an equivalent, cheaper program
+ *
+ * The bytecode is lifted into an expression DAG in which identical
+ * subexpressions are one node, simplified bottom-up, and emitted again:
+ *  - operations on constants are evaluated once at compile time, unless
+ *    they throw, in which case they stay in the code and throw when
+ *    evaluated as before;
+ *  - x*1, 1*x, x/1, x+0, 0+x, x-0 and x^1 become x;
+ *  - x^n with integer n becomes PowInt (repeated multiplication) instead
+ *    of my_pow's exp/log, and x^2 becomes x*x;
+ *  - a subexpression that occurs more than once is evaluated once and
+ *    kept in a temporary (Dup when both operands are the same, Store and
+ *    LoadTemp otherwise).
+ */
+class ExpressionOptimizer {
+public:
+  static void optimize(CompiledExpression &expression);
+
+  /**
+   * @brief Value the optimized code has for an operation on constants
+   *
+   * CompiledExpression::apply, except that integer powers are rewritten
+   * as above first. Evaluating an expression of constants by folding
+   * each operation with this gives the same result as compiling it.
+   * @throws what the operation would throw when evaluated
+   */
+  static double fold(CompiledExpression::OpCode op, double lhs,
+                     double rhs = 0);
+
+private:
+  class Graph;
+};
+
+#endif
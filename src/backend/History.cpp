@@ -1,38 +1,166 @@
 #include "History.h"
-#include <cstdint>
+#include "HistoryJournal.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 
-void History::addEntry(const std::string &operation, double result) {
-  if (currentIndex_ < (int)entries_.size() - 1) {
-    entries_.erase(entries_.begin() + currentIndex_ + 1, entries_.end());
+namespace {
+// Compact once the journal holds this many more records than a fresh
+// rewrite would (one per entry plus the cursor)
+constexpr size_t kCompactionSlack = 4096;
+
+constexpr char kHistoryMagic[4] = {'H', 'I', 'S', 'T'};
+
+struct BinaryHeaderV2 {
+  char magic[4];
+  uint32_t version;
+  uint64_t count;
+  int64_t currentIndex;
+  uint64_t stringBytes;
+};
+static_assert(sizeof(BinaryHeaderV2) == 32, "v2 header must be packed");
+
+// display() and save() format into a buffer and write it in blocks
+constexpr size_t kOutputChunk = 64 << 10;
+
+// Same text as `stream << value` with default stream settings
+void appendNumber(std::string &out, double value) {
+  char buffer[32];
+  int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+  out.append(buffer, length);
+}
+} // namespace
+
+History::History() = default;
+History::~History() = default;
+History::History(History &&) noexcept = default;
+History &History::operator=(History &&) noexcept = default;
+
+void History::appendEntry(std::string_view operation, double result) {
+  // Adding after an undo discards the redo branch
+  if (currentIndex_ < (int)size() - 1) {
+    truncate(currentIndex_ + 1);
+  }
+
+  pushEntry(operation, result);
+  currentIndex_ = size() - 1;
+}
+
+void History::pushEntry(std::string_view operation, double result) {
+  operationIds_.push_back(operations_.intern(operation));
+  results_.push_back(result);
+  index_.append(*this, size() - 1);
+}
+
+void History::truncate(size_t count) {
+  index_.truncate(*this, count);
+  // Strings of dropped entries stay interned; clear() reclaims them
+  if (count <= mappedCount_) {
+    mappedCount_ = count;
+    operationIds_.clear();
+    results_.clear();
+  } else {
+    operationIds_.resize(count - mappedCount_);
+    results_.resize(count - mappedCount_);
   }
+}
+
+void History::clearEntries() {
+  releaseMapping();
+  operations_.clear();
+  operationIds_.clear();
+  results_.clear();
+  currentIndex_ = -1;
+  index_.clear();
+}
+
+void History::releaseMapping() {
+  mapped_.close();
+  mappedCount_ = 0;
+  mappedResults_ = nullptr;
+  mappedOffsets_ = nullptr;
+  mappedStrings_ = nullptr;
+  mappedStringBytes_ = 0;
+}
 
-  entries_.emplace_back(operation, result);
-  currentIndex_ = entries_.size() - 1;
+std::string_view History::operationAt(size_t index) const {
+  if (index >= mappedCount_)
+    return operations_.get(operationIds_.at(index - mappedCount_));
+
+  // mapBinary checked that the offsets are ordered and end at the
+  // string section's size
+  uint64_t begin = mappedOffsets_[index];
+  uint64_t end = mappedOffsets_[index + 1];
+  return std::string_view(mappedStrings_ + begin, end - begin);
+}
+
+double History::resultAt(size_t index) const {
+  if (index >= mappedCount_)
+    return results_.at(index - mappedCount_);
+  return mappedResults_[index];
+}
+
+const HistoryIndex &History::searchIndex() const {
+  if (!index_.isBuilt())
+    index_.build(*this);
+  return index_;
+}
+
+std::vector<size_t> History::findPrefix(std::string_view prefix) const {
+  return searchIndex().findPrefix(*this, prefix);
+}
+
+std::vector<size_t> History::findSubstring(std::string_view text) const {
+  return searchIndex().findSubstring(*this, text);
+}
+
+std::vector<size_t> History::findResultRange(double low, double high) const {
+  return searchIndex().findResultRange(*this, low, high);
+}
+
+void History::addEntry(const std::string &operation, double result) {
+  appendEntry(operation, result);
+  if (journal_) {
+    journal_->appendAdd(operation, result);
+    compactJournalIfNeeded();
+  }
 }
 
 void History::display() const {
-  if (entries_.empty()) {
+  if (size() == 0) {
     std::cout << "History is empty.\n";
     return;
   }
 
-  std::cout << "\n--- History ---\n";
-  for (size_t i = 0; i < entries_.size(); ++i) {
-    std::cout << i + 1 << ". " << entries_[i].operation << " = "
-              << entries_[i].result;
+  std::string out = "\n--- History ---\n";
+  for (size_t i = 0; i < size(); ++i) {
+    out += std::to_string(i + 1);
+    out += ". ";
+    out += operationAt(i);
+    out += " = ";
+    appendNumber(out, resultAt(i));
     if ((int)i == currentIndex_)
-      std::cout << " [CURRENT]";
-    std::cout << std::endl;
+      out += " [CURRENT]";
+    out += '\n';
+    if (out.size() >= kOutputChunk) {
+      std::cout.write(out.data(), out.size());
+      out.clear();
+    }
   }
+  std::cout.write(out.data(), out.size());
+  std::cout.flush();
 }
 
 bool History::undo() {
   if (currentIndex_ > 0) {
     --currentIndex_;
-    std::cout << "Undone. Current: " << entries_[currentIndex_].operation
-              << " = " << entries_[currentIndex_].result << std::endl;
+    if (journal_)
+      journal_->appendUndo();
+    std::cout << "Undone. Current: " << operationAt(currentIndex_) << " = "
+              << resultAt(currentIndex_) << std::endl;
     return true;
   }
   std::cout << "Nothing to undo.\n";
@@ -40,10 +168,12 @@ bool History::undo() {
 }
 
 bool History::redo() {
-  if (currentIndex_ < (int)entries_.size() - 1) {
+  if (currentIndex_ < (int)size() - 1) {
     ++currentIndex_;
-    std::cout << "Redone. Current: " << entries_[currentIndex_].operation
-              << " = " << entries_[currentIndex_].result << std::endl;
+    if (journal_)
+      journal_->appendRedo();
+    std::cout << "Redone. Current: " << operationAt(currentIndex_) << " = "
+              << resultAt(currentIndex_) << std::endl;
     return true;
   }
   std::cout << "Nothing to redo.\n";
@@ -58,9 +188,18 @@ void History::save(const std::string &filename) const {
   }
 
   // Save only entries up to currentIndex_ (not undone entries)
-  for (int i = 0; i <= currentIndex_ && i < (int)entries_.size(); ++i) {
-    file << entries_[i].operation << "|" << entries_[i].result << "\n";
+  std::string out;
+  for (int i = 0; i <= currentIndex_ && i < (int)size(); ++i) {
+    out += operationAt(i);
+    out += '|';
+    appendNumber(out, resultAt(i));
+    out += '\n';
+    if (out.size() >= kOutputChunk) {
+      file.write(out.data(), out.size());
+      out.clear();
+    }
   }
+  file.write(out.data(), out.size());
 
   std::cout << "History saved to " << filename << std::endl;
 }
@@ -72,59 +211,119 @@ void History::load(const std::string &filename) {
     return;
   }
 
-  entries_.clear();
+  clearEntries();
   std::string line;
   while (std::getline(file, line)) {
-    size_t pos = line.find('|');
+    // The result never contains '|', the expression might
+    size_t pos = line.rfind('|');
     if (pos != std::string::npos) {
-      std::string op = line.substr(0, pos);
       double res = std::stod(line.substr(pos + 1));
-      entries_.emplace_back(op, res);
+      pushEntry(std::string_view(line).substr(0, pos), res);
     }
   }
 
-  currentIndex_ = entries_.empty() ? -1 : entries_.size() - 1;
+  currentIndex_ = (int)size() - 1;
+  rewriteJournal();
   std::cout << "History loaded from " << filename << std::endl;
 }
 
 void History::saveBinary(const std::string &filename) const {
-  std::ofstream file(filename, std::ios::binary);
-  if (!file) {
-    std::cout << "Failed to open file for binary writing.\n";
-    return;
+  // Only entries up to currentIndex_ are saved (not undone entries)
+  const uint64_t count = currentIndex_ + 1;
+
+  BinaryHeaderV2 header;
+  std::memcpy(header.magic, kHistoryMagic, sizeof(kHistoryMagic));
+  header.version = 2;
+  header.count = count;
+  header.currentIndex = currentIndex_;
+  header.stringBytes = 0;
+
+  std::vector<uint64_t> offsets(count + 1);
+  std::vector<double> results(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    offsets[i] = header.stringBytes;
+    header.stringBytes += operationAt(i).size();
+    results[i] = resultAt(i);
   }
+  offsets[count] = header.stringBytes;
+
+  const std::string temporary = filename + ".tmp";
+  {
+    std::ofstream file(temporary, std::ios::binary);
+    if (!file) {
+      std::cout << "Failed to open file for binary writing.\n";
+      return;
+    }
 
-  // Magic number and version
-  const char magic[4] = {'H', 'I', 'S', 'T'};
-  file.write(magic, 4);
-
-  uint32_t version = 1;
-  file.write(reinterpret_cast<const char *>(&version), sizeof(version));
-
-  // Entry count - only save entries up to currentIndex_
-  uint32_t count = (currentIndex_ >= 0) ? (currentIndex_ + 1) : 0;
-  file.write(reinterpret_cast<const char *>(&count), sizeof(count));
-
-  // Write each entry (only up to currentIndex_)
-  for (int i = 0; i <= currentIndex_ && i < (int)entries_.size(); ++i) {
-    const auto &entry = entries_[i];
-    // Operation string length and data
-    uint32_t opLength = entry.operation.length();
-    file.write(reinterpret_cast<const char *>(&opLength), sizeof(opLength));
-    file.write(entry.operation.c_str(), opLength);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(results.data()),
+               count * sizeof(double));
+    file.write(reinterpret_cast<const char *>(offsets.data()),
+               (count + 1) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; ++i) {
+      std::string_view operation = operationAt(i);
+      file.write(operation.data(), operation.size());
+    }
 
-    // Result (double)
-    file.write(reinterpret_cast<const char *>(&entry.result),
-               sizeof(entry.result));
+    if (!file.flush()) {
+      std::cout << "Failed to write binary history.\n";
+      std::remove(temporary.c_str());
+      return;
+    }
   }
 
-  // Current index
-  int32_t currentIdx = currentIndex_;
-  file.write(reinterpret_cast<const char *>(&currentIdx), sizeof(currentIdx));
+  // Replace atomically; a history mapped from the old file keeps reading
+  // the old contents
+  std::error_code error;
+  std::filesystem::rename(temporary, filename, error);
+  if (error) {
+    std::cout << "Failed to write binary history.\n";
+    std::remove(temporary.c_str());
+    return;
+  }
 
   std::cout << "History saved to binary file " << filename << std::endl;
 }
 
+bool History::mapBinary(const std::string &filename) {
+  // Entries are read by index, so skip the sequential read-ahead
+  MappedFile file(filename, MappedFile::Access::Random);
+  BinaryHeaderV2 header;
+  if (!file.isOpen() || file.size() < sizeof(header))
+    return false;
+  std::memcpy(&header, file.data(), sizeof(header));
+
+  // Check that the sections fit exactly, without overflowing on a hostile
+  // count or string size
+  const uint64_t size = file.size() - sizeof(header);
+  if (size < 8 || header.count > (size - 8) / 16 ||
+      header.stringBytes != size - header.count * 16 - 8 ||
+      header.currentIndex < -1 ||
+      header.currentIndex >= static_cast<int64_t>(header.count))
+    return false;
+
+  const char *base = file.data() + sizeof(header);
+  const auto *offsets =
+      reinterpret_cast<const uint64_t *>(base + header.count * sizeof(double));
+  // Every entry's string must lie inside the string section
+  for (uint64_t i = 0; i < header.count; ++i) {
+    if (offsets[i] > offsets[i + 1])
+      return false;
+  }
+  if (offsets[header.count] != header.stringBytes)
+    return false;
+
+  clearEntries();
+  mappedResults_ = reinterpret_cast<const double *>(base);
+  mappedOffsets_ = offsets;
+  mappedStrings_ = base + header.count * 16 + 8;
+  mappedStringBytes_ = header.stringBytes;
+  mappedCount_ = header.count;
+  mapped_ = std::move(file);
+  currentIndex_ = static_cast<int>(header.currentIndex);
+  return true;
+}
+
 void History::loadBinary(const std::string &filename) {
   std::ifstream file(filename, std::ios::binary);
   if (!file) {
@@ -145,11 +344,22 @@ void History::loadBinary(const std::string &filename) {
   uint32_t version;
   file.read(reinterpret_cast<char *>(&version), sizeof(version));
 
+  if (version == 2) {
+    file.close();
+    if (!mapBinary(filename)) {
+      std::cout << "Invalid binary history file format.\n";
+      return;
+    }
+    rewriteJournal();
+    std::cout << "History loaded from binary file " << filename << std::endl;
+    return;
+  }
+
   // Read entry count
   uint32_t count;
   file.read(reinterpret_cast<char *>(&count), sizeof(count));
 
-  entries_.clear();
+  clearEntries();
 
   // Read each entry
   for (uint32_t i = 0; i < count; ++i) {
@@ -164,19 +374,117 @@ void History::loadBinary(const std::string &filename) {
     double result;
     file.read(reinterpret_cast<char *>(&result), sizeof(result));
 
-    entries_.emplace_back(operation, result);
+    pushEntry(operation, result);
   }
 
   // Read current index
   int32_t currentIdx;
   file.read(reinterpret_cast<char *>(&currentIdx), sizeof(currentIdx));
   currentIndex_ = currentIdx;
+  rewriteJournal();
 
   std::cout << "History loaded from binary file " << filename << std::endl;
 }
 
 void History::clear() {
-  entries_.clear();
-  currentIndex_ = -1;
+  clearEntries();
+  if (journal_) {
+    journal_->appendClear();
+    compactJournalIfNeeded();
+  }
   std::cout << "History cleared.\n";
 }
+
+void History::applyRecord(int type, std::string_view operation,
+                          double result, int32_t cursor) {
+  // Same state transitions as addEntry/undo/redo/clear, without output
+  switch (static_cast<HistoryJournal::RecordType>(type)) {
+  case HistoryJournal::RecordType::Add:
+    appendEntry(operation, result);
+    break;
+  case HistoryJournal::RecordType::Undo:
+    if (currentIndex_ > 0)
+      --currentIndex_;
+    break;
+  case HistoryJournal::RecordType::Redo:
+    if (currentIndex_ < (int)size() - 1)
+      ++currentIndex_;
+    break;
+  case HistoryJournal::RecordType::Clear:
+    clearEntries();
+    break;
+  case HistoryJournal::RecordType::Cursor:
+    if (cursor >= -1 && cursor < (int)size())
+      currentIndex_ = cursor;
+    break;
+  }
+}
+
+bool History::openJournal(const std::string &filename) {
+  if (journal_ && journal_->filename() == filename) {
+    std::cout << "History journal " << filename << " is already open.\n";
+    return true;
+  }
+
+  auto journal = std::make_unique<HistoryJournal>();
+  History recovered;
+
+  auto replay = [&](HistoryJournal::RecordType type,
+                    std::string_view operation, double result,
+                    int32_t cursor) {
+    recovered.applyRecord(static_cast<int>(type), operation, result, cursor);
+  };
+
+  if (!journal->open(filename, replay)) {
+    std::cout << "Failed to open history journal " << filename << std::endl;
+    return false;
+  }
+
+  // Entries of this session are kept: they seed a new or empty journal,
+  // or follow the active entries recovered from a non-empty one
+  const size_t sessionEntries = size();
+  if (sessionEntries > 0) {
+    for (size_t i = 0; i < sessionEntries; ++i)
+      recovered.appendEntry(operationAt(i), resultAt(i));
+    recovered.currentIndex_ =
+        static_cast<int>(recovered.size() - sessionEntries) + currentIndex_;
+  }
+
+  // Replaces any previously attached journal
+  recovered.journal_ = std::move(journal);
+  *this = std::move(recovered);
+  if (sessionEntries > 0)
+    rewriteJournal();
+
+  if (journal_->discardedBytes() > 0) {
+    std::cout << "Discarded " << journal_->discardedBytes()
+              << " bytes of incomplete journal records.\n";
+  }
+  std::cout << "History journal " << filename << " opened with " << size()
+            << " entries";
+  if (sessionEntries > 0)
+    std::cout << " (" << sessionEntries << " from this session)";
+  std::cout << ".\n";
+  return true;
+}
+
+void History::closeJournal() { journal_.reset(); }
+
+bool History::hasJournal() const { return journal_ != nullptr; }
+
+void History::compactJournalIfNeeded() {
+  // Rewriting costs O(entries) and happens only after more than that many
+  // obsolete records piled up, so appends stay O(1) amortized
+  if (journal_->recordCount() > 2 * size() + kCompactionSlack)
+    rewriteJournal();
+}
+
+void History::rewriteJournal() {
+  if (!journal_)
+    return;
+  journal_->rewrite([this](HistoryJournal &fresh) {
+    for (size_t i = 0; i < size(); ++i)
+      fresh.appendAdd(operationAt(i), resultAt(i));
+    fresh.appendCursor(currentIndex_);
+  });
+}
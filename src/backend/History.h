@@ -1,11 +1,24 @@
 #ifndef HISTORY_H
 #define HISTORY_H
 
+#include "HistoryIndex.h"
+#include "MappedFile.h"
+#include "StringInterner.h"
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
+class HistoryJournal;
+
 class History {
 public:
+  History();
+  ~History();
+  History(History &&) noexcept;
+  History &operator=(History &&) noexcept;
+
   void addEntry(const std::string &operation, double result);
   void display() const;
   bool undo();
@@ -15,22 +28,117 @@ public:
   void save(const std::string &filename) const;
   void load(const std::string &filename);
 
-  // Binary format I/O
+  /**
+   * @brief Save in the v2 binary format
+   *
+   * Layout: 32-byte header ("HIST", u32 version 2, u64 count, i64 current
+   * index, u64 string bytes), f64 results[count], u64 offsets[count + 1]
+   * into the string area, then all operation strings back to back. The
+   * file is written under a temporary name and renamed into place, so a
+   * history mapped from the same file stays readable.
+   */
   void saveBinary(const std::string &filename) const;
+
+  /**
+   * @brief Load a binary history (v1 or v2)
+   *
+   * v2 files are memory-mapped rather than read: entries are decoded from
+   * the mapping when accessed, so opening costs the same for any size.
+   */
   void loadBinary(const std::string &filename);
 
   void clear();
 
-private:
-  struct Entry {
-    std::string operation;
-    double result;
+  /**
+   * @brief Persist every change incrementally to an append-only journal
+   * @param filename Journal file; created if missing
+   * @return false if the file is not a journal or cannot be written
+   *
+   * An existing journal is replayed first and a torn tail left by a
+   * crash is cut off. Entries already in this history are not lost: they
+   * follow the recovered ones (whose undone entries are then dropped) and
+   * are written to the journal. From then on each add, undo, redo and
+   * clear appends one record (group-committed), and the journal is
+   * compacted once most of its records are obsolete.
+   */
+  bool openJournal(const std::string &filename);
+
+  /**
+   * @brief Commit pending journal records and detach the journal
+   */
+  void closeJournal();
+
+  bool hasJournal() const;
+
+  size_t size() const { return mappedCount_ + results_.size(); }
+
+  /**
+   * @brief Expression of an entry
+   *
+   * Points into the mapped file or the string arena; valid until the next
+   * change to the history.
+   * @throws std::out_of_range if index >= size()
+   */
+  std::string_view operationAt(size_t index) const;
 
-    Entry(const std::string &op, double res) : operation(op), result(res) {}
-  };
+  /**
+   * @throws std::out_of_range if index >= size()
+   */
+  double resultAt(size_t index) const;
 
-  std::vector<Entry> entries_;
+  int currentIndex() const { return currentIndex_; }
+
+  /**
+   * @brief Entries whose expression starts with `prefix`
+   *
+   * The search index is built on the first query and then kept up to date
+   * by addEntry, undo-then-add and clear, so later queries cost
+   * O(log n + matches). All searches cover every entry, including undone
+   * ones, and return entry numbers in ascending order.
+   */
+  std::vector<size_t> findPrefix(std::string_view prefix) const;
+
+  /**
+   * @brief Entries whose expression contains `text`
+   */
+  std::vector<size_t> findSubstring(std::string_view text) const;
+
+  /**
+   * @brief Entries whose result lies in [low, high]
+   */
+  std::vector<size_t> findResultRange(double low, double high) const;
+
+private:
+  // Entries [0, mappedCount_) are read in place from a v2 binary file
+  // mapped by loadBinary; the arrays below hold the ones added after it
+  MappedFile mapped_;
+  size_t mappedCount_ = 0;
+  const double *mappedResults_ = nullptr;
+  const uint64_t *mappedOffsets_ = nullptr;
+  const char *mappedStrings_ = nullptr;
+  uint64_t mappedStringBytes_ = 0;
+
+  // In-memory entries as struct of arrays. Expressions are interned:
+  // repeated formulas share one copy in a contiguous arena.
+  StringInterner operations_;
+  std::vector<StringInterner::Id> operationIds_;
+  std::vector<double> results_;
   int currentIndex_ = -1;
+  std::unique_ptr<HistoryJournal> journal_;
+  // Built lazily by the first search
+  mutable HistoryIndex index_;
+
+  void appendEntry(std::string_view operation, double result);
+  void pushEntry(std::string_view operation, double result);
+  void truncate(size_t count);
+  void clearEntries();
+  void applyRecord(int type, std::string_view operation, double result,
+                   int32_t cursor);
+  void releaseMapping();
+  const HistoryIndex &searchIndex() const;
+  bool mapBinary(const std::string &filename);
+  void compactJournalIfNeeded();
+  void rewriteJournal();
 };
 
 #endif
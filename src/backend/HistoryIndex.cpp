@@ -0,0 +1,261 @@
+#include "HistoryIndex.h"
+#include "History.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+// The tail is merged once it is longer than this or than 1/kTailFraction
+// of the sorted part, whichever is larger
+constexpr size_t kMinTail = 1024;
+constexpr size_t kTailFraction = 16;
+
+uint32_t trigramAt(std::string_view text, size_t pos) {
+  return static_cast<unsigned char>(text[pos]) |
+         static_cast<unsigned char>(text[pos + 1]) << 8 |
+         static_cast<unsigned char>(text[pos + 2]) << 16;
+}
+
+bool hasPrefix(std::string_view text, std::string_view prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// First eight bytes, big-endian and zero-padded: comparing keys orders
+// strings like comparing the strings, except that equal keys need a full
+// comparison
+uint64_t prefixKey(std::string_view text) {
+  uint64_t key = 0;
+  for (size_t i = 0; i < 8; ++i)
+    key = key << 8 |
+          (i < text.size() ? static_cast<unsigned char>(text[i]) : 0u);
+  return key;
+}
+
+std::vector<size_t> sortedEntries(std::vector<uint32_t> &matches) {
+  std::sort(matches.begin(), matches.end());
+  return std::vector<size_t>(matches.begin(), matches.end());
+}
+} // namespace
+
+void HistoryIndex::build(const History &history) {
+  clear();
+  const size_t count = history.size();
+  if (count > std::numeric_limits<uint32_t>::max())
+    throw std::length_error("History too large to index");
+
+  for (size_t i = 0; i < count; ++i)
+    addTrigrams(history.operationAt(i), static_cast<uint32_t>(i));
+  indexed_ = count;
+  mergeTail(history);
+  built_ = true;
+}
+
+void HistoryIndex::append(const History &history, size_t index) {
+  if (!built_)
+    return;
+  if (index != indexed_ || index >= std::numeric_limits<uint32_t>::max()) {
+    // Out of step with the history; rebuild on the next query instead
+    clear();
+    return;
+  }
+
+  addTrigrams(history.operationAt(index), static_cast<uint32_t>(index));
+  ++indexed_;
+  if (indexed_ - merged_ > std::max(kMinTail, merged_ / kTailFraction))
+    mergeTail(history);
+}
+
+void HistoryIndex::truncate(const History &history, size_t count) {
+  if (!built_ || count >= indexed_)
+    return;
+
+  // Posting lists are sorted, so the dropped entries sit at their ends
+  for (size_t i = count; i < indexed_; ++i) {
+    std::string_view operation = history.operationAt(i);
+    for (size_t pos = 0; pos + 3 <= operation.size(); ++pos) {
+      auto it = trigrams_.find(trigramAt(operation, pos));
+      if (it == trigrams_.end())
+        continue;
+      auto &postings = it->second;
+      while (!postings.empty() && postings.back() >= count)
+        postings.pop_back();
+      if (postings.empty())
+        trigrams_.erase(it);
+    }
+  }
+
+  if (count < merged_) {
+    auto dropped = [count](uint32_t entry) { return entry >= count; };
+    byOperation_.erase(
+        std::remove_if(byOperation_.begin(), byOperation_.end(), dropped),
+        byOperation_.end());
+    byResult_.erase(
+        std::remove_if(byResult_.begin(), byResult_.end(), dropped),
+        byResult_.end());
+    merged_ = count;
+  }
+  indexed_ = count;
+}
+
+void HistoryIndex::clear() {
+  built_ = false;
+  indexed_ = 0;
+  merged_ = 0;
+  byOperation_.clear();
+  byOperation_.shrink_to_fit();
+  byResult_.clear();
+  byResult_.shrink_to_fit();
+  trigrams_.clear();
+}
+
+void HistoryIndex::addTrigrams(std::string_view operation, uint32_t index) {
+  for (size_t pos = 0; pos + 3 <= operation.size(); ++pos) {
+    auto &postings = trigrams_[trigramAt(operation, pos)];
+    // A trigram repeated within one expression is listed once
+    if (postings.empty() || postings.back() != index)
+      postings.push_back(index);
+  }
+}
+
+void HistoryIndex::mergeTail(const History &history) {
+  const size_t count = indexed_ - merged_;
+
+  // Sort the tail on cached keys and views so comparisons do not have to
+  // look the entries up again
+  struct OperationKey {
+    uint64_t prefix;
+    std::string_view operation;
+    uint32_t entry;
+  };
+  std::vector<OperationKey> operations(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto entry = static_cast<uint32_t>(merged_ + i);
+    std::string_view operation = history.operationAt(entry);
+    operations[i] = {prefixKey(operation), operation, entry};
+  }
+  std::sort(operations.begin(), operations.end(),
+            [](const OperationKey &a, const OperationKey &b) {
+              if (a.prefix != b.prefix)
+                return a.prefix < b.prefix;
+              int order = a.operation.compare(b.operation);
+              return order < 0 || (order == 0 && a.entry < b.entry);
+            });
+
+  // Entries in the sorted part are all older, so on equal keys they go
+  // first
+  std::vector<uint32_t> merged;
+  merged.reserve(byOperation_.size() + count);
+  auto sorted = byOperation_.begin();
+  for (const OperationKey &key : operations) {
+    while (sorted != byOperation_.end() &&
+           history.operationAt(*sorted) <= key.operation)
+      merged.push_back(*sorted++);
+    merged.push_back(key.entry);
+  }
+  merged.insert(merged.end(), sorted, byOperation_.end());
+  byOperation_.swap(merged);
+  operations = {};
+
+  // NaN has no place in the order and never matches a range
+  std::vector<std::pair<double, uint32_t>> results;
+  results.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto entry = static_cast<uint32_t>(merged_ + i);
+    double result = history.resultAt(entry);
+    if (!std::isnan(result))
+      results.emplace_back(result, entry);
+  }
+  std::sort(results.begin(), results.end());
+
+  merged.clear();
+  merged.reserve(byResult_.size() + results.size());
+  sorted = byResult_.begin();
+  for (const auto &[result, entry] : results) {
+    while (sorted != byResult_.end() && history.resultAt(*sorted) <= result)
+      merged.push_back(*sorted++);
+    merged.push_back(entry);
+  }
+  merged.insert(merged.end(), sorted, byResult_.end());
+  byResult_.swap(merged);
+
+  merged_ = indexed_;
+}
+
+std::vector<size_t> HistoryIndex::findPrefix(const History &history,
+                                             std::string_view prefix) const {
+  auto first = std::lower_bound(
+      byOperation_.begin(), byOperation_.end(), prefix,
+      [&history](uint32_t entry, std::string_view key) {
+        return history.operationAt(entry) < key;
+      });
+  auto last = std::upper_bound(
+      first, byOperation_.end(), prefix,
+      [&history](std::string_view key, uint32_t entry) {
+        return key < history.operationAt(entry).substr(0, key.size());
+      });
+
+  std::vector<uint32_t> matches(first, last);
+  for (size_t i = merged_; i < indexed_; ++i) {
+    if (hasPrefix(history.operationAt(i), prefix))
+      matches.push_back(static_cast<uint32_t>(i));
+  }
+  return sortedEntries(matches);
+}
+
+std::vector<size_t>
+HistoryIndex::findSubstring(const History &history,
+                            std::string_view text) const {
+  std::vector<size_t> matches;
+  if (text.size() < 3) {
+    // Too short for a trigram; check every entry
+    for (size_t i = 0; i < indexed_; ++i) {
+      if (history.operationAt(i).find(text) != std::string_view::npos)
+        matches.push_back(i);
+    }
+    return matches;
+  }
+
+  // Every match contains all trigrams of the text, so the shortest of
+  // their posting lists is a complete candidate set
+  const std::vector<uint32_t> *candidates = nullptr;
+  for (size_t pos = 0; pos + 3 <= text.size(); ++pos) {
+    auto it = trigrams_.find(trigramAt(text, pos));
+    if (it == trigrams_.end())
+      return matches;
+    if (!candidates || it->second.size() < candidates->size())
+      candidates = &it->second;
+  }
+
+  for (uint32_t entry : *candidates) {
+    if (history.operationAt(entry).find(text) != std::string_view::npos)
+      matches.push_back(entry);
+  }
+  return matches;
+}
+
+std::vector<size_t> HistoryIndex::findResultRange(const History &history,
+                                                  double low,
+                                                  double high) const {
+  if (!(low <= high))
+    return {};
+
+  auto first = std::lower_bound(byResult_.begin(), byResult_.end(), low,
+                                [&history](uint32_t entry, double key) {
+                                  return history.resultAt(entry) < key;
+                                });
+  auto last = std::upper_bound(first, byResult_.end(), high,
+                               [&history](double key, uint32_t entry) {
+                                 return key < history.resultAt(entry);
+                               });
+
+  std::vector<uint32_t> matches(first, last);
+  for (size_t i = merged_; i < indexed_; ++i) {
+    double result = history.resultAt(i);
+    if (result >= low && result <= high)
+      matches.push_back(static_cast<uint32_t>(i));
+  }
+  return sortedEntries(matches);
+}
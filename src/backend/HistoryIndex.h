@@ -0,0 +1,81 @@
+#ifndef HISTORYINDEX_H
+#define HISTORYINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class History;
+
+/**
+ * @brief Search indexes over the entries of a History
+ *
+ * Three indexes are kept side by side:
+ *  - entry numbers sorted by expression, for prefix lookup;
+ *  - entry numbers sorted by result, for range queries;
+ *  - posting lists of every 3-byte substring (trigram) of the
+ *    expressions, for substring search.
+ *
+ * New entries are appended to the posting lists directly (entry numbers
+ * only grow, so the lists stay sorted) and collected in an unsorted tail
+ * for the two sorted indexes. Queries binary-search the sorted part and
+ * scan the tail; once the tail reaches a fraction of the sorted part it
+ * is sorted and merged in, so appends cost O(log n) amortized.
+ *
+ * The index does not own the entries: every call gets the History it
+ * describes, which must be the same one each time.
+ */
+class HistoryIndex {
+public:
+  bool isBuilt() const { return built_; }
+
+  /**
+   * @brief Index every entry of `history`, replacing any previous state
+   * @throws std::length_error if the history has 2^32 or more entries
+   */
+  void build(const History &history);
+
+  /**
+   * @brief Index entry `index`, which must be the next unindexed one
+   */
+  void append(const History &history, size_t index);
+
+  /**
+   * @brief Forget entries [count, size) before the history drops them
+   */
+  void truncate(const History &history, size_t count);
+
+  /**
+   * @brief Drop all index data; the next query rebuilds it
+   */
+  void clear();
+
+  // Queries return entry numbers in ascending order
+  std::vector<size_t> findPrefix(const History &history,
+                                 std::string_view prefix) const;
+  std::vector<size_t> findSubstring(const History &history,
+                                    std::string_view text) const;
+  /**
+   * @brief Entries whose result lies in [low, high]; NaN never matches
+   */
+  std::vector<size_t> findResultRange(const History &history, double low,
+                                      double high) const;
+
+private:
+  using Trigram = uint32_t;
+
+  void addTrigrams(std::string_view operation, uint32_t index);
+  void mergeTail(const History &history);
+
+  bool built_ = false;
+  // Entries [0, indexed_) are indexed; [merged_, indexed_) is the tail
+  size_t indexed_ = 0;
+  size_t merged_ = 0;
+  std::vector<uint32_t> byOperation_;
+  std::vector<uint32_t> byResult_;
+  std::unordered_map<Trigram, std::vector<uint32_t>> trigrams_;
+};
+
+#endif // HISTORYINDEX_H
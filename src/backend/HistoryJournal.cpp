@@ -0,0 +1,325 @@
+#include "HistoryJournal.h"
+#include "MappedFile.h"
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char kJournalMagic[4] = {'H', 'J', 'N', 'L'};
+constexpr uint32_t kJournalVersion = 1;
+constexpr size_t kFileHeaderSize = 8;
+// u32 crc, u32 payload length, u8 type
+constexpr size_t kRecordHeaderSize = 9;
+// Operations are expressions; anything larger is a corrupt length field
+constexpr uint32_t kMaxPayload = 1 << 24;
+
+// Group commit thresholds: whichever is reached first triggers a commit
+constexpr size_t kCommitBytes = 64 << 10;
+constexpr size_t kCommitRecords = 256;
+constexpr auto kCommitInterval = std::chrono::milliseconds(50);
+
+// CRC-32 (IEEE, reflected), slicing-by-8: eight table lookups per 8 input
+// bytes instead of one per byte, which keeps recovery of large journals
+// I/O-bound
+struct Crc32Tables {
+  std::array<std::array<uint32_t, 256>, 8> t;
+
+  Crc32Tables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1)));
+      t[0][i] = c;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (size_t s = 1; s < 8; ++s)
+        t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+    }
+  }
+};
+
+uint32_t crc32(const void *data, size_t length) {
+  static const Crc32Tables tables;
+  const auto &t = tables.t;
+  const auto *p = static_cast<const unsigned char *>(data);
+  uint32_t crc = 0xFFFFFFFFu;
+
+  for (; length >= 8; p += 8, length -= 8) {
+    uint32_t lo, hi;
+    std::memcpy(&lo, p, 4);
+    std::memcpy(&hi, p + 4, 4);
+    lo ^= crc;
+    crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^
+          t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+          t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+  }
+  while (length--)
+    crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+  return ~crc;
+}
+
+bool isKnownType(uint8_t type) {
+  return type >= static_cast<uint8_t>(HistoryJournal::RecordType::Add) &&
+         type <= static_cast<uint8_t>(HistoryJournal::RecordType::Cursor);
+}
+
+void syncFile(std::FILE *file) {
+#ifdef _WIN32
+  _commit(_fileno(file));
+#else
+  fsync(fileno(file));
+#endif
+}
+
+} // namespace
+
+HistoryJournal::~HistoryJournal() { close(); }
+
+bool HistoryJournal::open(const std::string &filename,
+                          const ReplayFunction &replay) {
+  close();
+  discarded_ = 0;
+  records_ = 0;
+
+  size_t validEnd = 0;
+  size_t fileSize = 0;
+  {
+    MappedFile file(filename);
+    if (!file.isOpen() || file.size() == 0) {
+      if (!create(filename))
+        return false;
+      startFlusher();
+      return true;
+    }
+
+    const char *data = file.data();
+    fileSize = file.size();
+    uint32_t version = 0;
+    if (fileSize < kFileHeaderSize ||
+        std::memcmp(data, kJournalMagic, sizeof(kJournalMagic)) != 0)
+      return false;
+    std::memcpy(&version, data + 4, sizeof(version));
+    if (version != kJournalVersion)
+      return false;
+
+    size_t pos = kFileHeaderSize;
+    while (fileSize - pos >= kRecordHeaderSize) {
+      uint32_t crc, length;
+      std::memcpy(&crc, data + pos, 4);
+      std::memcpy(&length, data + pos + 4, 4);
+      if (length > kMaxPayload || fileSize - pos - kRecordHeaderSize < length)
+        break;
+      if (crc32(data + pos + 4, 5 + length) != crc)
+        break;
+
+      auto type = static_cast<uint8_t>(data[pos + 8]);
+      const char *payload = data + pos + kRecordHeaderSize;
+      if (!isKnownType(type))
+        break;
+
+      double result = 0;
+      int32_t cursor = 0;
+      std::string_view operation;
+      auto recordType = static_cast<RecordType>(type);
+      if (recordType == RecordType::Add) {
+        if (length < sizeof(result))
+          break;
+        std::memcpy(&result, payload, sizeof(result));
+        operation = std::string_view(payload + sizeof(result),
+                                     length - sizeof(result));
+      } else if (recordType == RecordType::Cursor) {
+        if (length != sizeof(cursor))
+          break;
+        std::memcpy(&cursor, payload, sizeof(cursor));
+      }
+
+      replay(recordType, operation, result, cursor);
+      ++records_;
+      pos += kRecordHeaderSize + length;
+    }
+    validEnd = pos;
+  }
+
+  // Drop the torn or corrupt tail so new records follow the last good one
+  if (validEnd < fileSize) {
+    std::error_code error;
+    std::filesystem::resize_file(filename, validEnd, error);
+    if (error)
+      return false;
+    discarded_ = fileSize - validEnd;
+  }
+
+  file_ = std::fopen(filename.c_str(), "ab");
+  if (!file_)
+    return false;
+  filename_ = filename;
+  startFlusher();
+  return true;
+}
+
+bool HistoryJournal::create(const std::string &filename) {
+  file_ = std::fopen(filename.c_str(), "wb");
+  if (!file_)
+    return false;
+
+  uint32_t version = kJournalVersion;
+  std::fwrite(kJournalMagic, 1, sizeof(kJournalMagic), file_);
+  std::fwrite(&version, sizeof(version), 1, file_);
+  std::fflush(file_);
+  syncFile(file_);
+  filename_ = filename;
+  return true;
+}
+
+void HistoryJournal::close() {
+  stopFlusher();
+  if (!file_)
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Called from the destructor, so a failed final write is not rethrown
+  try {
+    commitLocked();
+  } catch (const std::exception &) {
+  }
+  flushError_ = nullptr;
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+void HistoryJournal::appendAdd(std::string_view operation, double result) {
+  append(RecordType::Add, &result, sizeof(result), operation);
+}
+
+void HistoryJournal::appendUndo() { append(RecordType::Undo, nullptr, 0); }
+
+void HistoryJournal::appendRedo() { append(RecordType::Redo, nullptr, 0); }
+
+void HistoryJournal::appendClear() { append(RecordType::Clear, nullptr, 0); }
+
+void HistoryJournal::appendCursor(int32_t cursor) {
+  append(RecordType::Cursor, &cursor, sizeof(cursor));
+}
+
+void HistoryJournal::append(RecordType type, const void *payload,
+                            size_t length, std::string_view text) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!file_)
+    return;
+
+  uint32_t payloadLength = static_cast<uint32_t>(length + text.size());
+  size_t start = pending_.size();
+  pending_.resize(start + kRecordHeaderSize + payloadLength);
+  char *record = pending_.data() + start;
+
+  std::memcpy(record + 4, &payloadLength, 4);
+  record[8] = static_cast<char>(type);
+  if (length > 0)
+    std::memcpy(record + kRecordHeaderSize, payload, length);
+  if (!text.empty())
+    std::memcpy(record + kRecordHeaderSize + length, text.data(), text.size());
+  uint32_t crc = crc32(record + 4, 5 + payloadLength);
+  std::memcpy(record, &crc, 4);
+
+  auto now = std::chrono::steady_clock::now();
+  if (pendingRecords_++ == 0) {
+    oldestPending_ = now;
+    wake_.notify_one();
+  }
+  ++records_;
+
+  if (pending_.size() >= kCommitBytes || pendingRecords_ >= kCommitRecords ||
+      now - oldestPending_ >= kCommitInterval)
+    commitLocked();
+}
+
+void HistoryJournal::commit() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (flushError_) {
+    auto error = flushError_;
+    flushError_ = nullptr;
+    std::rethrow_exception(error);
+  }
+  commitLocked();
+}
+
+void HistoryJournal::commitLocked() {
+  if (!file_ || pending_.empty())
+    return;
+
+  size_t written = std::fwrite(pending_.data(), 1, pending_.size(), file_);
+  bool failed = written != pending_.size() || std::fflush(file_) != 0;
+  pending_.clear();
+  pendingRecords_ = 0;
+  if (failed)
+    throw std::runtime_error("Failed to write history journal " + filename_);
+  syncFile(file_);
+}
+
+void HistoryJournal::startFlusher() {
+  stopping_ = false;
+  flusher_ = std::thread(&HistoryJournal::flushLoop, this);
+}
+
+void HistoryJournal::stopFlusher() {
+  if (!flusher_.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  flusher_.join();
+}
+
+void HistoryJournal::flushLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    if (pendingRecords_ == 0) {
+      wake_.wait(lock);
+      continue;
+    }
+    auto deadline = oldestPending_ + kCommitInterval;
+    if (std::chrono::steady_clock::now() < deadline) {
+      wake_.wait_until(lock, deadline);
+      continue;
+    }
+    try {
+      commitLocked();
+    } catch (const std::exception &) {
+      flushError_ = std::current_exception();
+    }
+  }
+}
+
+void HistoryJournal::rewrite(
+    const std::function<void(HistoryJournal &)> &fill) {
+  if (!file_)
+    return;
+
+  const std::string target = filename_;
+  const std::string temporary = target + ".tmp";
+  HistoryJournal fresh;
+  if (!fresh.create(temporary))
+    throw std::runtime_error("Failed to create " + temporary);
+  fill(fresh);
+  size_t records = fresh.records_;
+  fresh.close();
+
+  close();
+  std::error_code error;
+  std::filesystem::rename(temporary, target, error);
+  file_ = std::fopen(target.c_str(), "ab");
+  if (error || !file_)
+    throw std::runtime_error("Failed to replace history journal " + target);
+  filename_ = target;
+  records_ = records;
+  startFlusher();
+}
@@ -0,0 +1,137 @@
+#ifndef HISTORYJOURNAL_H
+#define HISTORYJOURNAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Append-only, checksummed log of History operations
+ *
+ * Every change to a History (add, undo, redo, clear) is one small record
+ * appended to the end of the file, so persisting it costs O(1) no matter
+ * how long the history is. Records are buffered and written as a group:
+ * a commit happens when enough bytes or records are pending or when the
+ * oldest pending record is older than the commit interval, and each commit
+ * is one write followed by an fsync. A background thread enforces the
+ * interval, so the last records of a session reach the disk within it even
+ * if nothing else is appended.
+ *
+ * File layout: 8-byte header ("HJNL", u32 version), then records of
+ *   u32 crc32 | u32 payload length | u8 type | payload
+ * where the CRC covers everything after itself. Recovery stops at the
+ * first record that is incomplete or fails its checksum and truncates the
+ * file there, which removes a tail torn by a crash mid-write.
+ */
+class HistoryJournal {
+public:
+  enum class RecordType : uint8_t {
+    Add = 1,   // payload: f64 result, then the operation text
+    Undo = 2,  // no payload
+    Redo = 3,  // no payload
+    Clear = 4, // no payload
+    Cursor = 5 // payload: i32 current index, written by compaction
+  };
+
+  /**
+   * @brief Called once per valid record during recovery
+   *
+   * `operation` points into the mapped journal and is only valid during
+   * the call. `result` is set for Add, `cursor` for Cursor.
+   */
+  using ReplayFunction = std::function<void(
+      RecordType type, std::string_view operation, double result,
+      int32_t cursor)>;
+
+  HistoryJournal() = default;
+  ~HistoryJournal();
+
+  HistoryJournal(const HistoryJournal &) = delete;
+  HistoryJournal &operator=(const HistoryJournal &) = delete;
+
+  /**
+   * @brief Open or create a journal, replaying what it already holds
+   * @return false if the file exists but is not a journal, or cannot be
+   *         opened for appending
+   */
+  bool open(const std::string &filename, const ReplayFunction &replay);
+
+  /**
+   * @brief Commit pending records and close the file
+   */
+  void close();
+
+  bool isOpen() const { return file_ != nullptr; }
+
+  void appendAdd(std::string_view operation, double result);
+  void appendUndo();
+  void appendRedo();
+  void appendClear();
+  void appendCursor(int32_t cursor);
+
+  /**
+   * @brief Write and fsync all pending records now
+   * @throws std::runtime_error if this or an earlier background commit
+   *         failed to write
+   */
+  void commit();
+
+  /**
+   * @brief Replace the journal with a minimal one
+   * @param fill Appends the records of the new journal
+   *
+   * The new journal is written to a temporary file, synced and renamed
+   * over the old one, so a crash leaves either the old or the new file.
+   */
+  void rewrite(const std::function<void(HistoryJournal &)> &fill);
+
+  /**
+   * @brief Records in the file, committed or pending
+   */
+  size_t recordCount() const { return records_; }
+
+  /**
+   * @brief Bytes cut from the end of the file by the last recovery
+   */
+  size_t discardedBytes() const { return discarded_; }
+
+  const std::string &filename() const { return filename_; }
+
+private:
+  bool create(const std::string &filename);
+  void append(RecordType type, const void *payload, size_t length,
+              std::string_view text = {});
+  // Callers hold mutex_
+  void commitLocked();
+  void startFlusher();
+  void stopFlusher();
+  // Commits records once they have been pending for the commit interval
+  void flushLoop();
+
+  std::string filename_;
+  std::FILE *file_ = nullptr;
+  std::vector<char> pending_;
+  size_t pendingRecords_ = 0;
+  size_t records_ = 0;
+  size_t discarded_ = 0;
+  std::chrono::steady_clock::time_point oldestPending_;
+
+  // Guards the pending buffer and file writes against the flusher
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread flusher_;
+  bool stopping_ = false;
+  // Failure of a background commit, reported by the next commit()
+  std::exception_ptr flushError_;
+};
+
+#endif // HISTORYJOURNAL_H
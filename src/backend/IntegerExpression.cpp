@@ -0,0 +1,674 @@
+#include "IntegerExpression.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+using Word = IntegerExpression::Word;
+using OpCode = IntegerExpression::OpCode;
+
+namespace {
+
+template <typename U> struct SignedOf;
+template <> struct SignedOf<uint64_t> {
+  using type = int64_t;
+};
+template <> struct SignedOf<Word> {
+  using type = __int128;
+};
+
+// SWAR bit count: plain arithmetic, so it vectorizes without POPCNT
+unsigned popcount(uint64_t v) {
+  v -= (v >> 1) & 0x5555555555555555u;
+  v = (v & 0x3333333333333333u) + ((v >> 2) & 0x3333333333333333u);
+  v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Fu;
+  return static_cast<unsigned>((v * 0x0101010101010101u) >> 56);
+}
+unsigned popcount(Word v) {
+  return popcount(static_cast<uint64_t>(v)) +
+         popcount(static_cast<uint64_t>(v >> 64));
+}
+
+// Position of the highest set bit plus one; 0 for 0
+unsigned bitLength(uint64_t v) { return v ? 64 - __builtin_clzll(v) : 0; }
+unsigned bitLength(Word v) {
+  auto high = static_cast<uint64_t>(v >> 64);
+  return high ? 64 + bitLength(high) : bitLength(static_cast<uint64_t>(v));
+}
+
+// Trailing zeros of a non-zero value
+unsigned trailingZeros(uint64_t v) { return __builtin_ctzll(v); }
+unsigned trailingZeros(Word v) {
+  auto low = static_cast<uint64_t>(v);
+  return low ? trailingZeros(low)
+             : 64 + trailingZeros(static_cast<uint64_t>(v >> 64));
+}
+
+uint64_t byteSwap(uint64_t v) { return __builtin_bswap64(v); }
+Word byteSwap(Word v) {
+  return (Word(byteSwap(static_cast<uint64_t>(v))) << 64) |
+         byteSwap(static_cast<uint64_t>(v >> 64));
+}
+
+// Width arithmetic on a machine word U. Values are kept sign-extended
+// (signed types) or zero-extended (unsigned) to all of U, so the bitwise
+// operators and the comparisons work on them directly.
+template <typename U> struct Lanes {
+  using S = typename SignedOf<U>::type;
+  static constexpr unsigned kWordBits = sizeof(U) * 8;
+
+  explicit Lanes(IntegerExpression::Type type)
+      : bits(type.bits), isSigned(type.isSigned), unused(kWordBits - bits),
+        mask(~U(0) >> unused) {}
+
+  U wrap(U v) const {
+    return isSigned ? U(S(v << unused) >> unused) : v & mask;
+  }
+  U low(U v) const { return v & mask; }
+
+  unsigned bits;
+  bool isSigned;
+  unsigned unused;
+  U mask;
+};
+
+template <typename U, typename F> void unary(U *a, size_t n, F f) {
+  for (size_t i = 0; i < n; ++i)
+    a[i] = f(a[i]);
+}
+
+template <typename U, typename F>
+void binary(U *a, const U *b, size_t n, F f) {
+  for (size_t i = 0; i < n; ++i)
+    a[i] = f(a[i], b[i]);
+}
+
+template <typename U> void checkDivisors(const U *b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    if (b[i] == 0)
+      throw std::runtime_error("Division by zero");
+  }
+}
+
+struct Function {
+  const char *name;
+  OpCode op;
+  int arity;
+};
+
+constexpr Function kFunctions[] = {
+    {"popcount", OpCode::Popcount, 1}, {"clz", OpCode::Clz, 1},
+    {"ctz", OpCode::Ctz, 1},           {"bswap", OpCode::Bswap, 1},
+    {"rotl", OpCode::Rotl, 2},         {"rotr", OpCode::Rotr, 2}};
+
+// C precedence, higher binds tighter; 0 if not a binary operator
+int binaryPrecedence(std::string_view op, OpCode &code) {
+  struct Entry {
+    const char *text;
+    OpCode op;
+    int precedence;
+  };
+  static constexpr Entry kOperators[] = {
+      {"||", OpCode::LogicalOr, 1},     {"&&", OpCode::LogicalAnd, 2},
+      {"|", OpCode::Or, 3},             {"^", OpCode::Xor, 4},
+      {"&", OpCode::And, 5},            {"==", OpCode::Equal, 6},
+      {"!=", OpCode::NotEqual, 6},      {"<", OpCode::Less, 7},
+      {"<=", OpCode::LessEqual, 7},     {">", OpCode::Greater, 7},
+      {">=", OpCode::GreaterEqual, 7},  {"<<", OpCode::Shl, 8},
+      {">>", OpCode::Shr, 8},           {"+", OpCode::Add, 9},
+      {"-", OpCode::Sub, 9},            {"*", OpCode::Mul, 10},
+      {"/", OpCode::Div, 10},           {"%", OpCode::Mod, 10}};
+  for (const auto &entry : kOperators) {
+    if (op == entry.text) {
+      code = entry.op;
+      return entry.precedence;
+    }
+  }
+  return 0;
+}
+
+} // namespace
+
+// Recursive descent over the C grammar, emitting postfix code directly
+class IntegerParser {
+public:
+  IntegerParser(std::string_view text, IntegerExpression &expr)
+      : text_(text), expr_(expr) {}
+
+  void parse() {
+    next();
+    parseBinary(1);
+    if (kind_ != Kind::End)
+      throw std::runtime_error("Invalid expression");
+  }
+
+private:
+  enum class Kind { Number, Identifier, Operator, Open, Close, Comma, End };
+
+  void next() {
+    while (pos_ < text_.size() &&
+           std::isspace(static_cast<unsigned char>(text_[pos_])))
+      ++pos_;
+    if (pos_ == text_.size()) {
+      kind_ = Kind::End;
+      token_ = {};
+      return;
+    }
+
+    size_t start = pos_;
+    char c = text_[pos_];
+    if (std::isdigit(static_cast<unsigned char>(c))) {
+      readNumber();
+    } else if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+      while (pos_ < text_.size() &&
+             (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+              text_[pos_] == '_'))
+        ++pos_;
+      kind_ = Kind::Identifier;
+    } else if (c == '(' || c == ')' || c == ',') {
+      ++pos_;
+      kind_ = c == '(' ? Kind::Open : c == ')' ? Kind::Close : Kind::Comma;
+    } else {
+      static constexpr const char *kTwoChar[] = {"<<", ">>", "<=", ">=",
+                                                 "==", "!=", "&&", "||"};
+      kind_ = Kind::Operator;
+      ++pos_;
+      for (const char *op : kTwoChar) {
+        if (text_.substr(start, 2) == op) {
+          ++pos_;
+          break;
+        }
+      }
+      if (pos_ - start == 1 && !std::strchr("+-*/%&|^~!<>", c))
+        throw std::runtime_error("Invalid character: " + std::string(1, c));
+    }
+    token_ = text_.substr(start, pos_ - start);
+  }
+
+  void readNumber() {
+    unsigned base = 10;
+    if (text_[pos_] == '0' && pos_ + 1 < text_.size()) {
+      char prefix = static_cast<char>(std::tolower(text_[pos_ + 1]));
+      base = prefix == 'x' ? 16 : prefix == 'b' ? 2 : prefix == 'o' ? 8 : 10;
+      if (base != 10)
+        pos_ += 2;
+    }
+
+    // Digits may be grouped with '_' (0xFFFF_0000)
+    size_t start = pos_;
+    const Word limit = ~Word(0);
+    Word value = 0;
+    size_t digits = 0;
+    while (pos_ < text_.size() &&
+           (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+            text_[pos_] == '_')) {
+      char c = static_cast<char>(std::tolower(text_[pos_++]));
+      if (c == '_')
+        continue;
+      unsigned digit = std::isdigit(static_cast<unsigned char>(c))
+                           ? static_cast<unsigned>(c - '0')
+                           : static_cast<unsigned>(c - 'a' + 10);
+      if (digit >= base) {
+        throw std::runtime_error(
+            "Invalid number: " +
+            std::string(text_.substr(start, pos_ - start)));
+      }
+      if (value > (limit - digit) / base)
+        throw std::out_of_range("Integer literal out of range");
+      value = value * base + digit;
+      ++digits;
+    }
+    if (digits == 0)
+      throw std::runtime_error("Invalid number");
+    kind_ = Kind::Number;
+    value_ = value;
+  }
+
+  void emit(OpCode op, uint32_t operand, int stackEffect) {
+    expr_.code_.push_back({op, operand});
+    depth_ += stackEffect;
+    expr_.maxStackDepth_ = std::max(expr_.maxStackDepth_, depth_);
+  }
+
+  // Parentheses, calls and unary operators nested deeper than this are
+  // rejected so that hostile input cannot exhaust the stack
+  static constexpr size_t kMaxNesting = 256;
+
+  void enter() {
+    if (++nesting_ > kMaxNesting)
+      throw std::runtime_error("Expression nested too deeply");
+  }
+
+  void parseBinary(int minPrecedence) {
+    parseUnary();
+    OpCode op = OpCode::Add;
+    int precedence;
+    while (kind_ == Kind::Operator &&
+           (precedence = binaryPrecedence(token_, op)) >= minPrecedence) {
+      next();
+      // Left associative: the right operand only takes tighter operators
+      parseBinary(precedence + 1);
+      emit(op, 0, -1);
+    }
+  }
+
+  void parseUnary() {
+    if (kind_ == Kind::Operator &&
+        (token_ == "-" || token_ == "+" || token_ == "~" || token_ == "!")) {
+      char op = token_[0];
+      next();
+      enter();
+      parseUnary();
+      --nesting_;
+      if (op == '-')
+        emit(OpCode::Neg, 0, 0);
+      else if (op == '~')
+        emit(OpCode::Not, 0, 0);
+      else if (op == '!')
+        emit(OpCode::LogicalNot, 0, 0);
+      return;
+    }
+    parsePrimary();
+  }
+
+  void parsePrimary() {
+    switch (kind_) {
+    case Kind::Number:
+      expr_.constants_.push_back(value_);
+      emit(OpCode::PushConst,
+           static_cast<uint32_t>(expr_.constants_.size() - 1), 1);
+      next();
+      return;
+    case Kind::Open:
+      next();
+      enter();
+      parseBinary(1);
+      --nesting_;
+      if (kind_ != Kind::Close)
+        throw std::runtime_error("Missing closing parenthesis");
+      next();
+      return;
+    case Kind::Identifier: {
+      std::string name(token_);
+      next();
+      if (kind_ == Kind::Open) {
+        parseCall(name);
+        return;
+      }
+      size_t slot = expr_.variableIndex(name);
+      if (slot == IntegerExpression::npos) {
+        slot = expr_.variables_.size();
+        expr_.variables_.push_back(name);
+      }
+      emit(OpCode::LoadVar, static_cast<uint32_t>(slot), 1);
+      return;
+    }
+    default:
+      throw std::runtime_error("Invalid expression");
+    }
+  }
+
+  void parseCall(const std::string &name) {
+    const Function *function = nullptr;
+    for (const auto &candidate : kFunctions) {
+      if (name == candidate.name)
+        function = &candidate;
+    }
+    if (!function)
+      throw std::runtime_error("Unknown function: " + name);
+
+    next();
+    enter();
+    for (int i = 0; i < function->arity; ++i) {
+      if (i > 0) {
+        if (kind_ != Kind::Comma)
+          throw std::runtime_error(name + " takes " +
+                                   std::to_string(function->arity) +
+                                   " arguments");
+        next();
+      }
+      parseBinary(1);
+    }
+    --nesting_;
+    if (kind_ != Kind::Close)
+      throw std::runtime_error("Missing closing parenthesis");
+    next();
+    emit(function->op, 0, 1 - function->arity);
+  }
+
+  std::string_view text_;
+  IntegerExpression &expr_;
+  size_t pos_ = 0;
+  Kind kind_ = Kind::End;
+  std::string_view token_;
+  Word value_ = 0;
+  size_t depth_ = 0;
+  size_t nesting_ = 0;
+};
+
+IntegerExpression::Type IntegerExpression::Type::parse(std::string_view name) {
+  Type type;
+  if (name.size() >= 2 && (name[0] == 'i' || name[0] == 'u')) {
+    type.isSigned = name[0] == 'i';
+    std::string_view bits = name.substr(1);
+    for (unsigned width : {8u, 16u, 32u, 64u, 128u}) {
+      if (bits == std::to_string(width)) {
+        type.bits = width;
+        return type;
+      }
+    }
+  }
+  throw std::invalid_argument("Unknown integer type: " + std::string(name) +
+                              ". Use i8..i128 or u8..u128");
+}
+
+std::string IntegerExpression::Type::name() const {
+  return (isSigned ? "i" : "u") + std::to_string(bits);
+}
+
+IntegerExpression IntegerExpression::compile(std::string_view text,
+                                             Type type) {
+  IntegerExpression expr;
+  expr.type_ = Type::parse(type.name()); // rejects unsupported widths
+  IntegerParser(text, expr).parse();
+  return expr;
+}
+
+IntegerExpression IntegerExpression::compile(std::string_view text) {
+  return compile(text, Type());
+}
+
+Word IntegerExpression::evaluate() const {
+  if (!variables_.empty())
+    throw std::runtime_error("Unknown variable: " + variables_.front());
+  return evaluate(nullptr);
+}
+
+Word IntegerExpression::evaluate(const Word *variables) const {
+  if (code_.empty())
+    throw std::runtime_error("Invalid expression");
+  if (type_.bits > 64)
+    return evaluateAs<Word>(variables);
+
+  uint64_t result = evaluateAs<uint64_t>(variables);
+  return type_.isSigned ? Word(__int128(static_cast<int64_t>(result)))
+                        : Word(result);
+}
+
+Word IntegerExpression::evaluate(const std::vector<Word> &variables) const {
+  if (variables.size() != variables_.size())
+    throw std::invalid_argument("Variable count mismatch");
+  return evaluate(variables.data());
+}
+
+template <typename U>
+void IntegerExpression::evaluateBatch(const U *const *columns, size_t rows,
+                                      U *out) const {
+  if (code_.empty())
+    throw std::runtime_error("Invalid expression");
+  if (sizeof(U) * 8 < type_.bits)
+    throw std::invalid_argument("Batch columns are narrower than " +
+                                type_.name());
+  if (rows == 0)
+    return;
+
+  std::vector<U> stack(maxStackDepth_ * kBatchBlockSize);
+  for (size_t first = 0; first < rows; first += kBatchBlockSize) {
+    size_t count = std::min(kBatchBlockSize, rows - first);
+    runBlock(stack.data(), kBatchBlockSize, columns, first, count);
+    std::memcpy(out + first, stack.data(), count * sizeof(U));
+  }
+}
+
+template void IntegerExpression::evaluateBatch<uint64_t>(
+    const uint64_t *const *, size_t, uint64_t *) const;
+template void IntegerExpression::evaluateBatch<Word>(const Word *const *,
+                                                     size_t, Word *) const;
+
+std::string IntegerExpression::toString(Word value, Type type,
+                                        unsigned base) {
+  Lanes<Word> lanes(type);
+  value = lanes.wrap(value);
+  std::string digits;
+
+  switch (base) {
+  case 10: {
+    bool negative = type.isSigned && (value >> 127) != 0;
+    Word magnitude = negative ? 0 - value : value;
+    do {
+      digits += static_cast<char>('0' + static_cast<int>(magnitude % 10));
+      magnitude /= 10;
+    } while (magnitude != 0);
+    if (negative)
+      digits += '-';
+    break;
+  }
+  case 16: {
+    Word bits = lanes.low(value);
+    do {
+      digits += "0123456789ABCDEF"[static_cast<int>(bits & 15)];
+      bits >>= 4;
+    } while (bits != 0);
+    digits += "x0";
+    break;
+  }
+  case 2:
+    for (unsigned i = 0; i < type.bits; ++i)
+      digits += static_cast<char>('0' + static_cast<int>((value >> i) & 1));
+    break;
+  default:
+    throw std::invalid_argument("Unsupported base: " + std::to_string(base));
+  }
+
+  std::reverse(digits.begin(), digits.end());
+  return digits;
+}
+
+size_t IntegerExpression::variableIndex(const std::string &name) const {
+  auto it = std::find(variables_.begin(), variables_.end(), name);
+  return it == variables_.end() ? npos : it - variables_.begin();
+}
+
+template <typename U>
+U IntegerExpression::evaluateAs(const Word *variables) const {
+  // A block of one row; stack and variable columns live on the C++ stack
+  // unless the expression is unusually large
+  U inlineStack[kInlineSize];
+  U inlineValues[kInlineSize];
+  const U *inlineColumns[kInlineSize];
+  std::vector<U> heapStack, heapValues;
+  std::vector<const U *> heapColumns;
+
+  U *stack = inlineStack;
+  U *values = inlineValues;
+  const U **columns = inlineColumns;
+  if (maxStackDepth_ > kInlineSize) {
+    heapStack.resize(maxStackDepth_);
+    stack = heapStack.data();
+  }
+  if (variables_.size() > kInlineSize) {
+    heapValues.resize(variables_.size());
+    heapColumns.resize(variables_.size());
+    values = heapValues.data();
+    columns = heapColumns.data();
+  }
+  for (size_t i = 0; i < variables_.size(); ++i) {
+    values[i] = static_cast<U>(variables[i]);
+    columns[i] = values + i;
+  }
+
+  runBlock(stack, 1, columns, 0, 1);
+  return stack[0];
+}
+
+template <typename U>
+void IntegerExpression::runBlock(U *stack, size_t stride,
+                                 const U *const *columns, size_t first,
+                                 size_t count) const {
+  // Each opcode is a flat loop over the rows of the block. Stack balance
+  // and arity are guaranteed by the parser.
+  using S = typename SignedOf<U>::type;
+  const Lanes<U> w(type_);
+  const size_t n = count;
+  const U width = w.bits;
+  U *top = stack - stride;
+
+  for (const auto &ins : code_) {
+    U *a = top - stride;
+    switch (ins.op) {
+    case OpCode::PushConst:
+      top += stride;
+      std::fill(top, top + n, w.wrap(static_cast<U>(constants_[ins.operand])));
+      break;
+    case OpCode::LoadVar: {
+      top += stride;
+      const U *column = columns[ins.operand] + first;
+      for (size_t i = 0; i < n; ++i)
+        top[i] = w.wrap(column[i]);
+      break;
+    }
+    case OpCode::Neg:
+      unary(top, n, [&](U x) { return w.wrap(0 - x); });
+      break;
+    case OpCode::Not:
+      unary(top, n, [&](U x) { return w.wrap(~x); });
+      break;
+    case OpCode::LogicalNot:
+      unary(top, n, [](U x) { return U(x == 0); });
+      break;
+    case OpCode::Add:
+      binary(a, top, n, [&](U x, U y) { return w.wrap(x + y); });
+      top = a;
+      break;
+    case OpCode::Sub:
+      binary(a, top, n, [&](U x, U y) { return w.wrap(x - y); });
+      top = a;
+      break;
+    case OpCode::Mul:
+      binary(a, top, n, [&](U x, U y) { return w.wrap(x * y); });
+      top = a;
+      break;
+    case OpCode::Div:
+      checkDivisors(top, n);
+      if (w.isSigned) {
+        // MIN / -1 overflows S when the width is the whole word
+        binary(a, top, n, [&](U x, U y) {
+          return y == ~U(0) ? w.wrap(0 - x) : w.wrap(U(S(x) / S(y)));
+        });
+      } else {
+        binary(a, top, n, [](U x, U y) { return x / y; });
+      }
+      top = a;
+      break;
+    case OpCode::Mod:
+      checkDivisors(top, n);
+      if (w.isSigned) {
+        binary(a, top, n,
+               [](U x, U y) { return y == ~U(0) ? U(0) : U(S(x) % S(y)); });
+      } else {
+        binary(a, top, n, [](U x, U y) { return x % y; });
+      }
+      top = a;
+      break;
+    case OpCode::Shl:
+      binary(a, top, n, [&](U x, U y) {
+        U shift = w.low(y);
+        return shift >= width ? U(0) : w.wrap(x << shift);
+      });
+      top = a;
+      break;
+    case OpCode::Shr:
+      if (w.isSigned) {
+        binary(a, top, n, [&](U x, U y) {
+          U shift = std::min(w.low(y), width - 1);
+          return U(S(x) >> shift);
+        });
+      } else {
+        binary(a, top, n, [&](U x, U y) {
+          U shift = w.low(y);
+          return shift >= width ? U(0) : x >> shift;
+        });
+      }
+      top = a;
+      break;
+    case OpCode::Less:
+      binary(a, top, n, [&](U x, U y) {
+        return U(w.isSigned ? S(x) < S(y) : x < y);
+      });
+      top = a;
+      break;
+    case OpCode::LessEqual:
+      binary(a, top, n, [&](U x, U y) {
+        return U(w.isSigned ? S(x) <= S(y) : x <= y);
+      });
+      top = a;
+      break;
+    case OpCode::Greater:
+      binary(a, top, n, [&](U x, U y) {
+        return U(w.isSigned ? S(x) > S(y) : x > y);
+      });
+      top = a;
+      break;
+    case OpCode::GreaterEqual:
+      binary(a, top, n, [&](U x, U y) {
+        return U(w.isSigned ? S(x) >= S(y) : x >= y);
+      });
+      top = a;
+      break;
+    case OpCode::Equal:
+      binary(a, top, n, [](U x, U y) { return U(x == y); });
+      top = a;
+      break;
+    case OpCode::NotEqual:
+      binary(a, top, n, [](U x, U y) { return U(x != y); });
+      top = a;
+      break;
+    case OpCode::And:
+      binary(a, top, n, [](U x, U y) { return x & y; });
+      top = a;
+      break;
+    case OpCode::Xor:
+      binary(a, top, n, [](U x, U y) { return x ^ y; });
+      top = a;
+      break;
+    case OpCode::Or:
+      binary(a, top, n, [](U x, U y) { return x | y; });
+      top = a;
+      break;
+    case OpCode::LogicalAnd:
+      binary(a, top, n, [](U x, U y) { return U(x != 0 && y != 0); });
+      top = a;
+      break;
+    case OpCode::LogicalOr:
+      binary(a, top, n, [](U x, U y) { return U(x != 0 || y != 0); });
+      top = a;
+      break;
+    case OpCode::Popcount:
+      unary(top, n, [&](U x) { return U(popcount(w.low(x))); });
+      break;
+    case OpCode::Clz:
+      unary(top, n, [&](U x) { return width - bitLength(w.low(x)); });
+      break;
+    case OpCode::Ctz:
+      unary(top, n, [&](U x) { return x == 0 ? width : U(trailingZeros(x)); });
+      break;
+    case OpCode::Bswap:
+      unary(top, n, [&](U x) { return w.wrap(byteSwap(x) >> w.unused); });
+      break;
+    case OpCode::Rotl:
+    case OpCode::Rotr: {
+      // Widths are powers of two, so & (width - 1) is the modulo and a
+      // right rotation is a left one by the complement
+      const U sign = ins.op == OpCode::Rotl ? 0 : ~U(0);
+      binary(a, top, n, [&](U x, U y) {
+        U shift = ((y ^ sign) + (sign & 1)) & (width - 1);
+        U bits = w.low(x);
+        U back = (width - shift) & (width - 1);
+        return w.wrap((bits << shift) | (bits >> back));
+      });
+      top = a;
+      break;
+    }
+    }
+  }
+}
@@ -0,0 +1,162 @@
+#ifndef INTEGEREXPRESSION_H
+#define INTEGEREXPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Integer expression compiled once to bytecode, in a fixed width
+ *
+ * The syntax is C's integer expression language with C precedence:
+ *   || && | ^ & (== !=) (< <= > >=) (<< >>) (+ -) (* / %)
+ * plus unary - + ~ !, parentheses, and the functions popcount(x),
+ * clz(x), ctz(x), bswap(x), rotl(x, n) and rotr(x, n). Literals are
+ * decimal, 0x hex, 0o octal or 0b binary; other identifiers are
+ * variables, numbered in order of first appearance.
+ *
+ * Every result is reduced to the selected width, 8 to 128 bits, signed
+ * or unsigned, so arithmetic wraps exactly as in a register of that
+ * size. Unlike C nothing is undefined: shifting by the width or more
+ * gives 0 (or all sign bits for a signed >>), MIN / -1 wraps to MIN,
+ * clz(0) and ctz(0) are the width, and && and || evaluate both sides.
+ * Division by zero throws.
+ *
+ * Widths up to 64 bits run on uint64_t, 128 bits on unsigned __int128.
+ */
+class IntegerExpression {
+public:
+  using Word = unsigned __int128;
+
+  struct Type {
+    unsigned bits = 64; // 8, 16, 32, 64 or 128
+    bool isSigned = true;
+
+    /**
+     * @brief "i8" .. "i128" or "u8" .. "u128"
+     * @throws std::invalid_argument for other names
+     */
+    static Type parse(std::string_view name);
+    std::string name() const;
+  };
+
+  enum class OpCode : uint8_t {
+    PushConst,
+    LoadVar,
+    Neg,
+    Not,
+    LogicalNot,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Shl,
+    Shr,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Equal,
+    NotEqual,
+    And,
+    Xor,
+    Or,
+    LogicalAnd,
+    LogicalOr,
+    Popcount,
+    Clz,
+    Ctz,
+    Bswap,
+    Rotl,
+    Rotr
+  };
+
+  struct Instruction {
+    OpCode op;
+    // Constant pool index for PushConst, variable slot for LoadVar
+    uint32_t operand;
+  };
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  /**
+   * @brief Compile for `type`; i64 when omitted
+   * @throws std::runtime_error for malformed expressions, unknown
+   *         functions and nesting deeper than 256 levels
+   * @throws std::out_of_range for literals above 128 bits
+   */
+  static IntegerExpression compile(std::string_view text, Type type);
+  static IntegerExpression compile(std::string_view text);
+
+  /**
+   * @brief Evaluate an expression without variables
+   * @return The result, sign-extended for signed types
+   * @throws std::runtime_error on division by zero or if the expression
+   *         references variables
+   */
+  Word evaluate() const;
+
+  /**
+   * @param variables One value per entry of variables(); only the low
+   *        bits of the width are used
+   */
+  Word evaluate(const Word *variables) const;
+  Word evaluate(const std::vector<Word> &variables) const;
+
+  /**
+   * @brief Evaluate over many rows of struct-of-arrays input
+   * @tparam U uint64_t (widths up to 64 bits) or Word
+   * @param columns columns[i] points to `rows` values of variables()[i]
+   * @param out Receives `rows` results, sign-extended for signed types
+   *
+   * Rows are processed in blocks, each opcode running as a tight loop
+   * over the whole block.
+   * @throws std::runtime_error if any row divides by zero
+   * @throws std::invalid_argument if U is narrower than the width
+   */
+  template <typename U>
+  void evaluateBatch(const U *const *columns, size_t rows, U *out) const;
+
+  /**
+   * @brief Text of a result in base 10 (signed as the type is), 16 ("0x"
+   *        prefix) or 2 (all bits of the width)
+   */
+  static std::string toString(Word value, Type type, unsigned base = 10);
+
+  /**
+   * @brief Slot of a variable name, or npos if not referenced
+   */
+  size_t variableIndex(const std::string &name) const;
+
+  const std::vector<std::string> &variables() const { return variables_; }
+  const std::vector<Instruction> &code() const { return code_; }
+  Type type() const { return type_; }
+  size_t maxStackDepth() const { return maxStackDepth_; }
+
+private:
+  friend class IntegerParser;
+
+  // Rows per block in evaluateBatch
+  static constexpr size_t kBatchBlockSize = 256;
+  // Stack slots and variables evaluate() keeps off the heap
+  static constexpr size_t kInlineSize = 64;
+
+  std::vector<Instruction> code_;
+  std::vector<Word> constants_;
+  std::vector<std::string> variables_;
+  Type type_;
+  size_t maxStackDepth_ = 0;
+
+  // Runs the program over rows [first, first + count); stack slot i
+  // starts at stack + i * stride and the result is left in slot 0
+  template <typename U>
+  void runBlock(U *stack, size_t stride, const U *const *columns,
+                size_t first, size_t count) const;
+
+  template <typename U> U evaluateAs(const Word *variables) const;
+};
+
+#endif // INTEGEREXPRESSION_H
@@ -0,0 +1,339 @@
+#ifndef MATHKERNELS_H
+#define MATHKERNELS_H
+
+// Internal to MathUtils: branch-free, fixed-degree kernels for the batch
+// math functions. Every kernel is a template over a lane type V, which is
+// either plain double or a GCC/Clang vector of doubles. Each ISA-specific
+// translation unit instantiates them with its own vector width and is
+// compiled with the matching -m flags.
+//
+// Everything below the table declaration lives in an anonymous namespace on
+// purpose: the same inline code is compiled with different target flags in
+// different TUs, so it must never be merged by the linker.
+
+#include "MathUtils.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+struct MathKernelTable {
+  const char *name;
+  void (*sin)(const double *in, double *out, size_t n);
+  void (*cos)(const double *in, double *out, size_t n);
+  void (*exp)(const double *in, double *out, size_t n);
+  void (*log)(const double *in, double *out, size_t n);
+  void (*sqrt)(const double *in, double *out, size_t n);
+};
+
+const MathKernelTable &mathKernelsBaseline();
+#ifdef MATHUTILS_X86_SIMD
+const MathKernelTable &mathKernelsAVX2();
+const MathKernelTable &mathKernelsAVX512();
+#endif
+
+namespace {
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MATHKERNELS_VECTOR_EXTENSIONS 1
+typedef double mk_v2d __attribute__((vector_size(16)));
+typedef double mk_v4d __attribute__((vector_size(32)));
+typedef double mk_v8d __attribute__((vector_size(64)));
+typedef int64_t mk_v2i __attribute__((vector_size(16)));
+typedef int64_t mk_v4i __attribute__((vector_size(32)));
+typedef int64_t mk_v8i __attribute__((vector_size(64)));
+#endif
+
+// Per-lane-type helpers. Comparisons yield bool for double and an all-ones
+// integer mask for vectors; select() accepts either.
+template <typename V> struct Lanes;
+
+template <> struct Lanes<double> {
+  using I = int64_t;
+  static constexpr size_t kWidth = 1;
+
+  static double load(const double *p) { return *p; }
+  static void store(double *p, double v) { *p = v; }
+  static I bits(double v) {
+    I i;
+    std::memcpy(&i, &v, sizeof(i));
+    return i;
+  }
+  static double fromBits(I i) {
+    double v;
+    std::memcpy(&v, &i, sizeof(v));
+    return v;
+  }
+  static double select(bool mask, double a, double b) { return mask ? a : b; }
+  static I selectInt(bool mask, I a, I b) { return mask ? a : b; }
+};
+
+#ifdef MATHKERNELS_VECTOR_EXTENSIONS
+template <typename VD, typename VI, size_t W> struct VectorLanes {
+  using I = VI;
+  static constexpr size_t kWidth = W;
+
+  static VD load(const double *p) {
+    VD v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+  static void store(double *p, VD v) { std::memcpy(p, &v, sizeof(v)); }
+  static I bits(VD v) { return (I)v; }
+  static VD fromBits(I i) { return (VD)i; }
+  static VD select(I mask, VD a, VD b) {
+    return (VD)((mask & (I)a) | (~mask & (I)b));
+  }
+  static I selectInt(I mask, I a, I b) { return (mask & a) | (~mask & b); }
+};
+
+template <> struct Lanes<mk_v2d> : VectorLanes<mk_v2d, mk_v2i, 2> {};
+template <> struct Lanes<mk_v4d> : VectorLanes<mk_v4d, mk_v4i, 4> {};
+template <> struct Lanes<mk_v8d> : VectorLanes<mk_v8d, mk_v8i, 8> {};
+#endif
+
+// 1.5 * 2^52: adding and subtracting it rounds to the nearest integer, and
+// the low mantissa bits of the sum hold that integer in two's complement.
+constexpr double kRoundMagic = 6755399441055744.0;
+constexpr int64_t kRoundMagicBits = 0x4338000000000000LL;
+constexpr int64_t kSignBit = INT64_MIN;
+
+// Largest |x| for which three-part Cody-Waite reduction by pi/2 is exact
+// enough; beyond it MathUtils falls back to Payne-Hanek reduction.
+constexpr double kMaxCodyWaite = 1.0e6;
+
+constexpr double kTwoOverPi = 6.36619772367581382433e-01;
+constexpr double kPio2_1 = 1.57079632673412561417e+00;
+constexpr double kPio2_2 = 6.07710050630396597660e-11;
+constexpr double kPio2_3 = 2.02226624871116645580e-21;
+
+constexpr double kLn2Hi = 6.93147180369123816490e-01;
+constexpr double kLn2Lo = 1.90821492927058770002e-10;
+constexpr double kLog2E = 1.44269504088896338700e+00;
+
+template <typename V> inline V intToDouble(typename Lanes<V>::I i) {
+  // Exact for |i| < 2^51, which covers exponents and quadrants
+  return Lanes<V>::fromBits(i + kRoundMagicBits) - kRoundMagic;
+}
+
+// Minimax sin/cos on [-pi/4, pi/4] (fdlibm __kernel_sin/__kernel_cos)
+template <typename V> inline V sinPoly(V r) {
+  V z = r * r;
+  V p = V{} + 1.58969099521155010221e-10;
+  p = p * z + -2.50507602534068634195e-08;
+  p = p * z + 2.75573137070700676789e-06;
+  p = p * z + -1.98412698298579493134e-04;
+  p = p * z + 8.33333333332248946124e-03;
+  p = p * z + -1.66666666666666324348e-01;
+  return r + r * z * p;
+}
+
+template <typename V> inline V cosPoly(V r) {
+  V z = r * r;
+  V p = V{} + -1.13596475577881948265e-11;
+  p = p * z + 2.08757232129817482790e-09;
+  p = p * z + -2.75573143513906633035e-07;
+  p = p * z + 2.48015872894767294178e-05;
+  p = p * z + -1.38888888888741095749e-03;
+  p = p * z + 4.16666666666666019037e-02;
+  return 1.0 - 0.5 * z + z * z * p;
+}
+
+// Reduce x to r in [-pi/4, pi/4] and return the quadrant k mod 4
+template <typename V>
+inline typename Lanes<V>::I reducePio2(V x, V &r) {
+  using L = Lanes<V>;
+  V t = x * kTwoOverPi + kRoundMagic;
+  typename L::I quadrant = L::bits(t) & 3;
+  V k = t - kRoundMagic;
+  r = ((x - k * kPio2_1) - k * kPio2_2) - k * kPio2_3;
+  return quadrant;
+}
+
+// sin/cos of q*pi/2 + r, given the reduced argument and quadrant
+template <typename V>
+inline V sinQuadrant(V r, typename Lanes<V>::I q) {
+  using L = Lanes<V>;
+  V s = sinPoly(r);
+  V c = cosPoly(r);
+  // Quadrants 1 and 3 use cos, quadrants 2 and 3 flip the sign
+  V v = L::select((q & 1) != 0, c, s);
+  return L::fromBits(L::bits(v) ^ (-((q >> 1) & 1) & kSignBit));
+}
+
+template <typename V>
+inline V cosQuadrant(V r, typename Lanes<V>::I q) {
+  using L = Lanes<V>;
+  V s = sinPoly(r);
+  V c = cosPoly(r);
+  V v = L::select((q & 1) != 0, s, c);
+  return L::fromBits(L::bits(v) ^ (-(((q + 1) >> 1) & 1) & kSignBit));
+}
+
+template <typename V> inline V sinKernel(V x) {
+  V r;
+  typename Lanes<V>::I q = reducePio2(x, r);
+  return sinQuadrant(r, q);
+}
+
+template <typename V> inline V cosKernel(V x) {
+  V r;
+  typename Lanes<V>::I q = reducePio2(x, r);
+  return cosQuadrant(r, q);
+}
+
+template <typename V> inline V expKernel(V x) {
+  using L = Lanes<V>;
+  // Clamp so the scale factors below stay representable; the clamped
+  // values still overflow to inf / underflow to 0 as expected. NaN passes.
+  x = L::select(x > 710.0, V{} + 710.0, x);
+  x = L::select(x < -746.0, V{} - 746.0, x);
+
+  V t = x * kLog2E + kRoundMagic;
+  typename L::I k = L::bits(t) - kRoundMagicBits;
+  V kd = t - kRoundMagic;
+  V r = (x - kd * kLn2Hi) - kd * kLn2Lo;
+
+  // Taylor polynomial of degree 13 on |r| <= ln(2)/2, error < 1e-17
+  V p = V{} + 1.0 / 6227020800.0;
+  p = p * r + 1.0 / 479001600.0;
+  p = p * r + 1.0 / 39916800.0;
+  p = p * r + 1.0 / 3628800.0;
+  p = p * r + 1.0 / 362880.0;
+  p = p * r + 1.0 / 40320.0;
+  p = p * r + 1.0 / 5040.0;
+  p = p * r + 1.0 / 720.0;
+  p = p * r + 1.0 / 120.0;
+  p = p * r + 1.0 / 24.0;
+  p = p * r + 1.0 / 6.0;
+  p = p * r + 0.5;
+  p = p * r + 1.0;
+  p = p * r + 1.0;
+
+  // Scale by 2^k in two steps so k near the limits does not overflow the
+  // exponent field
+  typename L::I k1 = k >> 1;
+  typename L::I k2 = k - k1;
+  V s1 = L::fromBits((k1 + 1023) << 52);
+  V s2 = L::fromBits((k2 + 1023) << 52);
+  return p * s1 * s2;
+}
+
+template <typename V> inline V logKernel(V x) {
+  using L = Lanes<V>;
+  using I = typename L::I;
+
+  // Bring subnormals into the normal range first
+  auto tiny = x < 2.2250738585072014e-308;
+  V xs = L::select(tiny, x * 4503599627370496.0, x); // 2^52
+  I ix = L::bits(xs);
+  I e = ((ix >> 52) & 0x7ff) - 1023;
+  e = L::selectInt(tiny, e - 52, e);
+
+  // Mantissa in [sqrt(2)/2, sqrt(2))
+  V m = L::fromBits((ix & 0x000fffffffffffffLL) | 0x3ff0000000000000LL);
+  auto big = m > 1.41421356237309504880;
+  m = L::select(big, m * 0.5, m);
+  e = L::selectInt(big, e + 1, e);
+
+  // log(1+f) = f - hfsq + s*(hfsq+R), minimax R (fdlibm __ieee754_log)
+  V f = m - 1.0;
+  V s = f / (2.0 + f);
+  V z = s * s;
+  V w = z * z;
+  V t1 = w * (3.999999999940941908e-01 +
+              w * (2.222219843214978396e-01 + w * 1.531383769920937332e-01));
+  V t2 = z * (6.666666666666735130e-01 +
+              w * (2.857142874366239149e-01 +
+                   w * (1.818357216161805012e-01 +
+                        w * 1.479819860511658591e-01)));
+  V R = t1 + t2;
+  V hfsq = 0.5 * f * f;
+  V dk = intToDouble<V>(e);
+  V result = dk * kLn2Hi - ((hfsq - (s * (hfsq + R) + dk * kLn2Lo)) - f);
+
+  // IEEE special cases: log(0) = -inf, log(<0) = NaN, log(inf) = inf
+  const double inf = Lanes<double>::fromBits(0x7ff0000000000000LL);
+  const double nan = Lanes<double>::fromBits(0x7ff8000000000000LL);
+  result = L::select(x == inf, V{} + inf, result);
+  result = L::select(x == 0.0, V{} - inf, result);
+  result = L::select(x < 0.0, V{} + nan, result);
+  return L::select(x != x, x, result);
+}
+
+template <typename V> inline V sqrtKernel(V x) {
+  using L = Lanes<V>;
+  // Scale subnormals up by 2^54 so the bit-level guess is accurate
+  auto tiny = x < 2.2250738585072014e-308;
+  V xs = L::select(tiny, x * 18014398509481984.0, x);
+
+  // Halving the exponent gives a guess within ~6%; four Newton steps
+  // bring that below one ulp.
+  V g = L::fromBits((L::bits(xs) >> 1) + 0x1ff8000000000000LL);
+  g = 0.5 * (g + xs / g);
+  g = 0.5 * (g + xs / g);
+  g = 0.5 * (g + xs / g);
+  g = 0.5 * (g + xs / g);
+  g = L::select(tiny, g * 7.450580596923828125e-09, g); // 2^-27
+
+  const double inf = Lanes<double>::fromBits(0x7ff0000000000000LL);
+  const double nan = Lanes<double>::fromBits(0x7ff8000000000000LL);
+  g = L::select(x == inf, V{} + inf, g);
+  g = L::select(x == 0.0, x, g); // keeps the sign of -0
+  return L::select(x < 0.0, V{} + nan, g);
+}
+
+// Run a kernel over an array: full vectors first, then the tail padded
+// with 1.0 (a safe input for every kernel). `in` and `out` may alias.
+template <typename V, V (*Kernel)(V)>
+void applyKernel(const double *in, double *out, size_t n) {
+  using L = Lanes<V>;
+  constexpr size_t W = L::kWidth;
+  size_t i = 0;
+  for (; i + W <= n; i += W)
+    L::store(out + i, Kernel(L::load(in + i)));
+  if (i < n) {
+    double buf[W];
+    for (size_t j = 0; j < W; ++j)
+      buf[j] = (i + j < n) ? in[i + j] : 1.0;
+    L::store(buf, Kernel(L::load(buf)));
+    for (size_t j = 0; i + j < n; ++j)
+      out[i + j] = buf[j];
+  }
+}
+
+// Same as applyKernel for sin/cos, but lanes whose argument is too large
+// for Cody-Waite reduction are recomputed with the scalar routine.
+template <typename V, V (*Kernel)(V), double (*Scalar)(double)>
+void applyTrigKernel(const double *in, double *out, size_t n) {
+  using L = Lanes<V>;
+  constexpr size_t W = L::kWidth;
+  for (size_t i = 0; i < n; i += W) {
+    double x[W], y[W];
+    size_t count = (n - i < W) ? n - i : W;
+    for (size_t j = 0; j < W; ++j)
+      x[j] = (j < count) ? in[i + j] : 0.0;
+    L::store(y, Kernel(L::load(x)));
+    for (size_t j = 0; j < count; ++j) {
+      double a = x[j] < 0 ? -x[j] : x[j];
+      if (a > kMaxCodyWaite && a <= 1.7976931348623157e308)
+        y[j] = Scalar(x[j]);
+      out[i + j] = y[j];
+    }
+  }
+}
+
+template <typename V> const MathKernelTable &makeKernelTable(const char *name) {
+  static const MathKernelTable table = {
+      name,
+      applyTrigKernel<V, sinKernel<V>, MathUtils::my_sin>,
+      applyTrigKernel<V, cosKernel<V>, MathUtils::my_cos>,
+      applyKernel<V, expKernel<V>>,
+      applyKernel<V, logKernel<V>>,
+      applyKernel<V, sqrtKernel<V>>,
+  };
+  return table;
+}
+
+} // namespace
+
+#endif // MATHKERNELS_H
@@ -1,76 +1,140 @@
 #include "MathUtils.h"
+#include "MathKernels.h"
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <stdexcept>
 
-const double MathUtils::PI = 3.14159265358979323846;
-const double MathUtils::E = 2.71828182845904523536;
+namespace {
+
+// Bits of 2/pi after the binary point, 32 per entry. 1280 bits cover the
+// reduction window for every finite double.
+const uint32_t kTwoOverPiBits[] = {
+    0xA2F9836E, 0x4E441529, 0xFC2757D1, 0xF534DDC0, 0xDB629599, 0x3C439041,
+    0xFE5163AB, 0xDEBBC561, 0xB7246E3A, 0x424DD2E0, 0x06492EEA, 0x09D1921C,
+    0xFE1DEB1C, 0xB129A73E, 0xE88235F5, 0x2EBB4484, 0xE99C7026, 0xB45F7E41,
+    0x3991D639, 0x835339F4, 0x9C845F8B, 0xBDF9283B, 0x1FF897FF, 0xDE05980F,
+    0xEF2F118B, 0x5A0A6D1F, 0x6D367ECF, 0x27CB09B7, 0x4F463F66, 0x9E5FEA2D,
+    0x7527BAC7, 0xEBE5F17B, 0x3D0739F7, 0x8A5292EA, 0x6BFB5FB1, 0x1F8D5D08,
+    0x56033046, 0xFC7B6BAB, 0xF0CFBC20, 0x9AF4361D};
+
+// 64 bits of a little-endian array of 32-bit limbs starting at bit `pos`
+uint64_t extractBits(const uint32_t *limbs, int pos) {
+  uint64_t result = 0;
+  for (int i = 0; i < 64; i += 32) {
+    int bit = pos + i;
+    int limb = bit / 32, shift = bit % 32;
+    uint64_t word = limbs[limb] >> shift;
+    if (shift != 0)
+      word |= static_cast<uint64_t>(limbs[limb + 1]) << (32 - shift);
+    result |= (word & 0xffffffffULL) << i;
+  }
+  return result;
+}
 
-double MathUtils::my_abs(double x) { return (x < 0) ? -x : x; }
+// Payne-Hanek reduction for large finite |x|: returns the quadrant mod 4
+// and sets r = x - quadrant * pi/2 in [-pi/4, pi/4]. Runs in constant
+// time: only a fixed 192-bit window of 2/pi is multiplied by the mantissa.
+int reducePayneHanek(double x, double &r) {
+  uint64_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  bool negative = (bits >> 63) != 0;
+  int e = static_cast<int>((bits >> 52) & 0x7ff) - 1075;
+  uint64_t m = (bits & 0x000fffffffffffffULL) | (1ULL << 52);
+
+  // |x| = m * 2^e. Bits of 2/pi with weight >= 4 after scaling only add
+  // multiples of 4 to the quadrant, so the window starts just below them.
+  int j0 = (e - 1 > 1) ? e - 1 : 1;
+  int first = (j0 - 1) / 32, shift = (j0 - 1) % 32;
+
+  // 192-bit window as little-endian limbs
+  uint32_t w[6];
+  for (int i = 0; i < 6; ++i) {
+    const uint32_t *t = kTwoOverPiBits + first + (5 - i);
+    w[i] = shift == 0 ? t[0] : (t[0] << shift) | (t[1] >> (32 - shift));
+  }
 
-double MathUtils::my_sqrt(double x) {
-  if (x < 0) {
-    throw std::invalid_argument("Square root of negative number");
+  // p = m * w (53 x 192 bits), plus a zero limb so extractBits can read
+  // one past the top of the product
+  uint32_t p[10] = {};
+  uint32_t mLimbs[2] = {static_cast<uint32_t>(m),
+                        static_cast<uint32_t>(m >> 32)};
+  for (int i = 0; i < 2; ++i) {
+    uint64_t carry = 0;
+    for (int j = 0; j < 6; ++j) {
+      uint64_t cur = static_cast<uint64_t>(mLimbs[i]) * w[j] + p[i + j] + carry;
+      p[i + j] = static_cast<uint32_t>(cur);
+      carry = cur >> 32;
+    }
+    p[i + 6] += static_cast<uint32_t>(carry);
   }
-  if (x == 0)
-    return 0;
 
-  double guess = x;
-  double epsilon = 1e-10;
+  // |x| * 2/pi = p * 2^-point: integer part gives the quadrant, the 128
+  // bits below the point give the fraction.
+  int point = j0 + 191 - e;
+  int quadrant = static_cast<int>(extractBits(p, point) & 3);
+  uint64_t hi = extractBits(p, point - 64);
+  uint64_t lo = extractBits(p, point - 128);
+
+  // Fold the fraction into [-0.5, 0.5) as a signed 128-bit value
+  bool flip = (hi >> 63) != 0;
+  if (flip) {
+    lo = ~lo + 1;
+    hi = ~hi + (lo == 0 ? 1 : 0);
+    quadrant = (quadrant + 1) & 3;
+  }
 
-  // Newton's method
-  while (true) {
-    double next_guess = 0.5 * (guess + x / guess);
-    if (my_abs(guess - next_guess) < epsilon) {
-      return next_guess;
-    }
-    guess = next_guess;
+  // Fraction as double-double, then multiply by pi/2
+  const double two64 = 18446744073709551616.0;
+  double fh = static_cast<double>(hi);
+  int64_t rem = static_cast<int64_t>(hi - static_cast<uint64_t>(fh));
+  double fracHi = fh / two64;
+  double fracLo = (static_cast<double>(rem) + static_cast<double>(lo) / two64) /
+                  two64;
+  const double pio2Hi = 1.57079632679489655800e+00;
+  const double pio2Lo = 6.12323399573676603587e-17;
+  r = fracHi * pio2Hi + (fracHi * pio2Lo + fracLo * pio2Hi);
+  if (flip)
+    r = -r;
+
+  if (negative) {
+    r = -r;
+    quadrant = (4 - quadrant) & 3;
   }
+  return quadrant;
 }
 
-double MathUtils::my_exp(double x) {
-  // Taylor series for e^x = 1 + x + x^2/2! + x^3/3! + ...
-  // For large x, this can be slow or inaccurate.
-  // Optimization: e^x = (e^(x/2))^2
+bool needsPayneHanek(double x) {
+  double ax = MathUtils::my_abs(x);
+  return ax > kMaxCodyWaite && ax <= std::numeric_limits<double>::max();
+}
 
-  if (x < 0) {
-    return 1.0 / my_exp(-x);
-  }
+} // namespace
+
+const double MathUtils::PI = 3.14159265358979323846;
+const double MathUtils::E = 2.71828182845904523536;
 
-  double sum = 1.0;
-  double term = 1.0;
-  int n = 1;
+double MathUtils::my_abs(double x) { return (x < 0) ? -x : x; }
 
-  while (my_abs(term) > 1e-15) {
-    term *= x / n;
-    sum += term;
-    n++;
-    if (n > 1000)
-      break; // Safety break
+double MathUtils::my_sqrt(double x) {
+  if (x < 0) {
+    throw std::invalid_argument("Square root of negative number");
   }
-  return sum;
+  // Bit-level initial guess plus a fixed number of Newton steps
+  return sqrtKernel(x);
+}
+
+double MathUtils::my_exp(double x) {
+  // e^x = 2^k * e^r with |r| <= ln(2)/2, polynomial of fixed degree in r
+  return expKernel(x);
 }
 
 double MathUtils::my_log(double x) {
   if (x <= 0) {
     throw std::invalid_argument("Logarithm of non-positive number");
   }
-
-  // ln(x) = 2 * sum(( (x-1)/(x+1) )^(2n-1) / (2n-1))
-  double term = (x - 1) / (x + 1);
-  double term_squared = term * term;
-  double sum = 0.0;
-  double current_term = term;
-  int n = 1;
-
-  while (my_abs(current_term) > 1e-15) {
-    sum += current_term / (2 * n - 1);
-    current_term *= term_squared;
-    n++;
-    if (n > 1000)
-      break;
-  }
-
-  return 2 * sum;
+  // ln(x) = e * ln(2) + ln(m) with the mantissa m near 1
+  return logKernel(x);
 }
 
 double MathUtils::my_pow(double base, double exp) {
@@ -95,6 +159,8 @@ double MathUtils::my_pow(double base, double exp) {
 long long MathUtils::factorial(int n) {
   if (n < 0)
     return 0;
+  if (n > 20)
+    throw std::overflow_error("Factorial overflow");
   if (n == 0 || n == 1)
     return 1;
   long long res = 1;
@@ -106,45 +172,22 @@ long long MathUtils::factorial(int n) {
 double MathUtils::to_radians(double degrees) { return degrees * PI / 180.0; }
 
 double MathUtils::my_sin(double x) {
-  // Normalize x to [-PI, PI]
-  while (x > PI)
-    x -= 2 * PI;
-  while (x < -PI)
-    x += 2 * PI;
-
-  double sum = 0.0;
-  double term = x;
-  int n = 1;
-
-  while (my_abs(term) > 1e-15) {
-    sum += term;
-    term *= -1 * x * x / ((2 * n) * (2 * n + 1));
-    n++;
-    if (n > 100)
-      break;
+  // Reduce modulo pi/2: Cody-Waite for moderate |x|, Payne-Hanek beyond
+  if (needsPayneHanek(x)) {
+    double r;
+    int quadrant = reducePayneHanek(x, r);
+    return sinQuadrant<double>(r, quadrant);
   }
-  return sum;
+  return sinKernel(x);
 }
 
 double MathUtils::my_cos(double x) {
-  // Normalize x to [-PI, PI]
-  while (x > PI)
-    x -= 2 * PI;
-  while (x < -PI)
-    x += 2 * PI;
-
-  double sum = 0.0;
-  double term = 1.0;
-  int n = 0;
-
-  while (my_abs(term) > 1e-15) {
-    sum += term;
-    term *= -1 * x * x / ((2 * n + 1) * (2 * n + 2));
-    n++;
-    if (n > 100)
-      break;
+  if (needsPayneHanek(x)) {
+    double r;
+    int quadrant = reducePayneHanek(x, r);
+    return cosQuadrant<double>(r, quadrant);
   }
-  return sum;
+  return cosKernel(x);
 }
 
 double MathUtils::my_tan(double x) {
@@ -1,6 +1,7 @@
 #ifndef MATHUTILS_H
 #define MATHUTILS_H
 
+#include <cstddef>
 #include <string>
 
 class MathUtils {
@@ -17,10 +18,26 @@ public:
     static double my_cos(double x);
     static double my_tan(double x);
     
+    // n! for 0 <= n <= 20 (0 for negative n); throws std::overflow_error
+    // above 20, where it no longer fits a long long. BigFloat::factorial
+    // is exact for any n.
     static long long factorial(int n);
     
     // Helper to convert degrees to radians
     static double to_radians(double degrees);
+
+    // Batch versions: out[i] = f(in[i]) for i < n; in and out may alias.
+    // Fixed-degree polynomial kernels with runtime CPU dispatch
+    // (AVX-512 / AVX2 / baseline). Trig arguments are in radians. Domain
+    // errors give IEEE results (NaN, -inf) instead of throwing.
+    static void sin(const double *in, double *out, size_t n);
+    static void cos(const double *in, double *out, size_t n);
+    static void exp(const double *in, double *out, size_t n);
+    static void log(const double *in, double *out, size_t n);
+    static void sqrt(const double *in, double *out, size_t n);
+
+    // Name of the kernel set picked for this CPU
+    static const char *batchBackend();
 };
 
 #endif // MATHUTILS_H
@@ -0,0 +1,6 @@
+// Compiled with -mavx2 -mfma; only called after a runtime CPU check
+#include "MathKernels.h"
+
+const MathKernelTable &mathKernelsAVX2() {
+  return makeKernelTable<mk_v4d>("avx2");
+}
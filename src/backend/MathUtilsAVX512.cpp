@@ -0,0 +1,6 @@
+// Compiled with -mavx512f; only called after a runtime CPU check
+#include "MathKernels.h"
+
+const MathKernelTable &mathKernelsAVX512() {
+  return makeKernelTable<mk_v8d>("avx512");
+}
@@ -0,0 +1,54 @@
+#include "MathKernels.h"
+#include "MathUtils.h"
+
+// Baseline instantiation: SSE2 on x86-64, generic vector lowering on other
+// GCC/Clang targets, plain scalar loops elsewhere.
+const MathKernelTable &mathKernelsBaseline() {
+#ifdef MATHKERNELS_VECTOR_EXTENSIONS
+  return makeKernelTable<mk_v2d>("baseline");
+#else
+  return makeKernelTable<double>("scalar");
+#endif
+}
+
+namespace {
+
+const MathKernelTable &selectKernels() {
+#ifdef MATHUTILS_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return mathKernelsAVX512();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return mathKernelsAVX2();
+#endif
+  return mathKernelsBaseline();
+}
+
+const MathKernelTable &kernels() {
+  static const MathKernelTable &table = selectKernels();
+  return table;
+}
+
+} // namespace
+
+void MathUtils::sin(const double *in, double *out, size_t n) {
+  kernels().sin(in, out, n);
+}
+
+void MathUtils::cos(const double *in, double *out, size_t n) {
+  kernels().cos(in, out, n);
+}
+
+void MathUtils::exp(const double *in, double *out, size_t n) {
+  kernels().exp(in, out, n);
+}
+
+void MathUtils::log(const double *in, double *out, size_t n) {
+  kernels().log(in, out, n);
+}
+
+void MathUtils::sqrt(const double *in, double *out, size_t n) {
+  kernels().sqrt(in, out, n);
+}
+
+const char *MathUtils::batchBackend() { return kernels().name; }
@@ -0,0 +1,210 @@
+#include "ResultCache.h"
+#include "CompiledExpression.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+template <typename T> void appendBytes(std::string &key, const T &value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  key.append(bytes, sizeof(T));
+}
+} // namespace
+
+struct ResultCache::Shard {
+  struct Entry {
+    std::string key;
+    double result = 0;
+    // Recency list for LRU, most recent at head_
+    uint32_t prev = kNone;
+    uint32_t next = kNone;
+    // Second-chance bit for CLOCK
+    bool referenced = false;
+  };
+
+  std::mutex mutex;
+  // Reserved to capacity and never reallocated, so the views in index
+  // stay valid
+  std::vector<Entry> entries;
+  std::unordered_map<std::string_view, uint32_t> index;
+  size_t capacity = 0;
+  uint32_t head = kNone;
+  uint32_t tail = kNone;
+  uint32_t hand = 0;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+
+  void unlink(uint32_t slot) {
+    Entry &entry = entries[slot];
+    (entry.prev == kNone ? head : entries[entry.prev].next) = entry.next;
+    (entry.next == kNone ? tail : entries[entry.next].prev) = entry.prev;
+  }
+
+  void pushFront(uint32_t slot) {
+    Entry &entry = entries[slot];
+    entry.prev = kNone;
+    entry.next = head;
+    (head == kNone ? tail : entries[head].prev) = slot;
+    head = slot;
+  }
+
+  void touch(uint32_t slot, Policy policy) {
+    if (policy == Policy::Clock) {
+      entries[slot].referenced = true;
+    } else if (slot != head) {
+      unlink(slot);
+      pushFront(slot);
+    }
+  }
+
+  uint32_t evict(Policy policy) {
+    uint32_t victim;
+    if (policy == Policy::Clock) {
+      while (entries[hand].referenced) {
+        entries[hand].referenced = false;
+        hand = (hand + 1) % entries.size();
+      }
+      victim = hand;
+      hand = (hand + 1) % entries.size();
+    } else {
+      victim = tail;
+      unlink(victim);
+    }
+    index.erase(entries[victim].key);
+    ++evictions;
+    return victim;
+  }
+};
+
+ResultCache::ResultCache(size_t capacity, Policy policy, size_t shards)
+    : capacity_(capacity), policy_(policy) {
+  if (capacity >= kNone)
+    throw std::invalid_argument("Cache capacity too large");
+  shards = capacity == 0 ? 0
+                         : std::clamp<size_t>(capacity / kMinShardCapacity, 1,
+                                              std::max<size_t>(shards, 1));
+  for (size_t i = 0; i < shards; ++i) {
+    auto shard = std::make_unique<Shard>();
+    shard->capacity = capacity / shards + (i < capacity % shards ? 1 : 0);
+    shard->entries.reserve(shard->capacity);
+    shard->index.reserve(shard->capacity);
+    shards_.push_back(std::move(shard));
+  }
+}
+
+ResultCache::~ResultCache() = default;
+
+ResultCache::Shard &ResultCache::shardFor(size_t hash) const {
+  // The maps bucket on the low bits of the same hash; pick shards with
+  // the high ones
+  return *shards_[(hash >> 40) % shards_.size()];
+}
+
+std::optional<double> ResultCache::lookup(std::string_view key) {
+  if (shards_.empty())
+    return std::nullopt;
+
+  Shard &shard = shardFor(std::hash<std::string_view>()(key));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    ++shard.misses;
+    return std::nullopt;
+  }
+  ++shard.hits;
+  shard.touch(it->second, policy_);
+  return shard.entries[it->second].result;
+}
+
+void ResultCache::insert(std::string_view key, double result) {
+  if (shards_.empty())
+    return;
+
+  Shard &shard = shardFor(std::hash<std::string_view>()(key));
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    shard.entries[it->second].result = result;
+    shard.touch(it->second, policy_);
+    return;
+  }
+
+  uint32_t slot;
+  if (shard.entries.size() < shard.capacity) {
+    slot = static_cast<uint32_t>(shard.entries.size());
+    shard.entries.emplace_back();
+  } else {
+    slot = shard.evict(policy_);
+  }
+
+  Shard::Entry &entry = shard.entries[slot];
+  entry.key.assign(key.data(), key.size());
+  entry.result = result;
+  entry.referenced = false;
+  shard.index.emplace(entry.key, slot);
+  if (policy_ == Policy::LRU)
+    shard.pushFront(slot);
+}
+
+ResultCache::Stats ResultCache::stats() const {
+  Stats total;
+  for (const auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    total.hits += shard->hits;
+    total.misses += shard->misses;
+    total.evictions += shard->evictions;
+    total.size += shard->entries.size();
+  }
+  return total;
+}
+
+void ResultCache::clear() {
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    shard->index.clear();
+    shard->entries.clear();
+    shard->head = shard->tail = kNone;
+    shard->hand = 0;
+    shard->hits = shard->misses = shard->evictions = 0;
+  }
+}
+
+void ResultCache::normalize(std::string_view expression, std::string &key) {
+  key.clear();
+  for (char c : expression) {
+    if (!std::isspace(static_cast<unsigned char>(c)))
+      key += c;
+  }
+}
+
+void ResultCache::treeKey(const CompiledExpression &expression,
+                          const double *variables, std::string &key) {
+  key.clear();
+  appendBytes(key, static_cast<uint32_t>(expression.code().size()));
+  appendBytes(key, static_cast<uint32_t>(expression.constants().size()));
+  for (const auto &instruction : expression.code()) {
+    key += static_cast<char>(instruction.op);
+    appendBytes(key, instruction.operand);
+  }
+  for (double constant : expression.constants())
+    appendBytes(key, constant);
+  for (size_t i = 0; i < expression.variables().size(); ++i)
+    appendBytes(key, variables[i]);
+}
+
+ResultCache::Policy ResultCache::parsePolicy(const std::string &name) {
+  if (name == "lru")
+    return Policy::LRU;
+  if (name == "clock")
+    return Policy::Clock;
+  throw std::invalid_argument("Unknown cache policy: " + name);
+}
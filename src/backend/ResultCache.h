@@ -0,0 +1,107 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class CompiledExpression;
+
+/**
+ * @brief Bounded, thread-safe memo of expression results
+ *
+ * Keys are split over independently locked shards by hash, so threads
+ * evaluating different expressions rarely contend. Each shard holds a
+ * fixed number of entries allocated up front and evicts by the chosen
+ * policy once full:
+ *  - LRU drops the entry used least recently; every hit relinks the
+ *    entry at the head of the shard's recency list.
+ *  - CLOCK approximates LRU with one "referenced" bit per entry: a hit
+ *    only sets the bit, and eviction sweeps a hand over the entries,
+ *    clearing set bits and taking the first clear one.
+ *
+ * Only successful results are cached; expressions that throw are
+ * evaluated (and throw) every time.
+ */
+class ResultCache {
+public:
+  enum class Policy { LRU, Clock };
+
+  // Smaller shards would evict while the cache is still mostly empty
+  static constexpr size_t kMinShardCapacity = 64;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t size = 0;
+  };
+
+  /**
+   * @param capacity Maximum number of entries; 0 disables caching
+   * @param policy Eviction policy
+   * @param shards Maximum number of independently locked shards; fewer
+   *        are used so that each holds at least kMinShardCapacity entries
+   */
+  explicit ResultCache(size_t capacity, Policy policy = Policy::LRU,
+                       size_t shards = 16);
+  ~ResultCache();
+
+  ResultCache(const ResultCache &) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+
+  std::optional<double> lookup(std::string_view key);
+  void insert(std::string_view key, double result);
+
+  /**
+   * @brief Counters summed over all shards
+   */
+  Stats stats() const;
+
+  /**
+   * @brief Drop all entries and reset the counters
+   */
+  void clear();
+
+  size_t capacity() const { return capacity_; }
+  Policy policy() const { return policy_; }
+
+  /**
+   * @brief Key of an expression string
+   *
+   * Whitespace is dropped, as the tokenizer ignores it too, so "2 + 3"
+   * and "2+3" share an entry.
+   */
+  static void normalize(std::string_view expression, std::string &key);
+
+  /**
+   * @brief Key of a compiled expression with bound variables
+   *
+   * Encodes the bytecode, the constants and the variable values bit for
+   * bit, so expressions that compile to the same code share entries
+   * whatever their spelling or variable names.
+   */
+  static void treeKey(const CompiledExpression &expression,
+                      const double *variables, std::string &key);
+
+  /**
+   * @brief Parse a policy name ("lru" or "clock")
+   * @throws std::invalid_argument for other names
+   */
+  static Policy parsePolicy(const std::string &name);
+
+private:
+  struct Shard;
+
+  Shard &shardFor(size_t hash) const;
+
+  size_t capacity_;
+  Policy policy_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif // RESULTCACHE_H
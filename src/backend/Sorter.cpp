@@ -1,19 +1,719 @@
 #include "Sorter.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 
-std::vector<int> Sorter::loadFromFile(const std::string &filename) {
+namespace {
+
+// Ranges at or below this size are finished with insertion sort
+constexpr ptrdiff_t kInsertionSortThreshold = 24;
+// Inputs smaller than this are not worth waking the thread pool for
+constexpr size_t kParallelSortThreshold = 1 << 16;
+
+void insertionSort(int *first, int *last) {
+  for (int *i = first + 1; i < last; ++i) {
+    int value = *i;
+    int *j = i;
+    while (j > first && value < j[-1]) {
+      *j = j[-1];
+      --j;
+    }
+    *j = value;
+  }
+}
+
+int medianOfThree(int a, int b, int c) {
+  if (a < b)
+    return b < c ? b : (a < c ? c : a);
+  return a < c ? a : (b < c ? c : b);
+}
+
+void introsortLoop(int *first, int *last, int depthLimit) {
+  while (last - first > kInsertionSortThreshold) {
+    if (depthLimit-- == 0) {
+      // Partitioning keeps going badly: switch to guaranteed n log n
+      std::make_heap(first, last);
+      std::sort_heap(first, last);
+      return;
+    }
+
+    int pivot = medianOfThree(*first, first[(last - first) / 2], last[-1]);
+
+    // Hoare partition: stops on elements equal to the pivot, so runs of
+    // duplicates are split evenly instead of degrading to quadratic.
+    int *i = first;
+    int *j = last - 1;
+    while (true) {
+      while (*i < pivot)
+        ++i;
+      while (pivot < *j)
+        --j;
+      if (i >= j)
+        break;
+      std::swap(*i++, *j--);
+    }
+    int *cut = j + 1;
+
+    // Recurse into the smaller half, loop on the larger one
+    if (cut - first < last - cut) {
+      introsortLoop(first, cut, depthLimit);
+      first = cut;
+    } else {
+      introsortLoop(cut, last, depthLimit);
+      last = cut;
+    }
+  }
+  insertionSort(first, last);
+}
+
+void introsort(int *first, int *last) {
+  int depthLimit = 0;
+  for (ptrdiff_t n = last - first; n > 1; n >>= 1)
+    depthLimit += 2;
+  introsortLoop(first, last, depthLimit);
+}
+
+// Number of elements taken from `a` among the first k outputs of a stable
+// merge of a[0, na) and b[0, nb)
+size_t mergeSplit(const int *a, size_t na, const int *b, size_t nb,
+                  size_t k) {
+  size_t low = k > nb ? k - nb : 0;
+  size_t high = std::min(k, na);
+  while (low < high) {
+    size_t i = low + (high - low) / 2;
+    if (b[k - i - 1] < a[i])
+      high = i;
+    else
+      low = i + 1;
+  }
+  return low;
+}
+
+void mergeRange(const int *a, size_t na, const int *b, size_t nb, int *out) {
+  size_t i = 0, j = 0;
+  while (i < na && j < nb)
+    *out++ = b[j] < a[i] ? b[j++] : a[i++];
+  out = std::copy(a + i, a + na, out);
+  std::copy(b + j, b + nb, out);
+}
+
+// Radix sort: 4 passes of 8 bits over an order-preserving unsigned key
+constexpr int kRadixPasses = 4;
+constexpr size_t kRadixBuckets = 256;
+// Below this, the 256-bucket prefix sums cost more than they save
+constexpr size_t kRadixSortThreshold = 256;
+
+using RadixHistogram =
+    std::array<std::array<size_t, kRadixBuckets>, kRadixPasses>;
+
+// Flipping the sign bit maps INT_MIN..INT_MAX onto 0..UINT32_MAX in order
+inline uint32_t radixKey(int value) {
+  return static_cast<uint32_t>(value) ^ 0x80000000u;
+}
+
+inline size_t radixDigit(int value, int pass) {
+  return (radixKey(value) >> (8 * pass)) & 0xFF;
+}
+
+void countDigits(const int *first, const int *last, RadixHistogram &hist,
+                 int pass) {
+  for (auto &h : hist[pass])
+    h = 0;
+  for (const int *p = first; p < last; ++p)
+    ++hist[pass][radixDigit(*p, pass)];
+}
+
+// ---- Text I/O ----
+
+// Files smaller than this are parsed on the calling thread
+constexpr size_t kParallelParseBytes = 1 << 20;
+// Output is formatted into a buffer of this size before each write
+constexpr size_t kWriteBufferBytes = 1 << 16;
+
+#if defined(_WIN32) ||                                                         \
+    (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define SORTER_SWAR_DIGITS 1
+#endif
+
+// Same set as std::isspace in the C locale, which `file >> num` skips
+inline bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+inline bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+#ifdef SORTER_SWAR_DIGITS
+inline uint64_t load8(const char *p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// True if all 8 bytes are ASCII '0'..'9'
+inline bool allDigits8(uint64_t v) {
+  return ((v & 0xF0F0F0F0F0F0F0F0ull) |
+          (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+         0x3333333333333333ull;
+}
+
+// Value of 8 ASCII digits, first digit in the lowest byte. Combines
+// neighbouring digits pairwise: 8 -> 4 -> 2 -> 1 lanes in three multiplies.
+inline uint32_t parse8Digits(uint64_t v) {
+  v -= 0x3030303030303030ull;
+  v = v * 10 + (v >> 8);
+  v = (((v & 0x000000FF000000FFull) * 0x000F424000000064ull) +
+       (((v >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >>
+      32;
+  return static_cast<uint32_t>(v);
+}
+#endif
+
+// Parses an optionally signed decimal int at p. Fails without a digit or
+// if the value does not fit, like operator>>.
+bool parseInt(const char *&p, const char *end, int &out) {
+  bool negative = false;
+  if (*p == '-' || *p == '+') {
+    negative = *p == '-';
+    ++p;
+  }
+  if (p == end || !isDigit(*p))
+    return false;
+  while (p < end && *p == '0')
+    ++p;
+
+  const char *digits = p;
+  uint64_t value = 0;
+#ifdef SORTER_SWAR_DIGITS
+  if (end - p >= 8 && allDigits8(load8(p))) {
+    value = parse8Digits(load8(p));
+    p += 8;
+  }
+#endif
+  while (p < end && isDigit(*p) && p - digits < 11)
+    value = value * 10 + static_cast<unsigned>(*p++ - '0');
+
+  uint64_t limit = negative ? 2147483648ull : 2147483647ull;
+  if (p - digits > 10 || value > limit)
+    return false;
+  out = static_cast<int>(negative ? 0 - value : value);
+  return true;
+}
+
+inline bool isSign(char c) { return c == '-' || c == '+'; }
+
+// Whether reading may go on after an int that ended at p: as with
+// operator>>, a sign starts the next number ("1-2" is 1 and -2)
+inline bool continuesAfterInt(const char *p, const char *end) {
+  return p == end || isSpace(*p) || isSign(*p);
+}
+
+// Upper bound on the number of values in [p, end): whitespace-separated
+// tokens, plus signs inside them
+size_t countTokens(const char *p, const char *end) {
+  size_t count = 0;
+  bool inSpace = true;
+  for (; p < end; ++p) {
+    bool space = isSpace(*p);
+    count += !space & (inSpace | isSign(*p));
+    inSpace = space;
+  }
+  return count;
+}
+
+// Parses [p, end) into out. Returns false if it stopped at text that is
+// not an int; `parsed` then counts the values before it.
+bool parseInts(const char *p, const char *end, int *out, size_t &parsed) {
+  parsed = 0;
+  while (true) {
+    while (p < end && isSpace(*p))
+      ++p;
+    if (p == end)
+      return true;
+    if (!parseInt(p, end, out[parsed]))
+      return false;
+    ++parsed;
+    // "12abc" yields 12 and then fails, as with operator>>
+    if (!continuesAfterInt(p, end))
+      return false;
+  }
+}
+
+constexpr char kDigitPairs[] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// Writes v in decimal, returns the end. Needs 11 bytes of room.
+inline char *formatInt(int v, char *out) {
+  uint32_t u = static_cast<uint32_t>(v);
+  if (v < 0) {
+    *out++ = '-';
+    u = 0 - u;
+  }
+
+  char tmp[10];
+  char *t = tmp + sizeof(tmp);
+  while (u >= 100) {
+    unsigned pair = (u % 100) * 2;
+    u /= 100;
+    *--t = kDigitPairs[pair + 1];
+    *--t = kDigitPairs[pair];
+  }
+  if (u >= 10) {
+    *--t = kDigitPairs[u * 2 + 1];
+    *--t = kDigitPairs[u * 2];
+  } else {
+    *--t = static_cast<char>('0' + u);
+  }
+
+  size_t length = tmp + sizeof(tmp) - t;
+  std::memcpy(out, t, length);
+  return out + length;
+}
+
+// Writes ints in the "n n n " text format through a local buffer, so the
+// stream sees a few large writes instead of one insertion per number
+class IntTextWriter {
+public:
+  explicit IntTextWriter(const std::string &filename)
+      : file_(filename, std::ios::binary), buffer_(kWriteBufferBytes),
+        out_(buffer_.data()) {}
+
+  ~IntTextWriter() { flush(); }
+
+  bool isOpen() const { return static_cast<bool>(file_); }
+
+  void put(int value) {
+    out_ = formatInt(value, out_);
+    *out_++ = ' ';
+    // Room for the longest value, "-2147483648 "
+    if (buffer_.data() + buffer_.size() - out_ < 12)
+      flush();
+  }
+
+  bool flush() {
+    file_.write(buffer_.data(), out_ - buffer_.data());
+    out_ = buffer_.data();
+    return static_cast<bool>(file_);
+  }
+
+private:
+  std::ofstream file_;
+  std::vector<char> buffer_;
+  char *out_;
+};
+
+// ---- Binary format ----
+
+// File layout: this header, then `count` int32 values in native (little
+// endian on every supported target) byte order. The header size keeps
+// the values 4-byte aligned in a mapping.
+struct BinaryHeader {
+  char magic[4];
+  uint16_t version;
+  uint8_t elementWidth;
+  uint8_t flags;
+  uint64_t count;
+};
+static_assert(sizeof(BinaryHeader) == 16, "binary header must be packed");
+
+constexpr char kBinaryMagic[4] = {'I', 'A', 'R', 'R'};
+constexpr uint16_t kBinaryVersion = 1;
+// Set when the values are in non-decreasing order
+constexpr uint8_t kBinaryFlagSorted = 1;
+
+BinaryHeader makeBinaryHeader(uint64_t count, bool sorted) {
+  BinaryHeader header;
+  std::memcpy(header.magic, kBinaryMagic, sizeof(kBinaryMagic));
+  header.version = kBinaryVersion;
+  header.elementWidth = sizeof(int);
+  header.flags = sorted ? kBinaryFlagSorted : 0;
+  header.count = count;
+  return header;
+}
+
+bool hasBinaryMagic(const MappedFile &file) {
+  return file.size() >= sizeof(kBinaryMagic) &&
+         std::memcmp(file.data(), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+}
+
+// Reads and validates the header; returns the problem, or nullptr if the
+// file is a well-formed binary array
+const char *checkBinaryArray(const MappedFile &file, BinaryHeader &header) {
+  if (file.size() < sizeof(header))
+    return "file too short";
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (std::memcmp(header.magic, kBinaryMagic, sizeof(kBinaryMagic)) != 0)
+    return "bad magic";
+  if (header.version != kBinaryVersion)
+    return "unsupported version";
+  if (header.elementWidth != sizeof(int))
+    return "unsupported element width";
+  size_t payload = file.size() - sizeof(header);
+  if (payload % sizeof(int) != 0 || payload / sizeof(int) != header.count)
+    return "size does not match header";
+  return nullptr;
+}
+
+bool hasBinaryExtension(const std::string &filename) {
+  return filename.size() >= 4 &&
+         filename.compare(filename.size() - 4, 4, ".bin") == 0;
+}
+
+// True if the file is a valid binary array whose header has the sorted flag
+bool binaryFileIsSorted(const std::string &filename) {
+  MappedFile file(filename);
+  BinaryHeader header;
+  return hasBinaryMagic(file) && !checkBinaryArray(file, header) &&
+         (header.flags & kBinaryFlagSorted);
+}
+
+// Streaming counterpart of IntTextWriter for the binary format
+class IntBinaryWriter {
+public:
+  IntBinaryWriter(const std::string &filename, uint64_t count, bool sorted)
+      : file_(filename, std::ios::binary),
+        buffer_(kWriteBufferBytes / sizeof(int)) {
+    BinaryHeader header = makeBinaryHeader(count, sorted);
+    file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+
+  ~IntBinaryWriter() { flush(); }
+
+  bool isOpen() const { return static_cast<bool>(file_); }
+
+  void put(int value) {
+    buffer_[used_++] = value;
+    if (used_ == buffer_.size())
+      flush();
+  }
+
+  bool flush() {
+    file_.write(reinterpret_cast<const char *>(buffer_.data()),
+                used_ * sizeof(int));
+    used_ = 0;
+    return static_cast<bool>(file_);
+  }
+
+private:
+  std::ofstream file_;
+  std::vector<int> buffer_;
+  size_t used_ = 0;
+};
+
+// ---- External sort ----
+
+// Budgets below this are raised to it
+constexpr size_t kMinMemoryBudget = 1 << 20;
+// Smallest read buffer per run while merging; bounds the merge fan-in
+constexpr size_t kMinMergeBuffer = 64 << 10;
+// Largest unsigned LEB128 encoding of a 32-bit value
+constexpr size_t kMaxVarintBytes = 5;
+constexpr uint64_t kRunExhausted = uint64_t(1) << 32;
+
+// A run file is a u64 element count followed by the sorted keys (radixKey
+// order) as LEB128 deltas. Neighbouring keys of a sorted run are close, so
+// most values take one or two bytes instead of four.
+class RunWriter {
+public:
+  RunWriter(const std::string &path, size_t bufferBytes)
+      : path_(path), file_(std::fopen(path.c_str(), "wb")),
+        buffer_(std::max(bufferBytes, kMinMergeBuffer)) {
+    if (!file_)
+      throw std::runtime_error("Failed to create run file: " + path);
+    std::fwrite(&count_, sizeof(count_), 1, file_);
+  }
+
+  ~RunWriter() {
+    if (file_)
+      std::fclose(file_);
+  }
+
+  RunWriter(const RunWriter &) = delete;
+  RunWriter &operator=(const RunWriter &) = delete;
+
+  void put(uint32_t key) {
+    if (used_ + kMaxVarintBytes > buffer_.size())
+      flush();
+    uint32_t delta = key - previous_;
+    previous_ = key;
+    while (delta >= 0x80) {
+      buffer_[used_++] = static_cast<unsigned char>(delta | 0x80);
+      delta >>= 7;
+    }
+    buffer_[used_++] = static_cast<unsigned char>(delta);
+    ++count_;
+  }
+
+  void close() {
+    flush();
+    std::fseek(file_, 0, SEEK_SET);
+    std::fwrite(&count_, sizeof(count_), 1, file_);
+    bool failed = std::ferror(file_) != 0;
+    failed |= std::fclose(file_) != 0;
+    file_ = nullptr;
+    if (failed)
+      throw std::runtime_error("Failed to write run file: " + path_);
+  }
+
+  uint64_t count() const { return count_; }
+
+private:
+  void flush() {
+    if (std::fwrite(buffer_.data(), 1, used_, file_) != used_)
+      throw std::runtime_error("Failed to write run file: " + path_);
+    used_ = 0;
+  }
+
+  std::string path_;
+  std::FILE *file_;
+  std::vector<unsigned char> buffer_;
+  size_t used_ = 0;
+  uint32_t previous_ = 0;
+  uint64_t count_ = 0;
+};
+
+class RunReader {
+public:
+  RunReader(const std::string &path, size_t bufferBytes)
+      : path_(path), file_(std::fopen(path.c_str(), "rb")),
+        buffer_(std::max(bufferBytes, kMinMergeBuffer)) {
+    if (!file_ || std::fread(&remaining_, sizeof(remaining_), 1, file_) != 1)
+      throw std::runtime_error("Failed to read run file: " + path);
+  }
+
+  ~RunReader() {
+    if (file_)
+      std::fclose(file_);
+  }
+
+  RunReader(const RunReader &) = delete;
+  RunReader &operator=(const RunReader &) = delete;
+
+  // Next key of the run, or kRunExhausted
+  uint64_t next() {
+    if (remaining_ == 0)
+      return kRunExhausted;
+    if (length_ - position_ < kMaxVarintBytes)
+      refill();
+
+    uint32_t delta = 0;
+    unsigned shift = 0;
+    unsigned char byte;
+    do {
+      if (position_ == length_)
+        throw std::runtime_error("Truncated run file: " + path_);
+      byte = buffer_[position_++];
+      delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    previous_ += delta;
+    --remaining_;
+    return previous_;
+  }
+
+private:
+  void refill() {
+    size_t tail = length_ - position_;
+    std::memmove(buffer_.data(), buffer_.data() + position_, tail);
+    length_ = tail + std::fread(buffer_.data() + tail, 1,
+                                buffer_.size() - tail, file_);
+    position_ = 0;
+  }
+
+  std::string path_;
+  std::FILE *file_;
+  std::vector<unsigned char> buffer_;
+  size_t position_ = 0;
+  size_t length_ = 0;
+  uint32_t previous_ = 0;
+  uint64_t remaining_ = 0;
+};
+
+// Tournament tree over k sorted runs. Each internal node keeps the loser
+// of the match played there, so replacing the winner replays only the
+// log2(k) matches on its path to the root, one comparison per level.
+class LoserTree {
+public:
+  explicit LoserTree(std::vector<std::unique_ptr<RunReader>> &runs)
+      : runs_(runs), keys_(runs.size()),
+        tree_(std::max<size_t>(runs.size(), 1)) {
+    const size_t k = runs_.size();
+    for (size_t i = 0; i < k; ++i)
+      keys_[i] = runs_[i]->next();
+    if (k <= 1) {
+      tree_[0] = 0;
+      return;
+    }
+
+    // Leaves live at k..2k-1; play every match bottom-up once
+    std::vector<size_t> winners(2 * k);
+    for (size_t i = 0; i < k; ++i)
+      winners[k + i] = i;
+    for (size_t node = k - 1; node > 0; --node) {
+      size_t a = winners[2 * node];
+      size_t b = winners[2 * node + 1];
+      bool aWins = keys_[a] <= keys_[b];
+      winners[node] = aWins ? a : b;
+      tree_[node] = aWins ? b : a;
+    }
+    tree_[0] = winners[1];
+  }
+
+  bool empty() const {
+    return keys_.empty() || keys_[tree_[0]] == kRunExhausted;
+  }
+
+  uint32_t top() const { return static_cast<uint32_t>(keys_[tree_[0]]); }
+
+  void pop() {
+    size_t winner = tree_[0];
+    keys_[winner] = runs_[winner]->next();
+    for (size_t node = (winner + keys_.size()) / 2; node > 0; node /= 2) {
+      if (keys_[tree_[node]] < keys_[winner])
+        std::swap(tree_[node], winner);
+    }
+    tree_[0] = winner;
+  }
+
+private:
+  std::vector<std::unique_ptr<RunReader>> &runs_;
+  std::vector<uint64_t> keys_;
+  std::vector<size_t> tree_;
+};
+
+// Removes the run files it still owns when the sort ends, even on error
+struct RunFiles {
+  std::vector<std::string> paths;
+  size_t created = 0;
+
+  ~RunFiles() {
+    for (const auto &path : paths)
+      std::remove(path.c_str());
+  }
+};
+
+class SortProgress {
+public:
+  SortProgress() : start_(std::chrono::steady_clock::now()) {}
+
+  double seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start_)
+        .count();
+  }
+
+  void report(const std::string &phase, uint64_t elements) const {
+    double elapsed = seconds();
+    std::cout << phase << ": " << elements << " elements, " << elapsed
+              << " s";
+    if (elapsed > 0)
+      std::cout << " (" << elements / elapsed / 1e6 << " M elements/s)";
+    std::cout << std::endl;
+  }
+
+private:
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Merges the given runs, handing every key in order to sink(key)
+template <typename Sink>
+void mergeRuns(const std::vector<std::string> &paths, size_t bufferBytes,
+               Sink &&sink) {
+  std::vector<std::unique_ptr<RunReader>> runs;
+  runs.reserve(paths.size());
+  for (const auto &path : paths)
+    runs.push_back(std::make_unique<RunReader>(path, bufferBytes));
+
+  LoserTree tree(runs);
+  while (!tree.empty()) {
+    sink(tree.top());
+    tree.pop();
+  }
+}
+
+} // namespace
+
+std::vector<int> Sorter::loadFromFile(const std::string &filename,
+                                      size_t threads) {
   std::vector<int> data;
-  std::ifstream file(filename);
+  MappedFile file(filename);
 
-  if (!file) {
+  if (!file.isOpen()) {
     std::cout << "Failed to open file: " << filename << std::endl;
     return data;
   }
 
-  int num;
-  while (file >> num) {
-    data.push_back(num);
+  if (hasBinaryMagic(file)) {
+    BinaryHeader header;
+    if (const char *problem = checkBinaryArray(file, header)) {
+      std::cout << "Invalid binary array file " << filename << ": " << problem
+                << std::endl;
+      return data;
+    }
+    const int *values =
+        reinterpret_cast<const int *>(file.data() + sizeof(header));
+    data.assign(values, values + header.count);
+    std::cout << "Loaded " << data.size() << " elements from " << filename
+              << std::endl;
+    return data;
+  }
+
+  const char *text = file.data();
+  const size_t size = file.size();
+  if (threads == 0)
+    threads = ThreadPool::defaultThreadCount();
+  if (size < kParallelParseBytes)
+    threads = 1;
+
+  // Cut the text into one chunk per worker, moving each cut forward to
+  // whitespace so no number straddles two chunks
+  std::vector<size_t> cuts(threads + 1, size);
+  cuts[0] = 0;
+  for (size_t i = 1; i < threads; ++i) {
+    size_t cut = std::max(size * i / threads, cuts[i - 1]);
+    while (cut < size && !isSpace(text[cut]))
+      ++cut;
+    cuts[i] = cut;
+  }
+
+  ThreadPool pool(threads);
+  std::vector<size_t> offsets(threads + 1, 0);
+  std::vector<size_t> parsed(threads, 0);
+  std::vector<char> complete(threads, 1);
+
+  // Pass 1 counts tokens so the output is sized once; pass 2 parses each
+  // chunk straight into its slice of it
+  pool.parallelFor(threads, [&](size_t begin, size_t end, size_t) {
+    for (size_t c = begin; c < end; ++c)
+      offsets[c + 1] = countTokens(text + cuts[c], text + cuts[c + 1]);
+  });
+  for (size_t c = 0; c < threads; ++c)
+    offsets[c + 1] += offsets[c];
+  data.resize(offsets[threads]);
+
+  pool.parallelFor(threads, [&](size_t begin, size_t end, size_t) {
+    for (size_t c = begin; c < end; ++c)
+      complete[c] = parseInts(text + cuts[c], text + cuts[c + 1],
+                              data.data() + offsets[c], parsed[c]);
+  });
+
+  // Like `file >> num`, stop at the first token that is not an int
+  for (size_t c = 0; c < threads; ++c) {
+    if (!complete[c]) {
+      data.resize(offsets[c] + parsed[c]);
+      break;
+    }
   }
 
   std::cout << "Loaded " << data.size() << " elements from " << filename
@@ -23,21 +723,223 @@ std::vector<int> Sorter::loadFromFile(const std::string &filename) {
 
 void Sorter::saveToFile(const std::string &filename,
                         const std::vector<int> &data) {
-  std::ofstream file(filename);
+  if (hasBinaryExtension(filename)) {
+    saveBinary(filename, data);
+    return;
+  }
 
-  if (!file) {
+  IntTextWriter file(filename);
+
+  if (!file.isOpen()) {
     std::cout << "Failed to open file for writing: " << filename << std::endl;
     return;
   }
 
-  for (const auto &num : data) {
-    file << num << " ";
+  for (int num : data) {
+    file.put(num);
+  }
+  file.flush();
+
+  std::cout << "Saved " << data.size() << " elements to " << filename
+            << std::endl;
+}
+
+void Sorter::saveBinary(const std::string &filename,
+                        const std::vector<int> &data) {
+  std::ofstream file(filename, std::ios::binary);
+
+  if (!file) {
+    std::cout << "Failed to open file for writing: " << filename << std::endl;
+    return;
   }
 
+  BinaryHeader header = makeBinaryHeader(
+      data.size(), std::is_sorted(data.begin(), data.end()));
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(data.data()),
+             data.size() * sizeof(int));
+
   std::cout << "Saved " << data.size() << " elements to " << filename
             << std::endl;
 }
 
+Sorter::BinaryView Sorter::mapBinary(const std::string &filename) {
+  BinaryView view;
+  if (!view.file.open(filename)) {
+    std::cout << "Failed to open file: " << filename << std::endl;
+    return view;
+  }
+
+  BinaryHeader header;
+  if (const char *problem = checkBinaryArray(view.file, header)) {
+    std::cout << "Invalid binary array file " << filename << ": " << problem
+              << std::endl;
+    view.file.close();
+    return view;
+  }
+
+  view.data = reinterpret_cast<const int *>(view.file.data() + sizeof(header));
+  view.size = header.count;
+  view.sorted = header.flags & kBinaryFlagSorted;
+  return view;
+}
+
+bool Sorter::externalSort(const std::string &input, const std::string &output,
+                          size_t memoryBudget, size_t threads) {
+  MappedFile file(input);
+  if (!file.isOpen()) {
+    std::cout << "Failed to open file: " << input << std::endl;
+    return false;
+  }
+
+  // Binary input is consumed straight from the mapping, without parsing
+  BinaryHeader header;
+  const bool binaryInput = hasBinaryMagic(file);
+  if (binaryInput) {
+    if (const char *problem = checkBinaryArray(file, header)) {
+      std::cout << "Invalid binary array file " << input << ": " << problem
+                << std::endl;
+      return false;
+    }
+  }
+  const int *values =
+      reinterpret_cast<const int *>(file.data() + sizeof(header));
+
+  memoryBudget = std::max(memoryBudget, kMinMemoryBudget);
+  // The run and radixSort's scratch buffer share the budget
+  const size_t runCapacity = memoryBudget / (2 * sizeof(int));
+  const size_t fanIn = std::max<size_t>(2, memoryBudget / kMinMergeBuffer - 1);
+  const size_t ioBuffer = memoryBudget / (fanIn + 1);
+
+  SortProgress progress;
+  RunFiles runFiles;
+  auto newRun = [&]() {
+    runFiles.paths.push_back(output + ".run" +
+                             std::to_string(runFiles.created++));
+    return runFiles.paths.back();
+  };
+
+  // Both output formats are written through the same put/flush interface
+  auto writeOutput = [&](auto &writer, auto &&produce) {
+    if (!writer.isOpen()) {
+      std::cout << "Failed to open file for writing: " << output << std::endl;
+      return false;
+    }
+    produce([&](int value) { writer.put(value); });
+    if (!writer.flush())
+      throw std::runtime_error("Failed to write " + output);
+    return true;
+  };
+  auto writeAll = [&](uint64_t count, auto &&produce) {
+    if (hasBinaryExtension(output)) {
+      IntBinaryWriter writer(output, count, true);
+      return writeOutput(writer, produce);
+    }
+    IntTextWriter writer(output);
+    return writeOutput(writer, produce);
+  };
+
+  try {
+    if (binaryInput && (header.flags & kBinaryFlagSorted)) {
+      // Header says the data is already in order: convert, do not sort
+      bool written = writeAll(header.count, [&](auto &&put) {
+        for (uint64_t i = 0; i < header.count; ++i)
+          put(values[i]);
+      });
+      if (written)
+        progress.report("Copied already sorted " + input, header.count);
+      return written;
+    }
+
+    // Phase 1: cut the input into budget-sized runs, sort each in memory
+    // and spill it
+    const char *p = file.data();
+    const char *end = p + file.size();
+    uint64_t total = 0;
+    uint64_t consumed = 0;
+    bool more = binaryInput ? header.count > 0 : p != end;
+    std::vector<int> run;
+    run.reserve(runCapacity);
+
+    while (more) {
+      run.clear();
+      if (binaryInput) {
+        uint64_t take =
+            std::min<uint64_t>(runCapacity, header.count - consumed);
+        run.assign(values + consumed, values + consumed + take);
+        consumed += take;
+        more = consumed < header.count;
+      }
+      while (!binaryInput && run.size() < runCapacity) {
+        while (p < end && isSpace(*p))
+          ++p;
+        int value;
+        if (p == end || !parseInt(p, end, value)) {
+          more = false;
+          break;
+        }
+        run.push_back(value);
+        // Stop at the first token that is not an int, like loadFromFile
+        if (!continuesAfterInt(p, end)) {
+          more = false;
+          break;
+        }
+      }
+      if (run.empty())
+        break;
+
+      radixSort(run, threads);
+      RunWriter writer(newRun(), ioBuffer);
+      for (int value : run)
+        writer.put(radixKey(value));
+      writer.close();
+
+      total += run.size();
+      progress.report("Run " + std::to_string(runFiles.paths.size()),
+                      total);
+    }
+    std::vector<int>().swap(run);
+
+    // Phase 2: while there are more runs than buffers fit in the budget,
+    // merge groups of them into longer runs
+    while (runFiles.paths.size() > fanIn) {
+      RunFiles next;
+      for (size_t first = 0; first < runFiles.paths.size(); first += fanIn) {
+        size_t last = std::min(first + fanIn, runFiles.paths.size());
+        std::vector<std::string> group(runFiles.paths.begin() + first,
+                                       runFiles.paths.begin() + last);
+        std::string merged =
+            output + ".run" + std::to_string(runFiles.created++);
+        next.paths.push_back(merged);
+        RunWriter writer(merged, ioBuffer);
+        mergeRuns(group, ioBuffer, [&](uint32_t key) { writer.put(key); });
+        writer.close();
+        for (const auto &path : group)
+          std::remove(path.c_str());
+      }
+      runFiles.paths.swap(next.paths);
+      progress.report("Merged into " + std::to_string(runFiles.paths.size()) +
+                          " runs",
+                      total);
+    }
+
+    // Phase 3: final k-way merge straight into the output file
+    bool written = writeAll(total, [&](auto &&put) {
+      mergeRuns(runFiles.paths, ioBuffer, [&](uint32_t key) {
+        put(static_cast<int>(key ^ 0x80000000u));
+      });
+    });
+    if (!written)
+      return false;
+
+    progress.report("Sorted " + input + " into " + output, total);
+    return true;
+  } catch (const std::exception &e) {
+    std::cout << "External sort failed: " << e.what() << std::endl;
+    return false;
+  }
+}
+
 void Sorter::bubbleSort(std::vector<int> &arr) {
   int n = arr.size();
   for (int i = 0; i < n - 1; ++i) {
@@ -64,10 +966,27 @@ int Sorter::partition(std::vector<int> &arr, int low, int high) {
 }
 
 void Sorter::quickSort(std::vector<int> &arr, int low, int high) {
-  if (low < high) {
+  while (low < high) {
+    // Median-of-three pivot moved to `high`, so sorted input is not the
+    // worst case
+    int mid = low + (high - low) / 2;
+    if (arr[mid] < arr[low])
+      std::swap(arr[mid], arr[low]);
+    if (arr[high] < arr[low])
+      std::swap(arr[high], arr[low]);
+    if (arr[mid] < arr[high])
+      std::swap(arr[mid], arr[high]);
+
     int pi = partition(arr, low, high);
-    quickSort(arr, low, pi - 1);
-    quickSort(arr, pi + 1, high);
+
+    // Recurse into the smaller side so stack depth stays O(log n)
+    if (pi - low < high - pi) {
+      quickSort(arr, low, pi - 1);
+      low = pi + 1;
+    } else {
+      quickSort(arr, pi + 1, high);
+      high = pi - 1;
+    }
   }
 }
 
@@ -107,6 +1026,151 @@ void Sorter::mergeSort(std::vector<int> &arr, int left, int right) {
   }
 }
 
+void Sorter::parallelSort(std::vector<int> &arr, size_t threads) {
+  const size_t n = arr.size();
+  if (n < 2)
+    return;
+  if (threads == 0)
+    threads = ThreadPool::defaultThreadCount();
+  if (threads == 1 || n < kParallelSortThreshold) {
+    introsort(arr.data(), arr.data() + n);
+    return;
+  }
+
+  ThreadPool pool(threads);
+
+  // Phase 1: each worker sorts its own contiguous slice
+  std::vector<size_t> bounds(pool.size() + 1, n);
+  pool.parallelFor(n, [&](size_t begin, size_t end, size_t worker) {
+    bounds[worker] = begin;
+    introsort(arr.data() + begin, arr.data() + end);
+  });
+  bounds[0] = 0;
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+  // Phase 2: merge neighbouring runs, ping-ponging between the array and
+  // one buffer. Each merge is split by output position across all workers
+  // so the last rounds, with only one or two merges left, stay parallel.
+  std::vector<int> buffer(n);
+  int *src = arr.data();
+  int *dst = buffer.data();
+
+  while (bounds.size() > 2) {
+    std::vector<size_t> merged;
+    for (size_t r = 0; r + 1 < bounds.size(); r += 2) {
+      size_t begin = bounds[r];
+      merged.push_back(begin);
+      if (r + 2 >= bounds.size()) {
+        // Odd run out: carry it over unchanged
+        std::copy(src + begin, src + n, dst + begin);
+        continue;
+      }
+
+      const int *a = src + begin;
+      const int *b = src + bounds[r + 1];
+      size_t na = bounds[r + 1] - begin;
+      size_t nb = bounds[r + 2] - bounds[r + 1];
+      pool.parallelFor(na + nb, [&](size_t first, size_t last, size_t) {
+        size_t ia = mergeSplit(a, na, b, nb, first);
+        size_t ja = mergeSplit(a, na, b, nb, last);
+        size_t ib = first - ia;
+        size_t jb = last - ja;
+        mergeRange(a + ia, ja - ia, b + ib, jb - ib, dst + begin + first);
+      });
+    }
+    merged.push_back(n);
+    bounds.swap(merged);
+    std::swap(src, dst);
+  }
+
+  if (src != arr.data())
+    arr.swap(buffer);
+}
+
+void Sorter::radixSort(std::vector<int> &arr, size_t threads) {
+  const size_t n = arr.size();
+  if (n < kRadixSortThreshold) {
+    introsort(arr.data(), arr.data() + n);
+    return;
+  }
+  if (threads == 0)
+    threads = ThreadPool::defaultThreadCount();
+  if (n < kParallelSortThreshold)
+    threads = 1;
+
+  ThreadPool pool(threads);
+  std::vector<RadixHistogram> hist(pool.size());
+
+  // One read of the input yields the histograms of all four digits. They
+  // decide which passes can be skipped and, until the data first moves,
+  // double as each worker's counts for its own slice.
+  pool.parallelFor(n, [&](size_t begin, size_t end, size_t worker) {
+    auto &h = hist[worker];
+    for (auto &pass : h)
+      pass.fill(0);
+    for (size_t i = begin; i < end; ++i) {
+      uint32_t key = radixKey(arr[i]);
+      ++h[0][key & 0xFF];
+      ++h[1][(key >> 8) & 0xFF];
+      ++h[2][(key >> 16) & 0xFF];
+      ++h[3][key >> 24];
+    }
+  });
+
+  RadixHistogram total{};
+  for (const auto &h : hist) {
+    for (int pass = 0; pass < kRadixPasses; ++pass) {
+      for (size_t d = 0; d < kRadixBuckets; ++d)
+        total[pass][d] += h[pass][d];
+    }
+  }
+
+  std::vector<int> buffer(n);
+  int *src = arr.data();
+  int *dst = buffer.data();
+  bool countsCurrent = true;
+  std::vector<std::array<size_t, kRadixBuckets>> offsets(pool.size());
+
+  for (int pass = 0; pass < kRadixPasses; ++pass) {
+    // All keys share this digit: the pass would only copy the data
+    if (std::find(total[pass].begin(), total[pass].end(), n) !=
+        total[pass].end())
+      continue;
+
+    if (!countsCurrent) {
+      pool.parallelFor(n, [&](size_t begin, size_t end, size_t worker) {
+        countDigits(src + begin, src + end, hist[worker], pass);
+      });
+    }
+
+    // Worker w writes digit d right after what workers < w wrote for d,
+    // which keeps every pass stable
+    size_t base = 0;
+    for (size_t d = 0; d < kRadixBuckets; ++d) {
+      for (size_t w = 0; w < offsets.size(); ++w) {
+        offsets[w][d] = base;
+        base += hist[w][pass][d];
+      }
+    }
+
+    pool.parallelFor(n, [&](size_t begin, size_t end, size_t worker) {
+      auto &pos = offsets[worker];
+      for (size_t i = begin; i < end; ++i) {
+        int value = src[i];
+        dst[pos[radixDigit(value, pass)]++] = value;
+      }
+    });
+
+    std::swap(src, dst);
+    // Slices now hold different elements; a single worker's counts are
+    // still the global ones
+    countsCurrent = pool.size() == 1;
+  }
+
+  if (src != arr.data())
+    arr.swap(buffer);
+}
+
 void Sorter::runInteractive() {
   std::cout << "--- Array Sorter ---\n";
   std::cout << "1. Load from file\n";
@@ -115,40 +1179,72 @@ void Sorter::runInteractive() {
   std::string filename;
   std::cin >> filename;
 
-  auto data = loadFromFile(filename);
-  if (data.empty()) {
-    std::cout << "No data to sort.\n";
-    return;
-  }
-
   std::cout << "Choose sorting algorithm:\n";
   std::cout << "1. Bubble Sort\n";
   std::cout << "2. Quick Sort\n";
   std::cout << "3. Merge Sort\n";
+  std::cout << "4. Parallel Sort\n";
+  std::cout << "5. Radix Sort\n";
+  std::cout << "6. External Sort (file larger than memory)\n";
   std::cout << "> ";
 
   int choice;
   std::cin >> choice;
 
-  switch (choice) {
-  case 1:
-    bubbleSort(data);
-    std::cout << "Sorted with Bubble Sort.\n";
-    break;
-  case 2:
-    quickSort(data, 0, data.size() - 1);
-    std::cout << "Sorted with Quick Sort.\n";
-    break;
-  case 3:
-    mergeSort(data, 0, data.size() - 1);
-    std::cout << "Sorted with Merge Sort.\n";
-    break;
-  default:
+  if (choice == 6) {
+    // Streams file to file; the data is never loaded as a whole
+    size_t budgetMb = 0;
+    std::cout << "Memory budget (MB): ";
+    if (!(std::cin >> budgetMb)) {
+      std::cout << "Invalid budget.\n";
+      return;
+    }
+    std::cout << "Save to file (filename): ";
+    std::string output;
+    std::cin >> output;
+    externalSort(filename, output, budgetMb << 20);
+    return;
+  }
+
+  if (choice < 1 || choice > 5) {
     std::cout << "Invalid choice.\n";
     return;
   }
 
-  std::cout << "Save to file (filename): ";
+  auto data = loadFromFile(filename);
+  if (data.empty()) {
+    std::cout << "No data to sort.\n";
+    return;
+  }
+
+  if (binaryFileIsSorted(filename)) {
+    std::cout << "File header marks the data as sorted; skipping sort.\n";
+  } else {
+    switch (choice) {
+    case 1:
+      bubbleSort(data);
+      std::cout << "Sorted with Bubble Sort.\n";
+      break;
+    case 2:
+      quickSort(data, 0, data.size() - 1);
+      std::cout << "Sorted with Quick Sort.\n";
+      break;
+    case 3:
+      mergeSort(data, 0, data.size() - 1);
+      std::cout << "Sorted with Merge Sort.\n";
+      break;
+    case 4:
+      parallelSort(data);
+      std::cout << "Sorted with Parallel Sort.\n";
+      break;
+    case 5:
+      radixSort(data);
+      std::cout << "Sorted with Radix Sort.\n";
+      break;
+    }
+  }
+
+  std::cout << "Save to file (filename, .bin for binary): ";
   std::cin >> filename;
   saveToFile(filename, data);
 }
@@ -1,19 +1,108 @@
 #ifndef SORTER_H
 #define SORTER_H
 
+#include "MappedFile.h"
+#include <cstddef>
 #include <string>
 #include <vector>
 
 class Sorter {
 public:
-  static std::vector<int> loadFromFile(const std::string &filename);
+  /**
+   * @brief Read-only, zero-copy view of a binary array file
+   *
+   * Valid while the view lives; `data` points into the mapped file.
+   */
+  struct BinaryView {
+    MappedFile file;
+    const int *data = nullptr;
+    size_t size = 0;
+    bool sorted = false;
+
+    bool isOpen() const { return file.isOpen(); }
+  };
+
+  /**
+   * @brief Load whitespace-separated integers from a text file
+   * @param filename File to read
+   * @param threads Parser threads for large files; 0 uses every core
+   *
+   * The file is memory-mapped and parsed in place, split into chunks at
+   * whitespace boundaries. Reading stops at the first token that is not an
+   * int, as with `file >> num`. Binary array files (see saveBinary) are
+   * recognised by their header and loaded without parsing.
+   */
+  static std::vector<int> loadFromFile(const std::string &filename,
+                                       size_t threads = 0);
+
+  /**
+   * @brief Save as text, or as a binary array if filename ends in ".bin"
+   */
   static void saveToFile(const std::string &filename,
                          const std::vector<int> &data);
 
+  /**
+   * @brief Save in the binary array format
+   *
+   * A 16-byte header (magic "IARR", version, element width, flags, count)
+   * followed by the raw int32 values. The sorted flag is set when the data
+   * is in non-decreasing order, so later runs can skip sorting it.
+   */
+  static void saveBinary(const std::string &filename,
+                         const std::vector<int> &data);
+
+  /**
+   * @brief Map a binary array file without copying or parsing it
+   * @return A view that is not open if the file is missing or invalid
+   */
+  static BinaryView mapBinary(const std::string &filename);
+
   static void bubbleSort(std::vector<int> &arr);
   static void quickSort(std::vector<int> &arr, int low, int high);
   static void mergeSort(std::vector<int> &arr, int left, int right);
 
+  /**
+   * @brief Sort using all cores
+   * @param arr Array to sort in place
+   * @param threads Worker count; 0 uses every hardware thread
+   *
+   * Each worker introsorts one contiguous slice (median-of-three
+   * partitioning, heapsort past the depth limit, insertion sort for small
+   * ranges). Sorted slices are then merged pairwise through a single
+   * buffer the size of the input, with every merge split across all
+   * workers. O(n log n) worst case, no deep recursion on sorted input.
+   */
+  static void parallelSort(std::vector<int> &arr, size_t threads = 0);
+
+  /**
+   * @brief LSD radix sort on 32-bit keys
+   * @param arr Array to sort in place
+   * @param threads Worker count; 0 uses every hardware thread
+   *
+   * Four stable 8-bit passes over the value with its sign bit flipped, so
+   * negative numbers order correctly. Passes where every element has the
+   * same digit are skipped. Workers keep private histograms for their own
+   * slice and scatter into disjoint regions of one ping-pong buffer.
+   */
+  static void radixSort(std::vector<int> &arr, size_t threads = 0);
+
+  /**
+   * @brief Sort a text file of integers that may not fit in memory
+   * @param input Text or binary array file, as read by loadFromFile
+   * @param output Sorted result, text or binary as chosen by saveToFile
+   * @param memoryBudget Bytes of RAM to use; at least 1 MB is used
+   * @param threads Worker count for sorting runs; 0 uses every core
+   * @return false if a file could not be read or written
+   *
+   * Budget-sized runs are radix-sorted in memory and spilled next to
+   * `output` as delta-encoded binary files, then k-way merged with a
+   * loser tree (in several passes if there are more runs than read
+   * buffers fit in the budget). Binary input flagged as sorted is copied
+   * without sorting. Progress and throughput go to stdout.
+   */
+  static bool externalSort(const std::string &input, const std::string &output,
+                           size_t memoryBudget, size_t threads = 0);
+
   static void runInteractive();
 
 private:
@@ -0,0 +1,604 @@
+#include "../backend/BusinessCalendar.h"
+#include "../backend/CivilDate.h"
+#include "../backend/ExpressionEvaluator.h"
+#include "../backend/History.h"
+#include "../backend/IntegerExpression.h"
+#include "../backend/MathUtils.h"
+#include "../backend/Sorter.h"
+#include "../utils/LinkedList.h"
+#include "../utils/UnrolledList.h"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Run with --benchmark_format=json (or --benchmark_out=FILE
+// --benchmark_out_format=json) to record results for comparison between
+// builds, e.g. with Google Benchmark's tools/compare.py.
+
+namespace {
+
+constexpr unsigned kSeed = 42;
+
+// History and Sorter report to stdout; keep that out of the timings
+class QuietStdout {
+public:
+  QuietStdout() : saved_(std::cout.rdbuf(sink_.rdbuf())) {}
+  ~QuietStdout() { std::cout.rdbuf(saved_); }
+
+private:
+  std::ostringstream sink_;
+  std::streambuf *saved_;
+};
+
+std::string tempPath(const char *name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// ==================== ExpressionEvaluator ====================
+
+// `terms` operator/function groups cycling through every token kind
+std::string makeExpression(int64_t terms) {
+  static const char *const parts[] = {"2.5 * 3",      "sqrt(16)",
+                                      "(7 - 1) / 3",  "2 ^ 5",
+                                      "sin(30)",      "log(10) * 4",
+                                      "exp(1) - 0.5", "cos(60) + tan(45)"};
+  std::string expr = "1";
+  for (int64_t i = 0; i < terms; ++i) {
+    expr += i % 2 ? " - " : " + ";
+    expr += parts[i % 8];
+  }
+  return expr;
+}
+
+void BM_Evaluate(benchmark::State &state) {
+  const std::string expr = makeExpression(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ExpressionEvaluator::evaluate(expr));
+  state.SetBytesProcessed(state.iterations() * expr.size());
+}
+BENCHMARK(BM_Evaluate)->RangeMultiplier(8)->Range(1, 512);
+
+void BM_Compile(benchmark::State &state) {
+  const std::string expr = makeExpression(state.range(0));
+  CompiledExpression compiled;
+  for (auto _ : state) {
+    ExpressionEvaluator::compile(expr, compiled);
+    benchmark::DoNotOptimize(compiled.code().data());
+  }
+  state.SetBytesProcessed(state.iterations() * expr.size());
+}
+BENCHMARK(BM_Compile)->RangeMultiplier(8)->Range(1, 512);
+
+void BM_EvaluateCompiled(benchmark::State &state) {
+  CompiledExpression compiled =
+      ExpressionEvaluator::compile("x ^ 3 - 2 * x * y + sqrt(y) / (x + 1)");
+  double vars[] = {1.5, 4.0};
+  for (auto _ : state) {
+    vars[0] += 1e-9;
+    benchmark::DoNotOptimize(compiled.evaluate(vars));
+  }
+}
+BENCHMARK(BM_EvaluateCompiled);
+
+void BM_EvaluateBatch(benchmark::State &state) {
+  CompiledExpression compiled =
+      ExpressionEvaluator::compile("x ^ 3 - 2 * x * y + sqrt(y) / (x + 1)");
+  const size_t rows = static_cast<size_t>(state.range(0));
+  std::vector<double> xs(rows), ys(rows), out(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    xs[i] = 0.001 * i;
+    ys[i] = 1.0 + i % 100;
+  }
+  const double *columns[] = {xs.data(), ys.data()};
+  for (auto _ : state) {
+    compiled.evaluateBatch(columns, rows, out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_EvaluateBatch)->Range(64, 1 << 16);
+
+// Mask computation in each width; u128 runs on the 128-bit word type
+void BM_IntegerBatch(benchmark::State &state, const char *type) {
+  using Word = IntegerExpression::Word;
+  IntegerExpression compiled = IntegerExpression::compile(
+      "(rotl(a, 7) ^ (b >> 3)) & ~(a | 0xF0) + popcount(b)",
+      IntegerExpression::Type::parse(type));
+  const size_t rows = static_cast<size_t>(state.range(0));
+  std::mt19937_64 rng(42);
+  std::vector<Word> a(rows), b(rows), out(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    a[i] = (Word(rng()) << 64) | rng();
+    b[i] = (Word(rng()) << 64) | rng();
+  }
+  const Word *columns[] = {a.data(), b.data()};
+  for (auto _ : state) {
+    compiled.evaluateBatch(columns, rows, out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK_CAPTURE(BM_IntegerBatch, u32, "u32")->Arg(1 << 16);
+BENCHMARK_CAPTURE(BM_IntegerBatch, i64, "i64")->Arg(1 << 16);
+BENCHMARK_CAPTURE(BM_IntegerBatch, u128, "u128")->Arg(1 << 16);
+
+void BM_IntegerBatch64(benchmark::State &state) {
+  IntegerExpression compiled = IntegerExpression::compile(
+      "(rotl(a, 7) ^ (b >> 3)) & ~(a | 0xF0) + popcount(b)",
+      IntegerExpression::Type::parse("u64"));
+  const size_t rows = static_cast<size_t>(state.range(0));
+  std::mt19937_64 rng(42);
+  std::vector<uint64_t> a(rows), b(rows), out(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    a[i] = rng();
+    b[i] = rng();
+  }
+  const uint64_t *columns[] = {a.data(), b.data()};
+  for (auto _ : state) {
+    compiled.evaluateBatch(columns, rows, out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_IntegerBatch64)->Arg(1 << 16);
+
+void BM_IntegerEvaluate(benchmark::State &state) {
+  IntegerExpression compiled = IntegerExpression::compile(
+      "(rotl(a, 7) ^ (b >> 3)) & ~(a | 0xF0) + popcount(b)");
+  IntegerExpression::Word vars[] = {0x12345678, 0x9ABCDEF0};
+  for (auto _ : state) {
+    ++vars[0];
+    benchmark::DoNotOptimize(compiled.evaluate(vars));
+  }
+}
+BENCHMARK(BM_IntegerEvaluate);
+
+// ==================== MathUtils ====================
+
+// Inputs spread evenly over [lo, hi], so every reduction branch of the
+// function is exercised in proportion to the range
+std::vector<double> spread(double lo, double hi, size_t n = 4096) {
+  std::vector<double> values(n);
+  for (size_t i = 0; i < n; ++i)
+    values[i] = lo + (hi - lo) * i / (n - 1);
+  return values;
+}
+
+void BM_MathScalar(benchmark::State &state, double (*fn)(double), double lo,
+                   double hi) {
+  const std::vector<double> inputs = spread(lo, hi);
+  for (auto _ : state) {
+    for (double x : inputs)
+      benchmark::DoNotOptimize(fn(x));
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK_CAPTURE(BM_MathScalar, abs, MathUtils::my_abs, -1e6, 1e6);
+BENCHMARK_CAPTURE(BM_MathScalar, sqrt_small, MathUtils::my_sqrt, 0.0, 1.0);
+BENCHMARK_CAPTURE(BM_MathScalar, sqrt_large, MathUtils::my_sqrt, 1.0, 1e300);
+BENCHMARK_CAPTURE(BM_MathScalar, exp, MathUtils::my_exp, -700.0, 700.0);
+BENCHMARK_CAPTURE(BM_MathScalar, log_small, MathUtils::my_log, 1e-3, 10.0);
+BENCHMARK_CAPTURE(BM_MathScalar, log_large, MathUtils::my_log, 10.0, 1e300);
+BENCHMARK_CAPTURE(BM_MathScalar, sin_small, MathUtils::my_sin, -6.3, 6.3);
+BENCHMARK_CAPTURE(BM_MathScalar, sin_large, MathUtils::my_sin, 1e6, 1e22);
+BENCHMARK_CAPTURE(BM_MathScalar, cos_small, MathUtils::my_cos, -6.3, 6.3);
+BENCHMARK_CAPTURE(BM_MathScalar, cos_large, MathUtils::my_cos, 1e6, 1e22);
+BENCHMARK_CAPTURE(BM_MathScalar, tan, MathUtils::my_tan, -1.5, 1.5);
+BENCHMARK_CAPTURE(BM_MathScalar, to_radians, MathUtils::to_radians, -360.0,
+                  360.0);
+
+void BM_Pow(benchmark::State &state, bool integerExponents) {
+  const std::vector<double> bases = spread(0.5, 100.0);
+  std::vector<double> exponents = spread(-10.3, 10.7);
+  if (integerExponents) {
+    for (double &exponent : exponents)
+      exponent = std::round(exponent);
+  }
+  for (auto _ : state) {
+    for (size_t i = 0; i < bases.size(); ++i)
+      benchmark::DoNotOptimize(MathUtils::my_pow(bases[i], exponents[i]));
+  }
+  state.SetItemsProcessed(state.iterations() * bases.size());
+}
+BENCHMARK_CAPTURE(BM_Pow, fractional, false);
+BENCHMARK_CAPTURE(BM_Pow, integer, true);
+
+void BM_Factorial(benchmark::State &state) {
+  for (auto _ : state) {
+    for (int n = 0; n <= 20; ++n)
+      benchmark::DoNotOptimize(MathUtils::factorial(n));
+  }
+  state.SetItemsProcessed(state.iterations() * 21);
+}
+BENCHMARK(BM_Factorial);
+
+void BM_MathBatch(benchmark::State &state,
+                  void (*fn)(const double *, double *, size_t), double lo,
+                  double hi) {
+  const std::vector<double> inputs = spread(lo, hi, state.range(0));
+  std::vector<double> out(inputs.size());
+  for (auto _ : state) {
+    fn(inputs.data(), out.data(), inputs.size());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+  state.SetLabel(MathUtils::batchBackend());
+}
+BENCHMARK_CAPTURE(BM_MathBatch, sin, MathUtils::sin, -100.0, 100.0)
+    ->Range(64, 1 << 16);
+BENCHMARK_CAPTURE(BM_MathBatch, cos, MathUtils::cos, -100.0, 100.0)
+    ->Range(64, 1 << 16);
+BENCHMARK_CAPTURE(BM_MathBatch, exp, MathUtils::exp, -700.0, 700.0)
+    ->Range(64, 1 << 16);
+BENCHMARK_CAPTURE(BM_MathBatch, log, MathUtils::log, 1e-3, 1e6)
+    ->Range(64, 1 << 16);
+BENCHMARK_CAPTURE(BM_MathBatch, sqrt, MathUtils::sqrt, 0.0, 1e6)
+    ->Range(64, 1 << 16);
+
+// ==================== Sorter ====================
+
+enum class Pattern { Random, Sorted, Reverse, FewUnique };
+
+std::vector<int> makeInput(Pattern pattern, size_t n) {
+  std::mt19937 rng(kSeed);
+  std::vector<int> data(n);
+  switch (pattern) {
+  case Pattern::Random:
+    for (int &value : data)
+      value = static_cast<int>(rng());
+    break;
+  case Pattern::Sorted:
+  case Pattern::Reverse:
+    for (size_t i = 0; i < n; ++i)
+      data[i] = static_cast<int>(i);
+    if (pattern == Pattern::Reverse)
+      std::reverse(data.begin(), data.end());
+    break;
+  case Pattern::FewUnique:
+    for (int &value : data)
+      value = static_cast<int>(rng() % 8);
+    break;
+  }
+  return data;
+}
+
+using SortFn = void (*)(std::vector<int> &);
+
+void bubbleSort(std::vector<int> &data) { Sorter::bubbleSort(data); }
+void quickSort(std::vector<int> &data) {
+  Sorter::quickSort(data, 0, static_cast<int>(data.size()) - 1);
+}
+void mergeSort(std::vector<int> &data) {
+  Sorter::mergeSort(data, 0, static_cast<int>(data.size()) - 1);
+}
+void parallelSort(std::vector<int> &data) { Sorter::parallelSort(data); }
+void radixSort(std::vector<int> &data) { Sorter::radixSort(data); }
+
+void BM_Sort(benchmark::State &state, SortFn sort, Pattern pattern) {
+  const std::vector<int> input =
+      makeInput(pattern, static_cast<size_t>(state.range(0)));
+  std::vector<int> data;
+  for (auto _ : state) {
+    state.PauseTiming();
+    data = input;
+    state.ResumeTiming();
+    sort(data);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// Bubble sort is quadratic; keep it to sizes that finish promptly
+#define SORT_BENCHMARKS(algorithm, maxSize)                                    \
+  BENCHMARK_CAPTURE(BM_Sort, algorithm##_random, algorithm, Pattern::Random)   \
+      ->RangeMultiplier(8)                                                     \
+      ->Range(1 << 8, maxSize);                                                \
+  BENCHMARK_CAPTURE(BM_Sort, algorithm##_sorted, algorithm, Pattern::Sorted)   \
+      ->RangeMultiplier(8)                                                     \
+      ->Range(1 << 8, maxSize);                                                \
+  BENCHMARK_CAPTURE(BM_Sort, algorithm##_reverse, algorithm, Pattern::Reverse) \
+      ->RangeMultiplier(8)                                                     \
+      ->Range(1 << 8, maxSize);                                                \
+  BENCHMARK_CAPTURE(BM_Sort, algorithm##_few_unique, algorithm,                \
+                    Pattern::FewUnique)                                        \
+      ->RangeMultiplier(8)                                                     \
+      ->Range(1 << 8, maxSize)
+
+SORT_BENCHMARKS(bubbleSort, 1 << 11);
+SORT_BENCHMARKS(quickSort, 1 << 20);
+SORT_BENCHMARKS(mergeSort, 1 << 20);
+SORT_BENCHMARKS(parallelSort, 1 << 20);
+SORT_BENCHMARKS(radixSort, 1 << 20);
+
+// ==================== History ====================
+
+History makeHistory(size_t entries) {
+  std::mt19937 rng(kSeed);
+  History history;
+  for (size_t i = 0; i < entries; ++i) {
+    // A few hundred distinct formulas, as in a real session
+    const unsigned a = rng() % 20, b = rng() % 20;
+    history.addEntry(std::to_string(a) + " * " + std::to_string(b) + " + x",
+                     a * b + 0.5);
+  }
+  return history;
+}
+
+enum class Format { Text, Binary };
+
+void BM_HistorySave(benchmark::State &state, Format format) {
+  const size_t entries = static_cast<size_t>(state.range(0));
+  const History history = makeHistory(entries);
+  const std::string path = tempPath("calculator_bench_history");
+  QuietStdout quiet;
+  for (auto _ : state) {
+    if (format == Format::Text)
+      history.save(path);
+    else
+      history.saveBinary(path);
+  }
+  state.SetItemsProcessed(state.iterations() * entries);
+  std::remove(path.c_str());
+}
+BENCHMARK_CAPTURE(BM_HistorySave, text, Format::Text)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 16);
+BENCHMARK_CAPTURE(BM_HistorySave, binary, Format::Binary)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 16);
+
+void BM_HistoryLoad(benchmark::State &state, Format format) {
+  const size_t entries = static_cast<size_t>(state.range(0));
+  const std::string path = tempPath("calculator_bench_history");
+  QuietStdout quiet;
+  if (format == Format::Text)
+    makeHistory(entries).save(path);
+  else
+    makeHistory(entries).saveBinary(path);
+  for (auto _ : state) {
+    History history;
+    if (format == Format::Text)
+      history.load(path);
+    else
+      history.loadBinary(path);
+    benchmark::DoNotOptimize(history.size());
+  }
+  state.SetItemsProcessed(state.iterations() * entries);
+  std::remove(path.c_str());
+}
+BENCHMARK_CAPTURE(BM_HistoryLoad, text, Format::Text)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 16);
+BENCHMARK_CAPTURE(BM_HistoryLoad, binary, Format::Binary)
+    ->RangeMultiplier(16)
+    ->Range(1 << 8, 1 << 16);
+
+// ==================== CivilDate ====================
+
+void BM_DateDifference(benchmark::State &state) {
+  std::mt19937 rng(kSeed);
+  std::vector<CivilDate> dates(1024);
+  for (CivilDate &date : dates)
+    date = CivilDate::fromDays(static_cast<int64_t>(rng() % 200000) - 100000);
+  for (auto _ : state) {
+    int64_t total = 0;
+    for (size_t i = 1; i < dates.size(); ++i)
+      total += CivilDate::difference(dates[i - 1], dates[i]);
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * (dates.size() - 1));
+}
+BENCHMARK(BM_DateDifference);
+
+void BM_DateParse(benchmark::State &state) {
+  std::vector<std::string> texts;
+  for (int64_t days = -50000; days < 50000; days += 97)
+    texts.push_back(CivilDate::fromDays(days).toString());
+  for (auto _ : state) {
+    int64_t total = 0;
+    CivilDate date;
+    for (const std::string &text : texts)
+      if (CivilDate::tryParse(text, date))
+        total += date.day;
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * texts.size());
+}
+BENCHMARK(BM_DateParse);
+
+// Settlement-style batches over a calendar with ~10 holidays a year
+BusinessCalendar makeCalendar() {
+  BusinessCalendar calendar;
+  std::vector<int32_t> holidays;
+  for (int32_t day = 0; day < 20000; day += 37)
+    holidays.push_back(day);
+  calendar.addHolidays(holidays.data(), holidays.size());
+  return calendar;
+}
+
+std::vector<int32_t> randomDays(size_t n) {
+  std::mt19937 rng(kSeed);
+  std::vector<int32_t> days(n);
+  for (int32_t &day : days)
+    day = static_cast<int32_t>(rng() % 20000);
+  return days;
+}
+
+void BM_DateWeekdays(benchmark::State &state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  std::vector<int32_t> days = randomDays(n);
+  std::vector<uint8_t> out(n);
+  for (auto _ : state) {
+    BusinessCalendar::weekdays(days.data(), out.data(), n);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_DateWeekdays)->Arg(1 << 16);
+
+void BM_BusinessDaysBetween(benchmark::State &state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  BusinessCalendar calendar = makeCalendar();
+  std::vector<int32_t> from = randomDays(n);
+  std::vector<int32_t> to(from.rbegin(), from.rend());
+  std::vector<int64_t> out(n);
+  for (auto _ : state) {
+    calendar.businessDaysBetween(from.data(), to.data(), out.data(), n);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_BusinessDaysBetween)->Arg(1 << 16);
+
+void BM_AddBusinessDays(benchmark::State &state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  BusinessCalendar calendar = makeCalendar();
+  std::vector<int32_t> days = randomDays(n);
+  std::vector<int32_t> offsets(n);
+  for (size_t i = 0; i < n; ++i)
+    offsets[i] = static_cast<int32_t>(i % 61) - 30;
+  std::vector<int32_t> out(n);
+  for (auto _ : state) {
+    calendar.addBusinessDays(days.data(), offsets.data(), out.data(), n);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_AddBusinessDays)->Arg(1 << 16);
+
+// ==================== LinkedList ====================
+
+template <typename List = LinkedList<int>> List makeList(size_t n) {
+  List list;
+  for (size_t i = 0; i < n; ++i)
+    list.pushBack(static_cast<int>(i));
+  return list;
+}
+
+// Pool-allocated nodes (the default) against one new/delete per node
+using StdAllocList = LinkedList<int, std::allocator<int>>;
+
+template <typename List> void BM_ListPushBack(benchmark::State &state) {
+  const int n = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    List list;
+    for (int i = 0; i < n; ++i)
+      list.pushBack(i);
+    benchmark::DoNotOptimize(list.size());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_ListPushBack, LinkedList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ListPushBack, StdAllocList)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+
+void BM_ListPushFront(benchmark::State &state) {
+  const int n = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    LinkedList<int> list;
+    for (int i = 0; i < n; ++i)
+      list.pushFront(i);
+    benchmark::DoNotOptimize(list.size());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_ListPushFront)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+// Refill one list after clear(), the pattern the node pool recycles
+template <typename List> void BM_ListRefill(benchmark::State &state) {
+  const int n = static_cast<int>(state.range(0));
+  List list;
+  for (auto _ : state) {
+    for (int i = 0; i < n; ++i)
+      list.emplaceBack(i);
+    list.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_ListRefill, LinkedList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ListRefill, StdAllocList)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+
+template <typename List> void BM_ListIterate(benchmark::State &state) {
+  List list = makeList<List>(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    long long sum = 0;
+    for (int value : list)
+      sum += value;
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * list.size());
+}
+BENCHMARK_TEMPLATE(BM_ListIterate, LinkedList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ListIterate, UnrolledList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+
+// Indexed access at positions spread over the whole list
+template <typename List> void BM_ListAt(benchmark::State &state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  List list = makeList<List>(n);
+  std::mt19937 rng(kSeed);
+  std::vector<size_t> positions(256);
+  for (size_t &position : positions)
+    position = rng() % n;
+  for (auto _ : state) {
+    for (size_t position : positions)
+      benchmark::DoNotOptimize(list.at(position));
+  }
+  state.SetItemsProcessed(state.iterations() * positions.size());
+}
+BENCHMARK_TEMPLATE(BM_ListAt, LinkedList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ListAt, UnrolledList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 20);
+
+// Insert into and remove from the middle, leaving the size unchanged
+template <typename List>
+void BM_ListInsertRemove(benchmark::State &state) {
+  const size_t n = static_cast<size_t>(state.range(0));
+  List list = makeList<List>(n);
+  for (auto _ : state) {
+    list.insert(n / 2, -1);
+    list.remove(n / 2);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK_TEMPLATE(BM_ListInsertRemove, LinkedList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 16);
+BENCHMARK_TEMPLATE(BM_ListInsertRemove, UnrolledList<int>)
+    ->RangeMultiplier(16)
+    ->Range(16, 1 << 20);
+
+void BM_ListCopy(benchmark::State &state) {
+  const LinkedList<int> list = makeList(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    LinkedList<int> copy(list);
+    benchmark::DoNotOptimize(copy.size());
+  }
+  state.SetItemsProcessed(state.iterations() * list.size());
+}
+BENCHMARK(BM_ListCopy)->RangeMultiplier(16)->Range(16, 1 << 16);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+#include "BatchMode.h"
+#include "../backend/ExpressionEvaluator.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+BatchMode::BatchMode(size_t threads, ResultCache *cache)
+    : cache_(cache), pool_(threads), contexts_(pool_.size()) {
+  lines_.reserve(kChunkLines);
+}
+
+size_t BatchMode::run(std::istream &in, std::ostream &out) {
+  size_t failures = 0;
+  size_t used = 0;
+
+  while (in) {
+    // lines_ keeps its strings between chunks, so their buffers are reused
+    used = 0;
+    while (used < kChunkLines) {
+      if (used == lines_.size())
+        lines_.emplace_back();
+      if (!std::getline(in, lines_[used]))
+        break;
+      ++used;
+    }
+    if (used == 0)
+      break;
+
+    for (auto &context : contexts_) {
+      context.output.clear();
+    }
+
+    pool_.parallelFor(used, [this](size_t begin, size_t end, size_t worker) {
+      evaluateRange(begin, end, contexts_[worker]);
+    });
+
+    // Ranges are assigned in order, so concatenating per-worker buffers
+    // preserves input order
+    for (auto &context : contexts_) {
+      out.write(context.output.data(), context.output.size());
+      failures += context.failures;
+      context.failures = 0;
+    }
+  }
+
+  out.flush();
+  return failures;
+}
+
+size_t BatchMode::runFile(const std::string &filename, std::ostream &out) {
+  if (filename == "-")
+    return run(std::cin, out);
+
+  std::ifstream file(filename);
+  if (!file) {
+    throw std::runtime_error("Failed to open file: " + filename);
+  }
+  return run(file, out);
+}
+
+void BatchMode::evaluateRange(size_t begin, size_t end,
+                              WorkerContext &context) {
+  char buffer[32];
+
+  for (size_t i = begin; i < end; ++i) {
+    const std::string &line = lines_[i];
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      context.output += '\n';
+      continue;
+    }
+
+    try {
+      double result;
+      std::optional<double> cached;
+      if (cache_) {
+        ResultCache::normalize(line, context.key);
+        cached = cache_->lookup(context.key);
+      }
+      if (cached) {
+        result = *cached;
+      } else {
+        ExpressionEvaluator::compile(line, context.expression);
+        result = context.expression.evaluate();
+        if (cache_)
+          cache_->insert(context.key, result);
+      }
+      int length = std::snprintf(buffer, sizeof(buffer), "%.15g", result);
+      context.output.append(buffer, length);
+    } catch (const std::exception &e) {
+      context.output += "Error: ";
+      context.output += e.what();
+      ++context.failures;
+    }
+    context.output += '\n';
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef BATCHMODE_H
+#define BATCHMODE_H
+
+#include "../backend/CompiledExpression.h"
+#include "../backend/ResultCache.h"
+#include "../utils/ThreadPool.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Non-interactive evaluation of many expressions
+ *
+ * Reads one expression per line, evaluates chunks of lines on a worker
+ * pool and writes one result per line in input order. Only one chunk is
+ * held in memory at a time, so arbitrarily long inputs are streamed.
+ */
+class BatchMode {
+public:
+  /**
+   * @param threads Worker count; 0 uses all hardware threads
+   * @param cache Shared by the workers to skip repeated expressions;
+   *        must outlive the BatchMode. Null evaluates every line.
+   */
+  explicit BatchMode(size_t threads = 0, ResultCache *cache = nullptr);
+
+  /**
+   * @brief Evaluate every line of `in` and write results to `out`
+   * @return Number of lines that failed to evaluate
+   *
+   * Successful lines produce the result, failed lines produce
+   * "Error: <message>" and blank lines stay blank.
+   */
+  size_t run(std::istream &in, std::ostream &out);
+
+  /**
+   * @brief Same as run() but reads from a file, or stdin for "-"
+   * @throws std::runtime_error if the file cannot be opened
+   */
+  size_t runFile(const std::string &filename, std::ostream &out);
+
+private:
+  // Lines per chunk handed to the pool
+  static constexpr size_t kChunkLines = 16384;
+
+  // Per-thread state reused across chunks so evaluation does not allocate
+  struct WorkerContext {
+    CompiledExpression expression;
+    std::string key;
+    std::string output;
+    size_t failures = 0;
+  };
+
+  void evaluateRange(size_t begin, size_t end, WorkerContext &context);
+
+  ResultCache *cache_;
+  ThreadPool pool_;
+  std::vector<WorkerContext> contexts_;
+  std::vector<std::string> lines_;
+};
+
+#endif // BATCHMODE_H
@@ -7,7 +7,8 @@
 #include <limits>
 #include <memory>
 
-CalculatorApp::CalculatorApp() {}
+CalculatorApp::CalculatorApp()
+    : precisionDigits_(PrecisionMode::kDefaultDigits) {}
 
 CalculatorApp::~CalculatorApp() {}
 
@@ -37,6 +38,12 @@ void CalculatorApp::run() {
   }
 }
 
+bool CalculatorApp::openJournal(const std::string &filename) {
+  return history_.openJournal(filename);
+}
+
+void CalculatorApp::setPrecision(size_t digits) { precisionDigits_ = digits; }
+
 void CalculatorApp::displayMainMenu() {
   std::cout << "\n=== Main Menu ===\n";
   std::cout << "1. Standard Mode\n";
@@ -45,6 +52,7 @@ void CalculatorApp::displayMainMenu() {
   std::cout << "4. Date Calculations\n";
   std::cout << "5. History Management\n";
   std::cout << "6. Array Sorting\n";
+  std::cout << "7. Precision Mode\n";
   std::cout << "0. Exit\n";
   std::cout << "> ";
 }
@@ -74,6 +82,10 @@ void CalculatorApp::handleModeSelection(int choice) {
   case 6:
     sortArrays();
     break;
+  case 7:
+    mode = std::make_unique<PrecisionMode>(precisionDigits_);
+    mode->run(&history_);
+    break;
   default:
     std::cout << "Invalid choice.\n";
   }
@@ -124,6 +136,8 @@ void CalculatorApp::manageHistory() {
     std::cout << "4. Save to file\n";
     std::cout << "5. Load from file\n";
     std::cout << "6. Clear history\n";
+    std::cout << "7. Auto-save to journal file\n";
+    std::cout << "8. Search history\n";
     std::cout << "0. Back to main menu\n";
     std::cout << "> ";
 
@@ -160,12 +174,69 @@ void CalculatorApp::manageHistory() {
     case 6:
       history_.clear();
       break;
+    case 7: {
+      std::string filename;
+      std::cout << "Enter journal filename: ";
+      std::cin >> filename;
+      history_.openJournal(filename);
+      break;
+    }
+    case 8:
+      searchHistory();
+      break;
     default:
       std::cout << "Invalid choice.\n";
     }
   }
 }
 
+void CalculatorApp::searchHistory() {
+  std::cout << "\n--- Search History ---\n";
+  std::cout << "1. Expressions starting with text\n";
+  std::cout << "2. Expressions containing text\n";
+  std::cout << "3. Results in range\n";
+  std::cout << "> ";
+
+  int choice;
+  std::cin >> choice;
+
+  std::vector<size_t> matches;
+  if (choice == 1 || choice == 2) {
+    // Read the rest of the line so the text may contain spaces
+    std::string text;
+    std::cout << "Enter text: ";
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    std::getline(std::cin, text);
+    matches = choice == 1 ? history_.findPrefix(text)
+                          : history_.findSubstring(text);
+  } else if (choice == 3) {
+    double low, high;
+    std::cout << "Enter minimum and maximum: ";
+    std::cin >> low >> high;
+    if (std::cin.fail()) {
+      std::cin.clear();
+      std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+      std::cout << "Invalid range.\n";
+      return;
+    }
+    matches = history_.findResultRange(low, high);
+  } else {
+    std::cout << "Invalid choice.\n";
+    return;
+  }
+
+  // Large histories can match millions of entries; show the first few
+  constexpr size_t kShown = 20;
+  std::cout << "Found " << matches.size() << " entries.\n";
+  for (size_t i = 0; i < matches.size() && i < kShown; ++i) {
+    size_t entry = matches[i];
+    std::cout << entry + 1 << ". " << history_.operationAt(entry) << " = "
+              << history_.resultAt(entry) << '\n';
+  }
+  if (matches.size() > kShown)
+    std::cout << "... " << matches.size() - kShown << " more\n";
+}
+
 void CalculatorApp::manageDates() {
   DateMode dateMode;
   dateMode.execute();
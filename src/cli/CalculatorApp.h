@@ -13,15 +13,28 @@ public:
 
   void run();
 
+  /**
+   * @brief Keep history in an append-only journal, recovering it first
+   * @return false if the journal could not be opened
+   */
+  bool openJournal(const std::string &filename);
+
+  /**
+   * @brief Digits Precision Mode starts with
+   */
+  void setPrecision(size_t digits);
+
 private:
   void displayMainMenu();
   void handleModeSelection(int choice);
   void evaluateExpression();
   void manageHistory();
+  void searchHistory();
   void manageDates();
   void sortArrays();
 
   History history_;
+  size_t precisionDigits_;
 };
 
 #endif
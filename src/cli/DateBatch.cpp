@@ -0,0 +1,176 @@
+#include "DateBatch.h"
+#include "../backend/CivilDate.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+  while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+    text.remove_prefix(1);
+  while (!text.empty() && (text.back() == ' ' || text.back() == '\t' ||
+                           text.back() == '\r'))
+    text.remove_suffix(1);
+  return text;
+}
+
+// An optionally signed integer, as opposed to a date
+bool parseOffset(std::string_view text, int64_t &days) {
+  if (!text.empty() && text.front() == '+')
+    text.remove_prefix(1);
+  if (text.empty())
+    return false;
+  auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), days);
+  return error == std::errc() && end == text.data() + text.size();
+}
+
+void appendTwoDigits(std::string &out, unsigned value) {
+  out += static_cast<char>('0' + value / 10);
+  out += static_cast<char>('0' + value % 10);
+}
+
+void appendDate(std::string &out, const CivilDate &date) {
+  appendTwoDigits(out, date.day);
+  out += '/';
+  appendTwoDigits(out, date.month);
+  out += '/';
+  char buffer[16];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), date.year);
+  out.append(buffer, result.ptr);
+}
+
+void appendInteger(std::string &out, int64_t value) {
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out.append(buffer, result.ptr);
+}
+
+// Describes why `text` is not a date
+void appendDateError(std::string &out, std::string_view text) {
+  try {
+    CivilDate::parse(text);
+  } catch (const std::exception &e) {
+    out += "Error: ";
+    out += e.what();
+  }
+}
+
+} // namespace
+
+DateBatch::DateBatch(size_t threads)
+    : pool_(threads), contexts_(pool_.size()) {}
+
+size_t DateBatch::run(std::istream &in, std::ostream &out) {
+  size_t failures = 0;
+  // Bytes at the front of block_ left over from the previous read
+  size_t carried = 0;
+
+  while (true) {
+    block_.resize(carried + kBlockBytes);
+    in.read(&block_[carried], kBlockBytes);
+    size_t size = carried + static_cast<size_t>(in.gcount());
+    bool ended = !in;
+    if (size == 0)
+      break;
+
+    // Hold back a trailing partial line until the rest has been read
+    size_t end = size;
+    if (!ended) {
+      size_t lastBreak = block_.rfind('\n', size - 1);
+      end = lastBreak == std::string::npos ? 0 : lastBreak + 1;
+    }
+
+    lines_.clear();
+    std::string_view text(block_.data(), end);
+    while (!text.empty()) {
+      size_t lineEnd = std::min(text.find('\n'), text.size());
+      lines_.push_back(text.substr(0, lineEnd));
+      text.remove_prefix(std::min(lineEnd + 1, text.size()));
+    }
+
+    if (!lines_.empty()) {
+      for (auto &context : contexts_)
+        context.output.clear();
+
+      pool_.parallelFor(lines_.size(), [this](size_t begin, size_t last,
+                                              size_t worker) {
+        WorkerContext &context = contexts_[worker];
+        for (size_t i = begin; i < last; ++i) {
+          if (!processRow(lines_[i], context.output))
+            ++context.failures;
+          context.output += '\n';
+        }
+      });
+
+      // Ranges are assigned in order, so concatenating per-worker buffers
+      // preserves input order
+      for (auto &context : contexts_) {
+        out.write(context.output.data(), context.output.size());
+        failures += context.failures;
+        context.failures = 0;
+      }
+    }
+
+    if (ended)
+      break;
+    carried = size - end;
+    std::copy(block_.begin() + end, block_.begin() + size, block_.begin());
+  }
+
+  out.flush();
+  return failures;
+}
+
+size_t DateBatch::runFile(const std::string &filename, std::ostream &out) {
+  if (filename == "-")
+    return run(std::cin, out);
+
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Failed to open file: " + filename);
+  }
+  return run(file, out);
+}
+
+bool DateBatch::processRow(std::string_view row, std::string &out) {
+  row = trim(row);
+  if (row.empty())
+    return true;
+
+  size_t comma = row.find(',');
+  if (comma == std::string_view::npos) {
+    out += "Error: Expected DATE,DATE or DATE,DAYS";
+    return false;
+  }
+  std::string_view first = trim(row.substr(0, comma));
+  std::string_view second = trim(row.substr(comma + 1));
+
+  CivilDate from;
+  if (!CivilDate::tryParse(first, from)) {
+    appendDateError(out, first);
+    return false;
+  }
+
+  int64_t days;
+  if (parseOffset(second, days)) {
+    CivilDate result;
+    if (!from.tryAddDays(days, result)) {
+      out += "Error: Date out of range";
+      return false;
+    }
+    appendDate(out, result);
+    return true;
+  }
+
+  CivilDate to;
+  if (!CivilDate::tryParse(second, to)) {
+    appendDateError(out, second);
+    return false;
+  }
+  appendInteger(out, CivilDate::difference(from, to));
+  return true;
+}
@@ -0,0 +1,64 @@
+#ifndef DATEBATCH_H
+#define DATEBATCH_H
+
+#include "../utils/ThreadPool.h"
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Non-interactive date arithmetic over CSV rows
+ *
+ * Each row is either two dates, "DATE1,DATE2", giving the signed number
+ * of days from DATE1 to DATE2, or a date and a day count, "DATE,N" (N
+ * may carry a sign), giving the shifted date as DD/MM/YYYY. Dates use
+ * the DateMode formats. One result line is written per input line, in
+ * input order; blank lines stay blank and bad rows produce
+ * "Error: <message>".
+ *
+ * Input is read in large blocks and split into lines in place; each
+ * block's lines are parsed and computed on a worker pool into
+ * per-worker output buffers, so only one block is held in memory.
+ */
+class DateBatch {
+public:
+  /**
+   * @param threads Worker count; 0 uses all hardware threads
+   */
+  explicit DateBatch(size_t threads = 0);
+
+  /**
+   * @brief Process every row of `in` and write results to `out`
+   * @return Number of rows that failed
+   */
+  size_t run(std::istream &in, std::ostream &out);
+
+  /**
+   * @brief Same as run() but reads from a file, or stdin for "-"
+   * @throws std::runtime_error if the file cannot be opened
+   */
+  size_t runFile(const std::string &filename, std::ostream &out);
+
+  /**
+   * @brief Compute one row and append its result (without newline)
+   * @return false if the row is malformed; `out` then holds the error
+   */
+  static bool processRow(std::string_view row, std::string &out);
+
+private:
+  // Bytes read per block; a block always ends at a line break
+  static constexpr size_t kBlockBytes = 4 << 20;
+
+  struct WorkerContext {
+    std::string output;
+    size_t failures = 0;
+  };
+
+  ThreadPool pool_;
+  std::vector<WorkerContext> contexts_;
+  std::string block_;
+  std::vector<std::string_view> lines_;
+};
+
+#endif // DATEBATCH_H
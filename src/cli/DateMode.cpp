@@ -1,8 +1,7 @@
 #include "DateMode.h"
-#include <cstring>
-#include <iomanip>
+#include "../backend/CivilDate.h"
+#include <cstdlib>
 #include <iostream>
-#include <sstream>
 
 void DateMode::execute() {
   std::cout << "\n=== Date Calculation Mode ===\n";
@@ -29,44 +28,94 @@ void DateMode::execute() {
         std::string date2Str;
         std::getline(std::cin, date2Str);
 
-        std::tm date1 = parseDate(date1Str);
-        std::tm date2 = parseDate(date2Str);
+        CivilDate date1 = CivilDate::parse(date1Str);
+        CivilDate date2 = CivilDate::parse(date2Str);
 
-        int diff = dateDifference(date1, date2);
-        std::cout << "Difference: " << std::abs(diff) << " days\n";
+        int64_t diff = CivilDate::difference(date1, date2);
+        std::cout << "Difference: " << std::llabs(diff) << " days\n";
       } else if (choice == 2) {
         std::cout << "Enter date: ";
         std::string dateStr;
         std::getline(std::cin, dateStr);
 
         std::cout << "Enter number of days to add (negative to subtract): ";
-        int days;
+        long long days;
         std::cin >> days;
         std::cin.ignore();
 
-        std::tm date = parseDate(dateStr);
-        std::tm result = addDays(date, days);
+        CivilDate date = CivilDate::parse(dateStr);
+        CivilDate result = date.addDaysChecked(days);
 
-        std::cout << "Result: " << formatDate(result) << "\n";
+        std::cout << "Result: " << result.toString() << "\n";
       } else if (choice == 3) {
         std::cout << "Enter target date: ";
         std::string dateStr;
         std::getline(std::cin, dateStr);
 
-        std::tm targetDate = parseDate(dateStr);
-        std::time_t now = std::time(nullptr);
-        std::tm *today = std::localtime(&now);
-
-        int diff = dateDifference(*today, targetDate);
+        CivilDate targetDate = CivilDate::parse(dateStr);
+        int64_t diff = CivilDate::difference(CivilDate::today(), targetDate);
 
         if (diff > 0) {
-          std::cout << "Days until " << formatDate(targetDate) << ": " << diff
+          std::cout << "Days until " << targetDate.toString() << ": " << diff
                     << " days\n";
         } else if (diff < 0) {
-          std::cout << "Date was " << abs(diff) << " days ago\n";
+          std::cout << "Date was " << -diff << " days ago\n";
         } else {
           std::cout << "That's today!\n";
         }
+      } else if (choice == 4) {
+        std::cout << "Enter date: ";
+        std::string dateStr;
+        std::getline(std::cin, dateStr);
+
+        static const char *const kNames[] = {
+            "Monday", "Tuesday",  "Wednesday", "Thursday",
+            "Friday", "Saturday", "Sunday"};
+        CivilDate date = CivilDate::parse(dateStr);
+        int32_t day = BusinessCalendar::dayNumber(date);
+        std::cout << date.toString() << " is a " << kNames[date.weekday() - 1]
+                  << (calendar_.isBusinessDay(day) ? " (business day)"
+                                                   : " (non-business day)")
+                  << "\n";
+      } else if (choice == 5) {
+        std::cout << "Enter first date: ";
+        std::string date1Str;
+        std::getline(std::cin, date1Str);
+
+        std::cout << "Enter second date: ";
+        std::string date2Str;
+        std::getline(std::cin, date2Str);
+
+        CivilDate date1 = CivilDate::parse(date1Str);
+        CivilDate date2 = CivilDate::parse(date2Str);
+
+        int32_t from = BusinessCalendar::dayNumber(date1);
+        int32_t to = BusinessCalendar::dayNumber(date2);
+        std::cout << "Business days: "
+                  << std::llabs(calendar_.businessDaysBetween(from, to))
+                  << " (earlier date counted, later date not)\n";
+      } else if (choice == 6) {
+        std::cout << "Enter date: ";
+        std::string dateStr;
+        std::getline(std::cin, dateStr);
+
+        std::cout << "Enter number of business days (negative to subtract): ";
+        int32_t days;
+        std::cin >> days;
+        std::cin.ignore();
+
+        int32_t day = BusinessCalendar::dayNumber(CivilDate::parse(dateStr));
+        CivilDate result =
+            CivilDate::fromDays(calendar_.addBusinessDays(day, days));
+        std::cout << "Result: " << result.toString() << "\n";
+      } else if (choice == 7) {
+        std::cout << "Enter holiday file (one DD/MM/YYYY per line): ";
+        std::string filename;
+        std::getline(std::cin, filename);
+
+        size_t count = calendar_.loadHolidays(filename);
+        std::cout << "Loaded " << count << " holidays ("
+                  << calendar_.holidayCount() << " on weekdays in total)\n";
       } else {
         std::cout << "Invalid choice.\n";
       }
@@ -82,55 +131,10 @@ void DateMode::displayMenu() {
   std::cout << "1. Calculate difference between two dates\n";
   std::cout << "2. Add/subtract days from a date\n";
   std::cout << "3. Days until a date\n";
+  std::cout << "4. Day of the week\n";
+  std::cout << "5. Business days between two dates\n";
+  std::cout << "6. Add/subtract business days\n";
+  std::cout << "7. Load holiday calendar\n";
   std::cout << "0. Back to main menu\n";
   std::cout << "> ";
 }
-
-std::tm DateMode::parseDate(const std::string &dateStr) {
-  std::tm date = {};
-  int day, month, year;
-  char sep;
-
-  std::istringstream iss(dateStr);
-  if (!(iss >> day >> sep >> month >> sep >> year)) {
-    throw std::runtime_error("Invalid date format. Use DD/MM/YYYY");
-  }
-
-  if (day < 1 || day > 31 || month < 1 || month > 12 || year < 1900) {
-    throw std::runtime_error("Invalid date values");
-  }
-
-  date.tm_mday = day;
-  date.tm_mon = month - 1;
-  date.tm_year = year - 1900;
-  date.tm_hour = 12;
-
-  return date;
-}
-
-int DateMode::dateDifference(const std::tm &date1, const std::tm &date2) {
-  std::tm d1 = date1;
-  std::tm d2 = date2;
-
-  std::time_t time1 = std::mktime(&d1);
-  std::time_t time2 = std::mktime(&d2);
-
-  double seconds = std::difftime(time2, time1);
-  return static_cast<int>(seconds / (60 * 60 * 24));
-}
-
-std::tm DateMode::addDays(const std::tm &date, int days) {
-  std::tm result = date;
-  std::time_t time = std::mktime(&result);
-  time += days * 24 * 60 * 60;
-
-  std::tm *newDate = std::localtime(&time);
-  return *newDate;
-}
-
-std::string DateMode::formatDate(const std::tm &date) {
-  std::ostringstream oss;
-  oss << std::setfill('0') << std::setw(2) << date.tm_mday << "/"
-      << std::setw(2) << (date.tm_mon + 1) << "/" << (date.tm_year + 1900);
-  return oss.str();
-}
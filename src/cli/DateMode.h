@@ -1,13 +1,15 @@
 #ifndef DATEMODE_H
 #define DATEMODE_H
 
-#include <ctime>
-#include <string>
+#include "../backend/BusinessCalendar.h"
 
 /**
  * @brief Date calculation mode for working with dates
  *
- * Supports date arithmetic, difference calculation, and formatting
+ * Supports date arithmetic, difference calculation, and formatting.
+ * Dates are CivilDate values, so results do not depend on the time zone
+ * and any year of the proleptic Gregorian calendar is accepted.
+ * Business days skip weekends and the holidays loaded during the session.
  */
 class DateMode {
 public:
@@ -17,25 +19,7 @@ public:
   void execute();
 
 private:
-  /**
-   * @brief Parse date string in format DD/MM/YYYY or DD-MM-YYYY
-   */
-  std::tm parseDate(const std::string &dateStr);
-
-  /**
-   * @brief Calculate difference between two dates in days
-   */
-  int dateDifference(const std::tm &date1, const std::tm &date2);
-
-  /**
-   * @brief Add days to a date
-   */
-  std::tm addDays(const std::tm &date, int days);
-
-  /**
-   * @brief Format date as string
-   */
-  std::string formatDate(const std::tm &date);
+  BusinessCalendar calendar_;
 
   /**
    * @brief Display date mode menu
@@ -1,11 +1,10 @@
 #include "Modes.h"
 #include "../backend/ExpressionEvaluator.h"
 #include "../backend/History.h"
-#include <bitset>
+#include <cctype>
 #include <iomanip>
 #include <iostream>
 #include <limits>
-#include <sstream>
 
 void StandardMode::run(History *history) {
   std::cout << "\n=== Standard Mode ===\n";
@@ -89,15 +88,19 @@ void ScientificMode::run(History *history) {
 
 void ProgrammerMode::run(History *history) {
   std::cout << "\n=== Programmer Mode ===\n";
-  std::cout << "Bitwise operations and base conversions.\n";
+  std::cout << "Integer expressions with C operators and precedence.\n";
   std::cout << "Supported operations:\n";
-  std::cout << "  &   - AND         Example: 12 & 10\n";
-  std::cout << "  |   - OR          Example: 12 | 10\n";
-  std::cout << "  ^   - XOR         Example: 12 ^ 10\n";
-  std::cout << "  ~   - NOT         Example: ~ 12\n";
-  std::cout << "  <<  - Shift left  Example: 3 << 2\n";
-  std::cout << "  >>  - Shift right Example: 12 >> 2\n";
-  std::cout << "\nOr just enter a number to see it in DEC, HEX, BIN\n";
+  std::cout << "  & | ^ ~          - bitwise     Example: (12 & 10) | 1\n";
+  std::cout << "  << >>            - shifts      Example: 1 << 40\n";
+  std::cout << "  + - * / %        - arithmetic  Example: 0xFF * 3 % 7\n";
+  std::cout << "  == != < <= > >= && || !        Example: 5 > 3 && 2 != 2\n";
+  std::cout << "  popcount() clz() ctz() bswap() Example: clz(0x00F0)\n";
+  std::cout << "  rotl(x, n) rotr(x, n)          Example: rotl(0x81, 1)\n";
+  std::cout << "Numbers: 42, 0x2A, 0o52, 0b101010 (0xFFFF_0000 grouping)\n";
+  std::cout << "Commands:\n";
+  std::cout << "  type T            - i8..i128 or u8..u128 (currently "
+            << type_.name() << ")\n";
+  std::cout << "\nResults are shown in DEC, HEX, BIN\n";
   std::cout << "Type 'q' or 'quit' to return to main menu.\n\n";
 
   std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
@@ -116,102 +119,117 @@ void ProgrammerMode::run(History *history) {
     }
 
     try {
-      int result = evaluateBitwiseExpression(input);
+      if (input.rfind("type", 0) == 0) {
+        std::string name = input.substr(4);
+        name.erase(0, name.find_first_not_of(" \t"));
+        type_ = IntegerExpression::Type::parse(name);
+        std::cout << "Type: " << type_.name() << std::endl;
+        continue;
+      }
+
+      IntegerExpression::Word result =
+          IntegerExpression::compile(input, type_).evaluate();
 
-      std::cout << "DEC: " << result << std::endl;
-      std::cout << "HEX: " << toHex(result) << std::endl;
-      std::cout << "BIN: " << toBinary(result) << std::endl;
+      std::cout << "DEC: " << IntegerExpression::toString(result, type_)
+                << std::endl;
+      std::cout << "HEX: " << IntegerExpression::toString(result, type_, 16)
+                << std::endl;
+      std::cout << "BIN: " << IntegerExpression::toString(result, type_, 2)
+                << std::endl;
 
       if (history) {
-        history->addEntry(input, static_cast<double>(result));
+        bool negative = type_.isSigned && (result >> 127) != 0;
+        double value = static_cast<double>(negative ? 0 - result : result);
+        history->addEntry(input, negative ? -value : value);
       }
     } catch (const std::exception &e) {
       std::cout << "Error: " << e.what() << std::endl;
-      std::cout << "Tip: Use format like '3 << 2' or '12 & 10' or just '15'\n";
+      std::cout << "Tip: Use format like '3 << 2' or '(12 & 10) | 1' or just "
+                   "'15'\n";
     }
   }
 }
 
-int ProgrammerMode::evaluateBitwiseExpression(const std::string &expr) {
-  std::istringstream iss(expr);
-  std::string token1, op, token2;
+void PrecisionMode::run(History *history) {
+  std::cout << "\n=== Precision Mode ===\n";
+  std::cout << "Expressions as in Scientific Mode, evaluated to any number "
+               "of digits.\n";
+  std::cout << "Commands:\n";
+  std::cout << "  digits N          - set precision (currently " << digits_
+            << ")\n";
+  std::cout << "  pi                - pi to the current precision\n";
+  std::cout << "  N!                - exact factorial, e.g. 10000!\n";
+  std::cout << "Examples:\n";
+  std::cout << "  sqrt(2)\n";
+  std::cout << "  exp(1) - 2^0.5\n";
+  std::cout << "\nType 'q' or 'quit' to return to main menu.\n\n";
+
+  std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+  while (true) {
+    std::cout << "prec> ";
+    std::string input;
+    std::getline(std::cin, input);
+
+    // Trim whitespace
+    input.erase(0, input.find_first_not_of(" \t\n\r"));
+    input.erase(input.find_last_not_of(" \t\n\r") + 1);
 
-  // Try to parse as: number operator number
-  if (iss >> token1) {
-    // Check if it's just a number (for conversion)
-    if (!(iss >> op)) {
-      return parseNumber(token1);
+    if (input == "q" || input == "quit" || input.empty()) {
+      break;
     }
 
-    if (op == "~") {
-      int a = parseNumber(token1 == "~" ? "" : token1);
-      if (token1 == "~") {
-        iss.str(expr.substr(1));
-        iss.clear();
-        iss >> token1;
-        a = parseNumber(token1);
+    if (input.rfind("digits", 0) == 0) {
+      std::string count = input.substr(6);
+      count.erase(0, count.find_first_not_of(" \t"));
+      if (count.empty() ||
+          count.find_first_not_of("0123456789") != std::string::npos ||
+          count.size() > 7 || std::stoul(count) == 0 ||
+          std::stoul(count) > kMaxDigits) {
+        std::cout << "Error: digits must be between 1 and " << kMaxDigits
+                  << std::endl;
+      } else {
+        digits_ = std::stoul(count);
+        std::cout << "Precision: " << digits_ << " digits\n";
       }
-      return ~a;
+      continue;
     }
 
-    // Binary operation
-    if (!(iss >> token2)) {
-      throw std::runtime_error("Missing second operand");
+    try {
+      double value;
+      std::string result = calculate(input, digits_, value);
+      std::cout << "= " << result << std::endl;
+      if (history) {
+        history->addEntry(input, value);
+      }
+    } catch (const std::exception &e) {
+      std::cout << "Error: " << e.what() << std::endl;
     }
-
-    int a = parseNumber(token1);
-    int b = parseNumber(token2);
-
-    if (op == "&")
-      return a & b;
-    if (op == "|")
-      return a | b;
-    if (op == "^")
-      return a ^ b;
-    if (op == "<<")
-      return a << b;
-    if (op == ">>")
-      return a >> b;
-
-    throw std::runtime_error("Unknown operator: " + op);
   }
-
-  throw std::runtime_error("Invalid expression format");
 }
 
-int ProgrammerMode::parseNumber(const std::string &str) {
-  if (str.empty()) {
-    throw std::runtime_error("Empty number");
-  }
-
-  // Check for hex (0x prefix)
-  if (str.length() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
-    return std::stoi(str, nullptr, 16);
+std::string PrecisionMode::calculate(const std::string &input, size_t digits,
+                                     double &value) {
+  std::string text;
+  for (char c : input) {
+    if (!std::isspace(static_cast<unsigned char>(c)))
+      text += c;
   }
 
-  // Check for binary (0b prefix)
-  if (str.length() > 2 && str[0] == '0' && (str[1] == 'b' || str[1] == 'B')) {
-    return std::stoi(str.substr(2), nullptr, 2);
+  BigFloat result;
+  size_t shown = digits;
+  if (text == "pi") {
+    result = BigFloat::pi(digits);
+  } else if (text.size() > 1 && text.back() == '!' &&
+             text.find_first_not_of("0123456789") == text.size() - 1) {
+    if (text.size() > 8 || std::stoul(text) > kMaxFactorial)
+      throw std::out_of_range("Factorial argument above " +
+                              std::to_string(kMaxFactorial));
+    result = BigFloat::factorial(static_cast<uint32_t>(std::stoul(text)));
+    shown = 0; // every digit
+  } else {
+    result = ExpressionEvaluator::evaluatePrecise(input, digits);
   }
-
-  // Decimal
-  return std::stoi(str);
-}
-
-std::string ProgrammerMode::toBinary(long long n) {
-  return std::bitset<32>(n).to_string();
-}
-
-std::string ProgrammerMode::toHex(long long n) {
-  std::stringstream ss;
-  ss << std::hex << std::uppercase << n;
-  return "0x" + ss.str();
-}
-
-long long ProgrammerMode::fromBinary(std::string s) {
-  return std::stoll(s, nullptr, 2);
-}
-
-long long ProgrammerMode::fromHex(std::string s) {
-  return std::stoll(s, nullptr, 16);
+  value = result.toDouble();
+  return result.toString(shown);
 }
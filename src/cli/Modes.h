@@ -1,6 +1,8 @@
 #ifndef MODES_H
 #define MODES_H
 
+#include "../backend/IntegerExpression.h"
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -31,12 +33,33 @@ public:
   std::string getName() const override { return "Programmer Mode"; }
 
 private:
-  int parseNumber(const std::string &str);
-  int evaluateBitwiseExpression(const std::string &expr);
-  std::string toBinary(long long n);
-  std::string toHex(long long n);
-  long long fromBinary(std::string s);
-  long long fromHex(std::string s);
+  // Width and signedness of the results; "type u32" etc. changes it
+  IntegerExpression::Type type_;
+};
+
+class PrecisionMode : public Mode {
+public:
+  static constexpr size_t kDefaultDigits = 50;
+  static constexpr size_t kMaxDigits = 1000000;
+  static constexpr unsigned long kMaxFactorial = 1000000;
+
+  explicit PrecisionMode(size_t digits = kDefaultDigits) : digits_(digits) {}
+  void run(History *history = nullptr) override;
+  std::string getName() const override { return "Precision Mode"; }
+
+  /**
+   * @brief Evaluate one line with `digits` significant digits
+   * @param value Set to the result rounded to a double
+   * @return The result as text
+   *
+   * "pi" gives pi and "N!" the exact factorial of N; anything else is
+   * evaluated as an expression (see ExpressionEvaluator::evaluatePrecise).
+   */
+  static std::string calculate(const std::string &input, size_t digits,
+                               double &value);
+
+private:
+  size_t digits_;
 };
 
 #endif
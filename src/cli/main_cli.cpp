@@ -1,7 +1,11 @@
 #include "../backend/ExpressionEvaluator.h"
+#include "../cli/BatchMode.h"
 #include "../cli/CalculatorApp.h"
+#include "../cli/DateBatch.h"
+#include "../cli/Modes.h"
 #include "../utils/ArgumentParser.h"
 #include <iostream>
+#include <memory>
 
 int main(int argc, char *argv[]) {
   // Parse command-line arguments
@@ -20,6 +24,13 @@ int main(int argc, char *argv[]) {
   if (args.shouldCalculateDirect()) {
     std::string expr = args.getExpression();
     try {
+      if (args.getPrecision() > 0) {
+        double value;
+        std::string result =
+            PrecisionMode::calculate(expr, args.getPrecision(), value);
+        std::cout << expr << " = " << result << std::endl;
+        return 0;
+      }
       double result = ExpressionEvaluator::evaluate(expr);
       std::cout << expr << " = " << result << std::endl;
       return 0;
@@ -29,9 +40,50 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Handle --batch (many expressions, one process)
+  if (args.shouldRunBatch()) {
+    try {
+      std::ios::sync_with_stdio(false);
+      std::unique_ptr<ResultCache> cache;
+      if (args.getCacheSize() > 0) {
+        cache = std::make_unique<ResultCache>(
+            args.getCacheSize(),
+            ResultCache::parsePolicy(args.getCachePolicy()));
+      }
+      BatchMode batch(args.getThreadCount(), cache.get());
+      size_t failures = batch.runFile(args.getBatchFile(), std::cout);
+      if (cache) {
+        auto stats = cache->stats();
+        std::cerr << "Cache: " << stats.hits << " hits, " << stats.misses
+                  << " misses, " << stats.evictions << " evictions\n";
+      }
+      return failures == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
+  // Handle --dates (date arithmetic over CSV rows)
+  if (args.shouldRunDates()) {
+    try {
+      std::ios::sync_with_stdio(false);
+      DateBatch dates(args.getThreadCount());
+      size_t failures = dates.runFile(args.getDatesFile(), std::cout);
+      return failures == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+
   // Interactive mode
   CalculatorApp app;
 
+  if (args.getPrecision() > 0) {
+    app.setPrecision(args.getPrecision());
+  }
+
   // Load history if requested
   if (args.shouldLoadHistory()) {
     try {
@@ -44,6 +96,11 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // Recover and keep appending to the journal if requested
+  if (args.shouldUseJournal() && !app.openJournal(args.getJournalFile())) {
+    return 1;
+  }
+
   app.run();
   return 0;
 }
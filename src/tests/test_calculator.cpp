@@ -1,10 +1,30 @@
+#include "../backend/BigFloat.h"
+#include "../backend/BusinessCalendar.h"
+#include "../backend/CivilDate.h"
 #include "../backend/ExpressionEvaluator.h"
 #include "../backend/History.h"
+#include "../backend/IntegerExpression.h"
 #include "../backend/MathUtils.h"
 #include "../backend/Sorter.h"
+#include "../cli/BatchMode.h"
+#include "../cli/DateBatch.h"
+#include "../utils/LinkedList.h"
+#include "../utils/StringInterner.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/UnrolledList.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
 #include <cmath>
+#include <filesystem>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
 
 // ==================== MathUtils Tests ====================
 
@@ -54,18 +74,77 @@ TEST(MathUtilsTest, TrigonometricFunctions) {
   EXPECT_NEAR(MathUtils::my_tan(MathUtils::PI / 4), 1.0, 1e-6);
 }
 
+TEST(MathUtilsTest, LargeArguments) {
+  // Payne-Hanek reduction keeps full accuracy far from zero
+  EXPECT_NEAR(MathUtils::my_sin(1e22), -0.8522008497671888, 1e-15);
+  EXPECT_NEAR(MathUtils::my_cos(1e22), 0.5232147853951389, 1e-15);
+  for (double x : {1e6 + 0.5, -3.7e9, 1e15, 1.5e300}) {
+    EXPECT_NEAR(MathUtils::my_sin(x), std::sin(x), 1e-15);
+    EXPECT_NEAR(MathUtils::my_cos(x), std::cos(x), 1e-15);
+  }
+  EXPECT_NEAR(ExpressionEvaluator::evaluate("sin(1000000000)"),
+              std::sin(1e9 * MathUtils::PI / 180.0), 1e-12);
+
+  EXPECT_NEAR(MathUtils::my_exp(700.0) / std::exp(700.0), 1.0, 1e-15);
+  EXPECT_NEAR(MathUtils::my_exp(-700.0) / std::exp(-700.0), 1.0, 1e-15);
+  EXPECT_NEAR(MathUtils::my_log(1e300), std::log(1e300), 1e-12);
+  EXPECT_NEAR(MathUtils::my_log(1e-300), std::log(1e-300), 1e-12);
+  EXPECT_NEAR(MathUtils::my_sqrt(1e-30), 1e-15, 1e-30);
+}
+
 TEST(MathUtilsTest, Abs) {
   EXPECT_EQ(MathUtils::my_abs(5.0), 5.0);
   EXPECT_EQ(MathUtils::my_abs(-5.0), 5.0);
   EXPECT_EQ(MathUtils::my_abs(0.0), 0.0);
 }
 
+TEST(MathUtilsTest, Factorial) {
+  EXPECT_EQ(MathUtils::factorial(0), 1);
+  EXPECT_EQ(MathUtils::factorial(10), 3628800);
+  EXPECT_EQ(MathUtils::factorial(20), 2432902008176640000LL);
+  EXPECT_THROW(MathUtils::factorial(21), std::overflow_error);
+}
+
 TEST(MathUtilsTest, ToRadians) {
   EXPECT_NEAR(MathUtils::to_radians(0.0), 0.0, 1e-9);
   EXPECT_NEAR(MathUtils::to_radians(180.0), MathUtils::PI, 1e-9);
   EXPECT_NEAR(MathUtils::to_radians(90.0), MathUtils::PI / 2, 1e-9);
 }
 
+TEST(MathUtilsTest, BatchFunctions) {
+  // Odd length so the padded tail of every vector width is covered
+  const size_t n = 1001;
+  std::vector<double> in(n), out(n);
+
+  for (size_t i = 0; i < n; ++i)
+    in[i] = -50.0 + 0.1 * i;
+  MathUtils::sin(in.data(), out.data(), n);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(out[i], std::sin(in[i]), 1e-14);
+  MathUtils::cos(in.data(), out.data(), n);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(out[i], std::cos(in[i]), 1e-14);
+  MathUtils::exp(in.data(), out.data(), n);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(out[i] / std::exp(in[i]), 1.0, 1e-14);
+
+  for (size_t i = 0; i < n; ++i)
+    in[i] = 1e-3 + 0.37 * i * i;
+  MathUtils::log(in.data(), out.data(), n);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(out[i], std::log(in[i]), 1e-14);
+  MathUtils::sqrt(in.data(), out.data(), n);
+  for (size_t i = 0; i < n; ++i)
+    EXPECT_NEAR(out[i] / std::sqrt(in[i]), 1.0, 1e-15);
+
+  // In-place use and IEEE results instead of exceptions
+  double special[] = {0.0, -1.0, 4.0};
+  MathUtils::sqrt(special, special, 3);
+  EXPECT_EQ(special[0], 0.0);
+  EXPECT_TRUE(std::isnan(special[1]));
+  EXPECT_EQ(special[2], 2.0);
+}
+
 // ==================== ExpressionEvaluator Tests ====================
 
 TEST(ExpressionEvaluatorTest, BasicArithmetic) {
@@ -102,6 +181,580 @@ TEST(ExpressionEvaluatorTest, DivisionByZero) {
   EXPECT_THROW(ExpressionEvaluator::evaluate("10 / 0"), std::runtime_error);
 }
 
+TEST(ExpressionEvaluatorTest, CompiledExpressionReuse) {
+  CompiledExpression expr = ExpressionEvaluator::compile("2 + 3 * sqrt(16)");
+  // Folded to a single constant at compile time
+  EXPECT_EQ(expr.code().size(), 1u);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(expr.evaluate(), 14.0, 1e-6);
+  }
+
+  // Recompiling into the same object replaces the previous program
+  ExpressionEvaluator::compile("(1 + 2) * (3 + 4)", expr);
+  EXPECT_NEAR(expr.evaluate(), 21.0, 1e-9);
+}
+
+TEST(ExpressionEvaluatorTest, CompileRejectsMalformed) {
+  EXPECT_THROW(ExpressionEvaluator::compile("2 +"), std::runtime_error);
+  EXPECT_THROW(ExpressionEvaluator::compile("sqrt()"), std::runtime_error);
+  EXPECT_THROW(ExpressionEvaluator::compile(""), std::runtime_error);
+  EXPECT_THROW(CompiledExpression().evaluate(), std::runtime_error);
+
+  // Division by zero is a runtime property, not a parse error
+  CompiledExpression div = ExpressionEvaluator::compile("1 / 0");
+  EXPECT_THROW(div.evaluate(), std::runtime_error);
+}
+
+TEST(ExpressionEvaluatorTest, Variables) {
+  CompiledExpression expr =
+      ExpressionEvaluator::compile("rate * x + sqrt(y) - x");
+  ASSERT_EQ(expr.variables().size(), 3u);
+  EXPECT_EQ(expr.variableIndex("rate"), 0u);
+  EXPECT_EQ(expr.variableIndex("x"), 1u);
+  EXPECT_EQ(expr.variableIndex("y"), 2u);
+  EXPECT_EQ(expr.variableIndex("z"), CompiledExpression::npos);
+
+  EXPECT_NEAR(expr.evaluate({2.0, 5.0, 16.0}), 9.0, 1e-9);
+  EXPECT_THROW(expr.evaluate(), std::runtime_error);
+  EXPECT_THROW(ExpressionEvaluator::evaluate("x + 1"), std::runtime_error);
+}
+
+TEST(ExpressionEvaluatorTest, BatchEvaluation) {
+  CompiledExpression expr = ExpressionEvaluator::compile("x * x + y / 2");
+
+  // Larger than one block so the tail path is exercised too
+  const size_t rows = 1000;
+  std::vector<double> xs(rows), ys(rows), out(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    xs[i] = static_cast<double>(i);
+    ys[i] = static_cast<double>(2 * i);
+  }
+
+  const double *columns[] = {xs.data(), ys.data()};
+  expr.evaluateBatch(columns, rows, out.data());
+
+  for (size_t i = 0; i < rows; ++i) {
+    EXPECT_DOUBLE_EQ(out[i], xs[i] * xs[i] + ys[i] / 2);
+  }
+
+  CompiledExpression fn = ExpressionEvaluator::compile("sin(x) + sqrt(y) ^ 2");
+  fn.evaluateBatch(columns, rows, out.data());
+  for (size_t i = 0; i < rows; i += 37) {
+    EXPECT_NEAR(out[i], fn.evaluate({xs[i], ys[i]}), 1e-6);
+  }
+
+  ys[500] = 0;
+  CompiledExpression div = ExpressionEvaluator::compile("x / y");
+  EXPECT_THROW(div.evaluateBatch(columns, rows, out.data()),
+               std::runtime_error);
+}
+
+TEST(ExpressionEvaluatorTest, Optimizer) {
+  using OpCode = CompiledExpression::OpCode;
+  auto ops = [](const CompiledExpression &expr) {
+    std::vector<OpCode> result;
+    for (const auto &ins : expr.code())
+      result.push_back(ins.op);
+    return result;
+  };
+
+  CompiledExpression folded = ExpressionEvaluator::compile("sqrt(144) * x + 0");
+  EXPECT_EQ(ops(folded), (std::vector<OpCode>{OpCode::PushConst,
+                                               OpCode::LoadVar, OpCode::Mul}));
+  EXPECT_DOUBLE_EQ(folded.evaluate({2.0}), 24.0);
+
+  CompiledExpression square = ExpressionEvaluator::compile("(x + 1) ^ 2 * 1");
+  EXPECT_EQ(ops(square),
+            (std::vector<OpCode>{OpCode::LoadVar, OpCode::PushConst,
+                                 OpCode::Add, OpCode::Dup, OpCode::Mul}));
+
+  // Repeated subexpressions are computed once
+  CompiledExpression shared =
+      ExpressionEvaluator::compile("sin(x) * y + sin(x) / y ^ 3");
+  auto code = ops(shared);
+  EXPECT_EQ(std::count(code.begin(), code.end(), OpCode::Sin), 1);
+  EXPECT_EQ(std::count(code.begin(), code.end(), OpCode::PowInt), 1);
+  EXPECT_EQ(std::count(code.begin(), code.end(), OpCode::Pow), 0);
+
+  // Integer powers keep my_pow's special cases
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("2 ^ 10"), 1024.0);
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("(0 - 2) ^ 3"), -8.0);
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("2 ^ (0 - 2)"), 0.25);
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("0 ^ 0"), 0.0);
+
+  // Folding must not turn runtime errors into compile errors
+  CompiledExpression error = ExpressionEvaluator::compile("x + 1 / 0");
+  EXPECT_THROW(error.evaluate({1.0}), std::runtime_error);
+
+  // Batch evaluation runs the same optimized program
+  const size_t rows = 300;
+  std::vector<double> xs(rows), ys(rows), out(rows);
+  for (size_t i = 0; i < rows; ++i) {
+    xs[i] = static_cast<double>(i) - 150;
+    ys[i] = 0.5 + i % 7;
+  }
+  const double *columns[] = {xs.data(), ys.data()};
+  shared.evaluateBatch(columns, rows, out.data());
+  for (size_t i = 0; i < rows; ++i)
+    EXPECT_NEAR(out[i], shared.evaluate({xs[i], ys[i]}), 1e-9);
+}
+
+TEST(ExpressionEvaluatorTest, Tokenizer) {
+  // Numbers parse exactly as std::stod does
+  for (const char *number : {"0.1", "1e22", "123456.789", "9007199254740993",
+                             "2.5e300", "0x1A", "1e"})
+    EXPECT_EQ(ExpressionEvaluator::evaluate(number), std::stod(number))
+        << number;
+  EXPECT_THROW(ExpressionEvaluator::evaluate("1e400"), std::out_of_range);
+
+  // Whitespace does not split numbers or names
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("1 2 + 3"), 15.0);
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("s qrt(16)"), 4.0);
+
+  // Long expressions spill the token lists to the heap
+  std::string sum = "1";
+  for (int i = 0; i < 500; ++i)
+    sum += "+1";
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate(sum), 501.0);
+  EXPECT_THROW(ExpressionEvaluator::evaluate("2 * y"), std::runtime_error);
+}
+
+TEST(ExpressionEvaluatorTest, Precise) {
+  auto precise = [](const std::string &expr, size_t digits = 50) {
+    return ExpressionEvaluator::evaluatePrecise(expr, digits).toString(digits);
+  };
+
+  EXPECT_EQ(precise("2^100"), "1267650600228229401496703205376");
+  EXPECT_EQ(precise("0.1 + 0.2"), "0.3");
+  EXPECT_EQ(precise("(1 + 2) * 3 / 4"), "2.25");
+  EXPECT_EQ(precise("sin(30)"), "0.5");
+  EXPECT_EQ(precise("cos(180)"), "-1");
+  EXPECT_EQ(precise("sqrt(2)", 30), "1.41421356237309504880168872421");
+  EXPECT_EQ(precise("log(10)", 30), "2.30258509299404568401799145468");
+
+  EXPECT_THROW(precise("1/0"), std::runtime_error);
+  EXPECT_THROW(precise("tan(90)"), std::invalid_argument);
+  EXPECT_THROW(precise("tan(0 - 270)"), std::invalid_argument);
+  try {
+    precise("tan(90)");
+  } catch (const std::invalid_argument &e) {
+    EXPECT_STREQ(e.what(), "Tangent undefined");
+  }
+  EXPECT_THROW(precise("log(0)"), std::invalid_argument);
+  EXPECT_THROW(precise("sqrt(0 - 1)"), std::invalid_argument);
+  EXPECT_THROW(precise("2 * y"), std::runtime_error);
+}
+
+// ==================== BigFloat Tests ====================
+
+TEST(BigFloatTest, Arithmetic) {
+  BigFloat a = BigFloat::parse("-12.5e-3");
+  EXPECT_EQ(a.toString(), "-0.0125");
+  EXPECT_EQ(BigFloat::parse("1e30").toString(10), "1e+30");
+  EXPECT_EQ(BigFloat::parse("1e30").toString().size(), 31u);
+  EXPECT_THROW(BigFloat::parse("1.2.3"), std::invalid_argument);
+
+  // Sums and products of exact values stay exact
+  EXPECT_EQ((BigFloat::parse("0.1") + BigFloat::parse("0.2")).toString(),
+            "0.3");
+  EXPECT_EQ(BigFloat::div(6, 3, 20).toString(), "2");
+  EXPECT_EQ(BigFloat::div(1, 4, 20).toString(), "0.25");
+  EXPECT_EQ(BigFloat::div(1, 3, 20).toString(20), "0.33333333333333333333");
+  EXPECT_EQ(BigFloat::mod(BigFloat::parse("-7"), 3).toString(), "2");
+  EXPECT_THROW(BigFloat::div(1, 0, 20), std::runtime_error);
+
+  // 1000! has 2568 digits; the quotient needs the large multiplications
+  // and the Newton division to be exact
+  std::string digits = BigFloat::factorial(1000).toString();
+  EXPECT_EQ(digits.size(), 2568u);
+  EXPECT_EQ(digits.substr(0, 10), "4023872600");
+  BigFloat big = BigFloat::factorial(20000);
+  EXPECT_EQ(BigFloat::div(big, BigFloat::factorial(19999), 100), 20000);
+  EXPECT_EQ(BigFloat::factorial(20).toDouble(), 2432902008176640000.0);
+}
+
+TEST(BigFloatTest, Functions) {
+  EXPECT_EQ(BigFloat::pi(50).toString(50),
+            "3.1415926535897932384626433832795028841971693993751");
+  EXPECT_EQ(BigFloat::exp(1, 50).toString(50),
+            "2.7182818284590452353602874713526624977572470937");
+  EXPECT_EQ(BigFloat::sqrt(2, 50).toString(50),
+            "1.4142135623730950488016887242096980785696718753769");
+  EXPECT_EQ(BigFloat::log(10, 50).toString(50),
+            "2.3025850929940456840179914546843642076011014886288");
+  EXPECT_EQ(BigFloat::pow(2, BigFloat::parse("0.5"), 50).toString(50),
+            BigFloat::sqrt(2, 50).toString(50));
+  EXPECT_NEAR(BigFloat::sin(1, 30).toDouble(), std::sin(1.0), 1e-15);
+  EXPECT_NEAR(BigFloat::cos(1, 30).toDouble(), std::cos(1.0), 1e-15);
+  EXPECT_THROW(BigFloat::sqrt(-1, 20), std::invalid_argument);
+  EXPECT_THROW(BigFloat::log(0, 20), std::invalid_argument);
+  EXPECT_THROW(BigFloat::pow(-2, BigFloat::parse("0.5"), 20),
+               std::invalid_argument);
+}
+
+// ==================== IntegerExpression Tests ====================
+
+TEST(IntegerExpressionTest, WidthsAndPrecedence) {
+  using Type = IntegerExpression::Type;
+  auto eval = [](const char *text, const char *type) {
+    Type t = Type::parse(type);
+    return IntegerExpression::toString(
+        IntegerExpression::compile(text, t).evaluate(), t);
+  };
+  auto hex = [](const char *text, const char *type) {
+    Type t = Type::parse(type);
+    return IntegerExpression::toString(
+        IntegerExpression::compile(text, t).evaluate(), t, 16);
+  };
+
+  EXPECT_EQ(eval("1 << 40", "i64"), "1099511627776");
+  EXPECT_EQ(eval("1 + 2 * 3 << 1 | 1", "i64"), "15");
+  EXPECT_EQ(eval("2 - 3 - 4", "i64"), "-5");
+  EXPECT_EQ(eval("(12 & 10) | 1 ^ 3", "i64"), "10");
+  EXPECT_EQ(eval("5 > 3 && 2 != 2 || !0", "i64"), "1");
+  EXPECT_EQ(eval("-7 / 2", "i32"), "-3");
+  EXPECT_EQ(eval("-7 % 2", "i32"), "-1");
+
+  // Results wrap to the width; signedness picks / % >> and comparisons
+  EXPECT_EQ(eval("0xFFFFFFFF", "i32"), "-1");
+  EXPECT_EQ(eval("-1", "u32"), "4294967295");
+  EXPECT_EQ(eval("255 + 1", "u8"), "0");
+  EXPECT_EQ(eval("127 + 1", "i8"), "-128");
+  EXPECT_EQ(eval("-16 >> 2", "i16"), "-4");
+  EXPECT_EQ(eval("0xFFF0 >> 2", "u16"), "16380");
+  EXPECT_EQ(eval("-1 < 0", "i64"), "1");
+  EXPECT_EQ(eval("-1 < 0", "u64"), "0");
+  EXPECT_EQ(eval("(-9223372036854775807 - 1) / -1", "i64"),
+            "-9223372036854775808");
+  EXPECT_EQ(eval("1 << 64", "u64"), "0");
+  EXPECT_EQ(eval("-1 >> 100", "i64"), "-1");
+  EXPECT_EQ(eval("~0", "u128"), "340282366920938463463374607431768211455");
+  EXPECT_EQ(eval("1 << 127", "i128"),
+            "-170141183460469231731687303715884105728");
+
+  EXPECT_EQ(eval("popcount(0xFF00_FF00)", "u32"), "16");
+  EXPECT_EQ(eval("clz(1)", "u32"), "31");
+  EXPECT_EQ(eval("clz(0)", "u8"), "8");
+  EXPECT_EQ(eval("ctz(0x100)", "u64"), "8");
+  EXPECT_EQ(eval("ctz(0)", "u128"), "128");
+  EXPECT_EQ(hex("bswap(0x1234)", "u16"), "0x3412");
+  EXPECT_EQ(hex("bswap(0x0102030405060708)", "u64"), "0x807060504030201");
+  EXPECT_EQ(hex("rotl(0x81, 1)", "u8"), "0x3");
+  EXPECT_EQ(hex("rotr(0x81, 1)", "u8"), "0xC0");
+  EXPECT_EQ(hex("rotl(1, 65)", "u64"), "0x2");
+  EXPECT_EQ(hex("0o17 + 0b1", "u8"), "0x10");
+  EXPECT_EQ(hex("-1", "i16"), "0xFFFF");
+  EXPECT_EQ(IntegerExpression::toString(5, Type::parse("u8"), 2), "00000101");
+
+  EXPECT_THROW(IntegerExpression::compile("1 / 0").evaluate(),
+               std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile("1 % (2 - 2)").evaluate(),
+               std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile("(1 + 2"), std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile("1 +"), std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile("foo(1)"), std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile("rotl(1)"), std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile("0b102"), std::runtime_error);
+  EXPECT_THROW(
+      IntegerExpression::compile("340282366920938463463374607431768211456"),
+      std::out_of_range);
+  EXPECT_THROW(Type::parse("i24"), std::invalid_argument);
+
+  // Nesting is bounded instead of recursing until the stack overflows
+  auto nested = [](size_t depth) {
+    return std::string(depth, '(') + "-1" + std::string(depth, ')');
+  };
+  EXPECT_EQ(IntegerExpression::compile(nested(200)).evaluate(),
+            IntegerExpression::Word(-1));
+  EXPECT_THROW(IntegerExpression::compile(nested(100000)),
+               std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile(std::string(100000, '-') + "1"),
+               std::runtime_error);
+  EXPECT_THROW(IntegerExpression::compile(std::string(100000, '~') + "1"),
+               std::runtime_error);
+}
+
+TEST(IntegerExpressionTest, CompiledBatch) {
+  using Word = IntegerExpression::Word;
+  auto expr = IntegerExpression::compile("rotl(value & mask, shift) ^ value",
+                                         IntegerExpression::Type::parse("u32"));
+  ASSERT_EQ(expr.variables().size(), 3u);
+  EXPECT_EQ(expr.variableIndex("mask"), 1u);
+  EXPECT_EQ(expr.variableIndex("other"), IntegerExpression::npos);
+
+  // Enough rows for several blocks and a partial one
+  const size_t rows = 1000;
+  std::vector<uint64_t> value(rows), mask(rows), shift(rows);
+  std::mt19937_64 rng(7);
+  for (size_t i = 0; i < rows; ++i) {
+    value[i] = rng();
+    mask[i] = rng();
+    shift[i] = rng() % 40;
+  }
+  const uint64_t *columns[] = {value.data(), mask.data(), shift.data()};
+  std::vector<uint64_t> out(rows);
+  expr.evaluateBatch(columns, rows, out.data());
+
+  for (size_t i = 0; i < rows; ++i) {
+    uint32_t bits = static_cast<uint32_t>(value[i] & mask[i]);
+    unsigned n = shift[i] % 32;
+    uint32_t rotated = n ? (bits << n) | (bits >> (32 - n)) : bits;
+    uint64_t expected = rotated ^ static_cast<uint32_t>(value[i]);
+    ASSERT_EQ(out[i], expected) << "row " << i;
+    ASSERT_EQ(expr.evaluate({Word(value[i]), Word(mask[i]), Word(shift[i])}),
+              Word(expected));
+  }
+
+  // Signed results come back sign-extended to the column width
+  auto negate = IntegerExpression::compile(
+      "-x", IntegerExpression::Type::parse("i8"));
+  const uint64_t x[] = {1, 0x80};
+  const uint64_t *xColumn[] = {x};
+  uint64_t negated[2];
+  negate.evaluateBatch(xColumn, 2, negated);
+  EXPECT_EQ(negated[0], ~uint64_t(0));
+  EXPECT_EQ(negated[1], 0xFFFFFFFFFFFFFF80u);
+
+  auto wide = IntegerExpression::compile(
+      "x", IntegerExpression::Type::parse("u128"));
+  EXPECT_THROW(wide.evaluateBatch(xColumn, 2, negated), std::invalid_argument);
+  EXPECT_THROW(negate.evaluate(), std::runtime_error);
+
+  const uint64_t y[] = {1, 0};
+  const uint64_t *divide[] = {x, y};
+  EXPECT_THROW(
+      IntegerExpression::compile("x / y").evaluateBatch(divide, 2, negated),
+      std::runtime_error);
+}
+
+// ==================== CivilDate Tests ====================
+
+TEST(CivilDateTest, DayNumbers) {
+  static_assert(CivilDate{1970, 1, 1}.toDays() == 0, "epoch");
+  static_assert(CivilDate::fromDays(11016) == CivilDate{2000, 2, 29},
+                "leap day");
+  static_assert(CivilDate{2024, 3, 1}.addDays(-1).day == 29, "leap year");
+  static_assert(CivilDate{1900, 3, 1}.addDays(-1).day == 28, "not leap");
+
+  EXPECT_EQ(CivilDate::difference({1900, 1, 1}, {2000, 1, 1}), 36524);
+  EXPECT_EQ(CivilDate::difference({2024, 12, 31}, {2024, 1, 1}), -365);
+  EXPECT_EQ((CivilDate{1, 1, 1}.toDays()), -719162);
+  EXPECT_EQ((CivilDate{2024, 3, 10}.weekday()), 7u); // Sunday
+  EXPECT_EQ((CivilDate{1969, 12, 29}.weekday()), 1u);
+
+  // The checked paths stop where the year no longer fits an int
+  static_assert(CivilDate{INT_MIN, 1, 1}.toDays() == CivilDate::kMinDays,
+                "first day");
+  static_assert(CivilDate{INT_MAX, 12, 31}.toDays() == CivilDate::kMaxDays,
+                "last day");
+  EXPECT_EQ(CivilDate::fromDaysChecked(CivilDate::kMaxDays),
+            (CivilDate{INT_MAX, 12, 31}));
+  EXPECT_THROW(CivilDate::fromDaysChecked(CivilDate::kMaxDays + 1),
+               std::out_of_range);
+  CivilDate start{2000, 1, 1};
+  EXPECT_EQ(start.addDaysChecked(CivilDate::kMinDays - start.toDays()),
+            (CivilDate{INT_MIN, 1, 1}));
+  EXPECT_THROW(start.addDaysChecked(1000000000000), std::out_of_range);
+  EXPECT_THROW(start.addDaysChecked(INT64_MAX), std::out_of_range);
+  EXPECT_THROW(start.addDaysChecked(INT64_MIN), std::out_of_range);
+
+  // Every day over several 400-year cycles, both sides of the epoch
+  CivilDate date{-400, 1, 1};
+  for (int64_t days = date.toDays(); date.year < 2401; ++days) {
+    ASSERT_EQ(CivilDate::fromDays(days), date) << days;
+    ASSERT_EQ(date.toDays(), days);
+    if (++date.day > CivilDate::daysInMonth(date.year, date.month)) {
+      date.day = 1;
+      if (++date.month > 12) {
+        date.month = 1;
+        ++date.year;
+      }
+    }
+  }
+}
+
+TEST(CivilDateTest, ParseAndFormat) {
+  EXPECT_EQ(CivilDate::parse("05/03/2024"), (CivilDate{2024, 3, 5}));
+  EXPECT_EQ(CivilDate::parse(" 1-2-1066 "), (CivilDate{1066, 2, 1}));
+  EXPECT_EQ(CivilDate::parse("29.02.2000").toString(), "29/02/2000");
+  EXPECT_EQ((CivilDate{1066, 10, 14}.toString()), "14/10/1066");
+  EXPECT_THROW(CivilDate::parse("29/02/1900"), std::runtime_error);
+  EXPECT_THROW(CivilDate::parse("31/04/2024"), std::runtime_error);
+  EXPECT_THROW(CivilDate::parse("2024-03-05x"), std::runtime_error);
+  CivilDate date;
+  EXPECT_FALSE(CivilDate::tryParse("1/13/2024", date));
+  EXPECT_FALSE(CivilDate::tryParse("", date));
+  EXPECT_TRUE(CivilDate::tryParse("31/12/9999", date));
+  EXPECT_EQ(date.addDays(1), (CivilDate{10000, 1, 1}));
+}
+
+TEST(CivilDateTest, BusinessCalendar) {
+  auto day = [](int year, unsigned month, unsigned dayOfMonth) {
+    return static_cast<int32_t>(CivilDate{year, month, dayOfMonth}.toDays());
+  };
+  BusinessCalendar calendar;
+  calendar.addHoliday({2024, 12, 25});
+  calendar.addHoliday({2024, 12, 28}); // Saturday: ignored
+  calendar.addHoliday({1999, 1, 1});
+  EXPECT_EQ(calendar.holidayCount(), 2u);
+
+  // Mon 23/12/2024 .. Fri 03/01/2025 has 10 weekdays, one a holiday
+  EXPECT_EQ(calendar.businessDaysBetween(day(2024, 12, 23), day(2025, 1, 4)),
+            9);
+  EXPECT_EQ(calendar.businessDaysBetween(day(2025, 1, 4), day(2024, 12, 23)),
+            -9);
+  EXPECT_FALSE(calendar.isBusinessDay(day(2024, 12, 25)));
+  EXPECT_EQ(calendar.addBusinessDays(day(2024, 12, 24), 1), day(2024, 12, 26));
+  EXPECT_EQ(calendar.addBusinessDays(day(2024, 12, 26), -1),
+            day(2024, 12, 24));
+  EXPECT_EQ(calendar.addBusinessDays(day(2024, 12, 28), 0), day(2024, 12, 30));
+  EXPECT_EQ(calendar.addBusinessDays(day(2024, 12, 20), 5), day(2024, 12, 30));
+
+  // Batch forms against the single-day ones, including negative days
+  std::vector<int32_t> days, offsets;
+  for (int32_t d = day(1998, 12, 1); d < day(2025, 2, 1); d += 13) {
+    days.push_back(d);
+    offsets.push_back(d % 41 - 20);
+  }
+  days.push_back(-1);
+  offsets.push_back(3);
+  size_t n = days.size();
+  std::vector<uint8_t> weekdays(n), business(n);
+  std::vector<int32_t> shifted(n);
+  std::vector<int64_t> counts(n);
+  BusinessCalendar::weekdays(days.data(), weekdays.data(), n);
+  calendar.isBusinessDay(days.data(), business.data(), n);
+  calendar.addBusinessDays(days.data(), offsets.data(), shifted.data(), n);
+  calendar.businessDaysBetween(days.data(), shifted.data(), counts.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    EXPECT_EQ(weekdays[i], CivilDate::fromDays(days[i]).weekday());
+    EXPECT_EQ(business[i] != 0, calendar.isBusinessDay(days[i]));
+    EXPECT_TRUE(calendar.isBusinessDay(shifted[i]));
+    EXPECT_EQ(counts[i], calendar.businessDaysBetween(days[i], shifted[i]));
+    // Counted after the day going forwards, before it going backwards
+    if (offsets[i] > 0)
+      EXPECT_EQ(calendar.businessDaysBetween(days[i] + 1, shifted[i] + 1),
+                offsets[i]);
+    else
+      EXPECT_EQ(calendar.businessDaysBetween(shifted[i], days[i]),
+                -offsets[i]);
+  }
+
+  int32_t dates[] = {day(2023, 1, 31), day(2024, 2, 29), day(2024, 3, 15)};
+  int32_t out[3];
+  BusinessCalendar::addMonths(dates, 1, out, 3);
+  EXPECT_EQ(out[0], day(2023, 2, 28));
+  EXPECT_EQ(out[1], day(2024, 3, 31));
+  EXPECT_EQ(out[2], day(2024, 4, 15));
+  BusinessCalendar::addMonths(dates, -13, out, 3, false);
+  EXPECT_EQ(out[1], day(2023, 1, 29));
+  BusinessCalendar::endOfMonth(dates, out, 3);
+  EXPECT_EQ(out[2], day(2024, 3, 31));
+
+  const std::string filename = "test_holidays.txt";
+  {
+    std::ofstream file(filename);
+    file << "# New Year\n01/01/2025\n\n06-01-2025\n";
+  }
+  EXPECT_EQ(calendar.loadHolidays(filename), 2u);
+  EXPECT_EQ(calendar.holidayCount(), 4u);
+  EXPECT_EQ(calendar.addBusinessDays(day(2024, 12, 31), 1), day(2025, 1, 2));
+  {
+    std::ofstream file(filename);
+    file << "01/01/2025\nnot a date\n";
+  }
+  EXPECT_THROW(calendar.loadHolidays(filename), std::runtime_error);
+  {
+    std::ofstream file(filename);
+    file << "01/01/2025\n01/01/6000000\n"; // past the int32 day range
+  }
+  EXPECT_THROW(calendar.loadHolidays(filename), std::runtime_error);
+  std::remove(filename.c_str());
+  EXPECT_EQ(BusinessCalendar::dayNumber({5000000, 1, 1}),
+            (CivilDate{5000000, 1, 1}.toDays()));
+  EXPECT_THROW(BusinessCalendar::dayNumber({6000000, 1, 1}),
+               std::out_of_range);
+  EXPECT_THROW(calendar.addHoliday({-6000000, 1, 1}), std::out_of_range);
+
+  // Results past the int32 day range throw instead of wrapping;
+  // INT32_MAX is Friday 11/07/5881580, INT32_MIN Tuesday 23/06/-5877641
+  BusinessCalendar edges;
+  EXPECT_EQ(edges.addBusinessDays(INT32_MAX - 1, 1), INT32_MAX);
+  EXPECT_THROW(edges.addBusinessDays(INT32_MAX, 1), std::out_of_range);
+  EXPECT_THROW(edges.addBusinessDays(INT32_MAX - 3, 10), std::out_of_range);
+  EXPECT_EQ(edges.addBusinessDays(INT32_MIN + 1, -1), INT32_MIN);
+  EXPECT_THROW(edges.addBusinessDays(INT32_MIN, -1), std::out_of_range);
+  int32_t edge[] = {INT32_MAX - 3};
+  int32_t edgeOut[1];
+  EXPECT_THROW(BusinessCalendar::addMonths(edge, 12, edgeOut, 1),
+               std::out_of_range);
+  BusinessCalendar::addMonths(edge, -12, edgeOut, 1);
+  EXPECT_EQ(edgeOut[0], (CivilDate{5881579, 7, 8}.toDays()));
+  EXPECT_THROW(BusinessCalendar::endOfMonth(edge, edgeOut, 1),
+               std::out_of_range);
+
+  EXPECT_THROW(BusinessCalendar(0x7f), std::invalid_argument);
+}
+
+TEST(CivilDateTest, DateBatchRows) {
+  std::string out;
+  EXPECT_TRUE(DateBatch::processRow("01/01/2024,01/03/2024", out));
+  out += '|';
+  EXPECT_TRUE(DateBatch::processRow(" 01-03-2024 , 01-01-2024\r", out));
+  out += '|';
+  EXPECT_TRUE(DateBatch::processRow("28/02/2024,+1", out));
+  out += '|';
+  EXPECT_TRUE(DateBatch::processRow("01.01.2000,-36524", out));
+  EXPECT_EQ(out, "60|-60|29/02/2024|01/01/1900");
+
+  out.clear();
+  EXPECT_FALSE(DateBatch::processRow("31/02/2024,1", out));
+  EXPECT_EQ(out, "Error: Invalid date values");
+  out.clear();
+  EXPECT_FALSE(DateBatch::processRow("01/01/2024", out));
+  EXPECT_FALSE(DateBatch::processRow("01/01/2024,x", out));
+  out.clear();
+  EXPECT_FALSE(DateBatch::processRow("01/01/2000,9223372036854775807", out));
+  EXPECT_EQ(out, "Error: Date out of range");
+  out.clear();
+  EXPECT_FALSE(DateBatch::processRow("01/01/2000,1000000000000", out));
+  EXPECT_EQ(out, "Error: Date out of range");
+  out.clear();
+  EXPECT_FALSE(DateBatch::processRow("01/01/2000,-9223372036854775808", out));
+  EXPECT_EQ(out, "Error: Date out of range");
+
+  // Streamed in blocks, computed in parallel, written in input order
+  std::stringstream in;
+  const int rows = 300000; // more than one block
+  for (int i = 0; i < rows; ++i) {
+    if (i == 5)
+      in << "bad\n";
+    else if (i == 6)
+      in << "\n";
+    else
+      in << "01/01/2000," << i << '\n';
+  }
+  in << "01/01/2000,02/01/2000"; // no final line break
+
+  std::ostringstream results;
+  DateBatch batch(3);
+  EXPECT_EQ(batch.run(in, results), 1u);
+  std::istringstream lines(results.str());
+  std::string line;
+  for (int i = 0; i < rows; ++i) {
+    ASSERT_TRUE(std::getline(lines, line));
+    if (i == 5)
+      EXPECT_EQ(line, "Error: Expected DATE,DATE or DATE,DAYS");
+    else if (i == 6)
+      EXPECT_EQ(line, "");
+    else
+      ASSERT_EQ(line, (CivilDate{2000, 1, 1}.addDays(i).toString())) << i;
+  }
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_EQ(line, "1");
+  EXPECT_FALSE(std::getline(lines, line));
+}
+
 // ==================== History Tests ====================
 
 TEST(HistoryTest, AddAndDisplay) {
@@ -146,6 +799,217 @@ TEST(HistoryTest, Clear) {
   EXPECT_FALSE(hist.undo()); // Should be empty
 }
 
+TEST(HistoryTest, TextFormatKeepsPipeInExpression) {
+  History hist1;
+  hist1.addEntry("3 | 5", 7.0);
+
+  const std::string filename = "test_history_pipe.txt";
+  hist1.save(filename);
+  History hist2;
+  hist2.load(filename);
+
+  ASSERT_EQ(hist2.size(), 1u);
+  EXPECT_EQ(hist2.operationAt(0), "3 | 5");
+  EXPECT_DOUBLE_EQ(hist2.resultAt(0), 7.0);
+  std::remove(filename.c_str());
+}
+
+TEST(HistoryTest, BinaryV2MappedLoad) {
+  const std::string filename = "test_history.bin";
+  History hist1;
+  hist1.addEntry("2 + 2", 4.0);
+  hist1.addEntry("3 | 5", 7.0);
+  hist1.addEntry("sqrt(16)", 4.0);
+  hist1.saveBinary(filename);
+
+  History hist2;
+  hist2.loadBinary(filename);
+  ASSERT_EQ(hist2.size(), 3u);
+  EXPECT_EQ(hist2.operationAt(1), "3 | 5");
+  EXPECT_DOUBLE_EQ(hist2.resultAt(2), 4.0);
+  EXPECT_EQ(hist2.currentIndex(), 2);
+
+  // Undo into the mapped entries, then add: the redo branch is dropped and
+  // the new entry follows the mapped ones
+  EXPECT_TRUE(hist2.undo());
+  hist2.addEntry("1 + 1", 2.0);
+  ASSERT_EQ(hist2.size(), 3u);
+  EXPECT_EQ(hist2.operationAt(2), "1 + 1");
+
+  // Saving over the file the history is mapped from
+  hist2.saveBinary(filename);
+  EXPECT_EQ(hist2.operationAt(0), "2 + 2");
+  History hist3;
+  hist3.loadBinary(filename);
+  ASSERT_EQ(hist3.size(), 3u);
+  EXPECT_EQ(hist3.operationAt(2), "1 + 1");
+
+  // Hostile headers and offsets are rejected instead of read out of bounds
+  auto writeV2 = [&](uint64_t count, uint64_t stringBytes,
+                     const std::vector<uint64_t> &words) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    const uint32_t version = 2;
+    const int64_t current = -1;
+    file.write("HIST", 4);
+    file.write(reinterpret_cast<const char *>(&version), 4);
+    file.write(reinterpret_cast<const char *>(&count), 8);
+    file.write(reinterpret_cast<const char *>(&current), 8);
+    file.write(reinterpret_cast<const char *>(&stringBytes), 8);
+    file.write(reinterpret_cast<const char *>(words.data()),
+               words.size() * 8);
+  };
+  // Size that only matches once count * 16 + 8 + stringBytes wraps
+  writeV2(1, ~uint64_t(0) - 7, {0, 0});
+  History wrapped;
+  wrapped.loadBinary(filename);
+  EXPECT_EQ(wrapped.size(), 0u);
+  // Results {0, 0}, offsets {0, 100000000, 16}, 16 bytes of strings
+  writeV2(2, 16, {0, 0, 0, 100000000, 16, 0, 0});
+  History unordered;
+  unordered.loadBinary(filename);
+  EXPECT_EQ(unordered.size(), 0u);
+  // Same with ordered offsets that stop short of the string section
+  writeV2(2, 16, {0, 0, 0, 4, 8, 0, 0});
+  History shortOffsets;
+  shortOffsets.loadBinary(filename);
+  EXPECT_EQ(shortOffsets.size(), 0u);
+  writeV2(2, 16, {0, 0, 0, 4, 16, 0, 0});
+  History valid;
+  valid.loadBinary(filename);
+  EXPECT_EQ(valid.size(), 2u);
+
+  std::remove(filename.c_str());
+}
+
+TEST(HistoryTest, JournalRecovery) {
+  const std::string filename = "test_history.journal";
+  std::remove(filename.c_str());
+  {
+    History hist;
+    ASSERT_TRUE(hist.openJournal(filename));
+    hist.addEntry("2 + 2", 4.0);
+    hist.addEntry("3 | 5", 7.0);
+    hist.addEntry("sqrt(16)", 4.0);
+    hist.undo();
+  }
+
+  History recovered;
+  ASSERT_TRUE(recovered.openJournal(filename));
+  ASSERT_EQ(recovered.size(), 3u);
+  EXPECT_EQ(recovered.operationAt(1), "3 | 5");
+  EXPECT_EQ(recovered.currentIndex(), 1);
+  recovered.closeJournal();
+
+  // A record torn by a crash mid-write is cut off; the rest survives
+  {
+    std::ofstream file(filename, std::ios::binary | std::ios::app);
+    file.write("\x12\x34\x56\x78\x20\0\0\0\x01partial", 16);
+  }
+  History afterCrash;
+  ASSERT_TRUE(afterCrash.openJournal(filename));
+  EXPECT_EQ(afterCrash.size(), 3u);
+  afterCrash.addEntry("1 + 1", 2.0);
+  afterCrash.closeJournal();
+
+  History reopened;
+  ASSERT_TRUE(reopened.openJournal(filename));
+  ASSERT_EQ(reopened.size(), 3u); // "sqrt(16)" was undone, then replaced
+  EXPECT_EQ(reopened.operationAt(2), "1 + 1");
+  reopened.closeJournal();
+
+  // Entries of the session survive opening a journal: they follow the
+  // recovered ones, or seed a new journal
+  const std::string seeded = "test_history_seeded.journal";
+  std::remove(seeded.c_str());
+  {
+    History session;
+    session.addEntry("6 * 7", 42.0);
+    ASSERT_TRUE(session.openJournal(filename));
+    ASSERT_EQ(session.size(), 4u);
+    EXPECT_EQ(session.operationAt(3), "6 * 7");
+    EXPECT_EQ(session.currentIndex(), 3);
+    ASSERT_TRUE(session.openJournal(seeded));
+    EXPECT_EQ(session.size(), 4u);
+  }
+  History fromSeeded;
+  ASSERT_TRUE(fromSeeded.openJournal(seeded));
+  ASSERT_EQ(fromSeeded.size(), 4u);
+  EXPECT_EQ(fromSeeded.operationAt(0), "2 + 2");
+  EXPECT_EQ(fromSeeded.operationAt(3), "6 * 7");
+
+  // The last add is committed within the interval without another append
+  // or a close
+  fromSeeded.addEntry("8 - 1", 7.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  const std::string copy = "test_history_copy.journal";
+  std::filesystem::copy_file(seeded, copy,
+                             std::filesystem::copy_options::overwrite_existing);
+  History fromCopy;
+  ASSERT_TRUE(fromCopy.openJournal(copy));
+  ASSERT_EQ(fromCopy.size(), 5u);
+  EXPECT_EQ(fromCopy.operationAt(4), "8 - 1");
+  fromCopy.closeJournal();
+  fromSeeded.closeJournal();
+
+  std::remove(filename.c_str());
+  std::remove(seeded.c_str());
+  std::remove(copy.c_str());
+}
+
+TEST(HistoryTest, IndexedSearch) {
+  History hist;
+  auto expected = [&hist](auto matches) {
+    std::vector<size_t> entries;
+    for (size_t i = 0; i < hist.size(); ++i) {
+      if (matches(hist.operationAt(i), hist.resultAt(i)))
+        entries.push_back(i);
+    }
+    return entries;
+  };
+  auto check = [&]() {
+    EXPECT_EQ(hist.findPrefix("sqrt("), expected([](auto op, double) {
+                return op.substr(0, 5) == "sqrt(";
+              }));
+    EXPECT_EQ(hist.findSubstring("7 *"), expected([](auto op, double) {
+                return op.find("7 *") != std::string_view::npos;
+              }));
+    EXPECT_EQ(hist.findSubstring("9"), expected([](auto op, double) {
+                return op.find('9') != std::string_view::npos;
+              }));
+    EXPECT_EQ(hist.findResultRange(10, 20),
+              expected([](auto, double r) { return r >= 10 && r <= 20; }));
+  };
+
+  // Enough entries to merge the unsorted tail into the sorted index
+  // several times
+  for (int i = 0; i < 3000; ++i) {
+    if (i % 3 == 0)
+      hist.addEntry("sqrt(" + std::to_string(i) + ")", std::sqrt(i));
+    else
+      hist.addEntry(std::to_string(i % 97) + " * 2", (i % 97) * 2.0);
+    if (i == 1000)
+      check();
+  }
+  hist.addEntry("0 / 0", std::nan(""));
+  check();
+  EXPECT_EQ(hist.findSubstring("no such text").size(), 0u);
+  EXPECT_EQ(hist.findResultRange(5, 1).size(), 0u);
+
+  // Adding after an undo drops the redo branch from the index too
+  std::ostringstream quiet;
+  auto *output = std::cout.rdbuf(quiet.rdbuf());
+  for (int i = 0; i < 1500; ++i)
+    hist.undo();
+  std::cout.rdbuf(output);
+  hist.addEntry("sqrt(400)", 20.0);
+  ASSERT_EQ(hist.size(), 1502u);
+  check();
+  EXPECT_EQ(hist.findPrefix("sqrt(400)"), std::vector<size_t>{1501});
+
+  hist.clear();
+  EXPECT_TRUE(hist.findPrefix("").empty());
+}
+
 // ==================== Sorter Tests ====================
 
 TEST(SorterTest, BubbleSort) {
@@ -185,6 +1049,107 @@ TEST(SorterTest, SaveAndLoad) {
   std::remove(filename.c_str());
 }
 
+TEST(SorterTest, LoadParsesLikeStreamExtraction) {
+  const std::string filename = "test_array_parse.txt";
+  {
+    std::ofstream file(filename);
+    file << "  -2147483648\t+7\n\n0012345678901 2147483647\r\n";
+  }
+  // 12345678901 overflows int, so reading stops there
+  EXPECT_EQ(Sorter::loadFromFile(filename),
+            (std::vector<int>{-2147483647 - 1, 7}));
+
+  {
+    std::ofstream file(filename);
+    file << "-5 123456789 42x 9";
+  }
+  EXPECT_EQ(Sorter::loadFromFile(filename),
+            (std::vector<int>{-5, 123456789, 42}));
+
+  // A sign right after a number starts the next one
+  {
+    std::ofstream file(filename);
+    file << "1-2 3+4 0007-2147483648";
+  }
+  EXPECT_EQ(Sorter::loadFromFile(filename),
+            (std::vector<int>{1, -2, 3, 4, 7, -2147483647 - 1}));
+  {
+    std::ofstream file(filename);
+    file << "5--6 7";
+  }
+  EXPECT_EQ(Sorter::loadFromFile(filename), (std::vector<int>{5}));
+
+  // Large enough to be split across threads
+  std::vector<int> data(300000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<int>(i * 2654435761u);
+  Sorter::saveToFile(filename, data);
+  EXPECT_EQ(Sorter::loadFromFile(filename, 4), data);
+
+  std::remove(filename.c_str());
+}
+
+TEST(SorterTest, ExternalSort) {
+  const std::string input = "test_external_in.txt";
+  const std::string output = "test_external_out.txt";
+
+  // 1 MB budget: 131072-element runs, so 700000 values spill 6 runs
+  std::vector<int> data(700000);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<int>(i * 2654435761u) >> (i % 7 ? 0 : 20);
+  Sorter::saveToFile(input, data);
+
+  ASSERT_TRUE(Sorter::externalSort(input, output, 1 << 20, 2));
+  std::sort(data.begin(), data.end());
+  EXPECT_EQ(Sorter::loadFromFile(output), data);
+  EXPECT_FALSE(std::ifstream(output + ".run0").good());
+
+  {
+    std::ofstream file(input);
+    file << "3+4 1-2 x 5";
+  }
+  ASSERT_TRUE(Sorter::externalSort(input, output, 1 << 20));
+  EXPECT_EQ(Sorter::loadFromFile(output), (std::vector<int>{-2, 1, 3, 4}));
+
+  EXPECT_FALSE(Sorter::externalSort("missing_file.txt", output, 1 << 20));
+
+  std::remove(input.c_str());
+  std::remove(output.c_str());
+}
+
+TEST(SorterTest, BinaryFormat) {
+  const std::string filename = "test_array.bin";
+  std::vector<int> data = {7, -3, 2147483647, 0, -2147483647 - 1};
+
+  Sorter::saveToFile(filename, data);
+  {
+    auto view = Sorter::mapBinary(filename);
+    ASSERT_TRUE(view.isOpen());
+    EXPECT_FALSE(view.sorted);
+    EXPECT_EQ(std::vector<int>(view.data, view.data + view.size), data);
+  }
+  EXPECT_EQ(Sorter::loadFromFile(filename), data);
+
+  // Sorting through external sort sets the sorted flag in the output
+  const std::string sortedFile = "test_array_sorted.bin";
+  ASSERT_TRUE(Sorter::externalSort(filename, sortedFile, 1 << 20));
+  std::sort(data.begin(), data.end());
+  auto view = Sorter::mapBinary(sortedFile);
+  EXPECT_TRUE(view.sorted);
+  EXPECT_EQ(Sorter::loadFromFile(sortedFile), data);
+
+  // Truncated payload is rejected rather than read past the end
+  {
+    std::ofstream file(filename, std::ios::binary);
+    file.write("IARR\1\0\4\0\x09\0\0\0\0\0\0\0", 16);
+  }
+  EXPECT_FALSE(Sorter::mapBinary(filename).isOpen());
+  EXPECT_TRUE(Sorter::loadFromFile(filename).empty());
+
+  std::remove(filename.c_str());
+  std::remove(sortedFile.c_str());
+}
+
 TEST(SorterTest, EmptyArray) {
   std::vector<int> arr;
   EXPECT_NO_THROW(Sorter::bubbleSort(arr));
@@ -206,6 +1171,334 @@ TEST(SorterTest, AlreadySorted) {
   EXPECT_EQ(arr, expected);
 }
 
+TEST(SorterTest, ParallelSort) {
+  // Large enough to take the multithreaded path, with duplicates, a
+  // sorted prefix and a reversed tail
+  std::vector<int> arr(200000);
+  for (size_t i = 0; i < arr.size(); ++i)
+    arr[i] = static_cast<int>((i * 2654435761u) % 1000) - 500;
+  for (size_t i = 0; i < 50000; ++i)
+    arr[i] = static_cast<int>(i);
+  for (size_t i = 150000; i < arr.size(); ++i)
+    arr[i] = static_cast<int>(arr.size() - i);
+
+  std::vector<int> expected = arr;
+  std::sort(expected.begin(), expected.end());
+
+  Sorter::parallelSort(arr, 3);
+  EXPECT_EQ(arr, expected);
+
+  std::vector<int> small = {3, -1, 2, 2, 0};
+  Sorter::parallelSort(small);
+  EXPECT_EQ(small, (std::vector<int>{-1, 0, 2, 2, 3}));
+}
+
+TEST(SorterTest, RadixSort) {
+  // Negative values and the int extremes must order by value, not by bits
+  std::vector<int> small = {5, -3, 2147483647, 0, -2147483647 - 1, -1, 7};
+  std::vector<int> arr(100000);
+  for (size_t i = 0; i < arr.size(); ++i)
+    arr[i] = static_cast<int>(i * 2654435761u);
+  arr.insert(arr.end(), small.begin(), small.end());
+
+  for (auto *data : {&small, &arr}) {
+    std::vector<int> expected = *data;
+    std::sort(expected.begin(), expected.end());
+    Sorter::radixSort(*data, 4);
+    EXPECT_EQ(*data, expected);
+  }
+}
+
+// ==================== LinkedList Tests ====================
+
+TEST(LinkedListTest, PoolAllocatorRecyclesNodes) {
+  PoolAllocator<long> pool;
+  long *a = pool.allocate(1);
+  long *b = pool.allocate(1);
+  EXPECT_EQ(b, a + 1);
+  pool.deallocate(a, 1);
+  EXPECT_EQ(pool.allocate(1), a);
+  EXPECT_EQ(pool.capacity(), PoolAllocator<long>::kFirstChunkSlots);
+
+  // Rebound copies share the pool and round-trip to an equal allocator
+  PoolAllocator<std::string> rebound(pool);
+  EXPECT_TRUE(rebound == pool);
+  EXPECT_TRUE(PoolAllocator<long>(rebound) == pool);
+  EXPECT_TRUE(PoolAllocator<long>() != pool);
+
+  // Lists built from one allocator draw nodes from the same free list
+  LinkedList<std::string> first(rebound), second(rebound);
+  first.pushBack("x");
+  const std::string *slot = &first.at(0);
+  first.clear();
+  second.pushBack("y");
+  EXPECT_EQ(&second.at(0), slot);
+  first = std::move(second);
+  EXPECT_EQ(&first.at(0), slot);
+
+  LinkedList<std::string> list;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1000; ++i)
+      list.pushBack(std::to_string(i));
+    list.insert(500, "middle");
+    list.remove(0);
+    EXPECT_EQ(list.size(), 1000u);
+    EXPECT_EQ(list.at(499), "middle");
+    list.clear();
+  }
+
+  // Copies and moves keep the elements in order
+  LinkedList<std::string> copy;
+  copy.pushBack("a");
+  copy.pushFront("b");
+  LinkedList<std::string> moved(std::move(copy));
+  EXPECT_TRUE(copy.empty());
+  LinkedList<std::string> assigned;
+  assigned = moved;
+  assigned.pushBack("c");
+  moved = std::move(assigned);
+  std::string joined;
+  for (const std::string &s : moved)
+    joined += s;
+  EXPECT_EQ(joined, "bac");
+}
+
+TEST(LinkedListTest, EmplaceMoveOnly) {
+  LinkedList<std::unique_ptr<int>, std::allocator<int>> owners;
+  owners.emplaceBack(new int(2));
+  owners.emplaceFront(std::make_unique<int>(1));
+  owners.pushBack(std::make_unique<int>(4));
+  owners.emplace(2, new int(3));
+  LinkedList<std::unique_ptr<int>, std::allocator<int>> other;
+  other = std::move(owners);
+  EXPECT_TRUE(owners.empty());
+  int expected = 1;
+  for (auto &owner : other)
+    EXPECT_EQ(*owner, expected++);
+  EXPECT_THROW(other.emplace(9, nullptr), std::out_of_range);
+}
+
+TEST(LinkedListTest, UnrolledListMatchesVector) {
+  // Random edits checked against std::vector, over many block splits
+  // and merges
+  std::mt19937 rng(7);
+  UnrolledList<int> unrolled;
+  LinkedList<int> linked;
+  std::vector<int> expected;
+  for (int step = 0; step < 20000; ++step) {
+    int value = static_cast<int>(rng() % 1000);
+    switch (rng() % 4) {
+    case 0:
+    case 1: {
+      size_t index = rng() % (expected.size() + 1);
+      unrolled.insert(index, value);
+      linked.insert(index, value);
+      expected.insert(expected.begin() + index, value);
+      break;
+    }
+    case 2:
+      unrolled.pushBack(value);
+      linked.pushBack(value);
+      expected.push_back(value);
+      break;
+    default:
+      if (!expected.empty()) {
+        size_t index = rng() % expected.size();
+        unrolled.remove(index);
+        linked.remove(index);
+        expected.erase(expected.begin() + index);
+      }
+    }
+  }
+
+  ASSERT_EQ(unrolled.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i += 37) {
+    EXPECT_EQ(unrolled.at(i), expected[i]);
+    EXPECT_EQ(linked.at(i), expected[i]);
+  }
+  std::vector<int> iterated;
+  for (int value : unrolled)
+    iterated.push_back(value);
+  EXPECT_EQ(iterated, expected);
+
+  while (!unrolled.empty())
+    unrolled.remove(unrolled.size() / 2);
+  EXPECT_TRUE(unrolled.begin() == unrolled.end());
+  EXPECT_THROW(unrolled.at(0), std::out_of_range);
+  unrolled.emplaceFront(1);
+  EXPECT_EQ(unrolled.at(0), 1);
+
+  // Inserting an element of a full block into that block, which splits it
+  UnrolledList<std::string> strings;
+  const size_t capacity = UnrolledList<std::string>::kBlockCapacity;
+  for (size_t i = 0; i < capacity; ++i)
+    strings.pushBack(std::string(40, static_cast<char>('a' + i % 26)));
+  std::string last = strings.at(capacity - 1);
+  strings.insert(0, strings.at(capacity - 1));
+  EXPECT_EQ(strings.at(0), last);
+  EXPECT_EQ(strings.at(capacity), last);
+}
+
+// ==================== StringInterner Tests ====================
+
+TEST(StringInternerTest, DeduplicatesIntoArena) {
+  StringInterner strings;
+  auto a = strings.intern("sin(x) + 1");
+  auto b = strings.intern("2 + 2");
+  EXPECT_EQ(strings.intern("sin(x) + 1"), a);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(strings.intern(""), strings.intern(std::string()));
+
+  // Enough distinct strings to force several table resizes
+  for (int i = 0; i < 10000; ++i)
+    strings.intern("x * " + std::to_string(i));
+  EXPECT_EQ(strings.size(), 10003u);
+  EXPECT_EQ(strings.get(a), "sin(x) + 1");
+  EXPECT_EQ(strings.get(strings.intern("x * 1234")), "x * 1234");
+  EXPECT_EQ(strings.size(), 10003u);
+}
+
+// ==================== ThreadPool Tests ====================
+
+TEST(ThreadPoolTest, ParallelForCoversRangeInOrder) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4u);
+
+  std::vector<int> hits(1000, 0);
+  std::vector<size_t> firstOfWorker(pool.size(), 0);
+  pool.parallelFor(hits.size(), [&](size_t begin, size_t end, size_t worker) {
+    firstOfWorker[worker] = begin;
+    for (size_t i = begin; i < end; ++i)
+      ++hits[i];
+  });
+
+  for (int h : hits)
+    EXPECT_EQ(h, 1);
+  for (size_t w = 1; w < pool.size(); ++w)
+    EXPECT_LT(firstOfWorker[w - 1], firstOfWorker[w]);
+
+  // Exceptions from workers reach the caller and the pool stays usable
+  EXPECT_THROW(pool.parallelFor(100,
+                                [](size_t begin, size_t, size_t) {
+                                  if (begin > 0)
+                                    throw std::runtime_error("worker");
+                                }),
+               std::runtime_error);
+  std::atomic<size_t> total{0};
+  pool.parallelFor(100, [&](size_t begin, size_t end, size_t) {
+    total += end - begin;
+  });
+  EXPECT_EQ(total.load(), 100u);
+}
+
+// ==================== BatchMode Tests ====================
+
+TEST(BatchModeTest, ResultsInInputOrder) {
+  std::stringstream in;
+  const int lines = 40000; // more than one chunk
+  for (int i = 0; i < lines; ++i) {
+    if (i == 7)
+      in << "1 / 0\n";
+    else if (i == 8)
+      in << "\n";
+    else
+      in << i << " * 2\n";
+  }
+
+  std::ostringstream out;
+  BatchMode batch(3);
+  EXPECT_EQ(batch.run(in, out), 1u);
+
+  std::istringstream results(out.str());
+  std::string line;
+  for (int i = 0; i < lines; ++i) {
+    ASSERT_TRUE(std::getline(results, line));
+    if (i == 7)
+      EXPECT_EQ(line, "Error: Division by zero");
+    else if (i == 8)
+      EXPECT_EQ(line, "");
+    else
+      EXPECT_EQ(line, std::to_string(i * 2));
+  }
+  EXPECT_FALSE(std::getline(results, line));
+}
+
+// ==================== ResultCache Tests ====================
+
+TEST(ResultCacheTest, EvictionPolicies) {
+  // One shard so the eviction order is fully determined
+  ResultCache lru(2, ResultCache::Policy::LRU, 1);
+  lru.insert("a", 1);
+  lru.insert("b", 2);
+  EXPECT_EQ(lru.lookup("a"), 1.0); // b is now least recently used
+  lru.insert("c", 3);
+  EXPECT_FALSE(lru.lookup("b"));
+  EXPECT_EQ(lru.lookup("a"), 1.0);
+  EXPECT_EQ(lru.lookup("c"), 3.0);
+
+  ResultCache clock(3, ResultCache::Policy::Clock, 1);
+  clock.insert("a", 1);
+  clock.insert("b", 2);
+  clock.insert("c", 3);
+  EXPECT_TRUE(clock.lookup("a")); // a gets a second chance
+  clock.insert("d", 4);
+  EXPECT_TRUE(clock.lookup("a"));
+  EXPECT_FALSE(clock.lookup("b"));
+  EXPECT_EQ(clock.lookup("d"), 4.0);
+
+  auto stats = clock.stats();
+  EXPECT_EQ(stats.hits, 3u);
+  EXPECT_EQ(stats.misses, 1u);
+  EXPECT_EQ(stats.evictions, 1u);
+  EXPECT_EQ(stats.size, 3u);
+
+  ResultCache disabled(0);
+  disabled.insert("a", 1);
+  EXPECT_FALSE(disabled.lookup("a"));
+
+  // Small caches are not split into shards too small to fill up
+  for (size_t capacity : {1, 10, 100}) {
+    ResultCache small(capacity);
+    for (size_t i = 0; i < capacity; ++i)
+      small.insert("key" + std::to_string(i), static_cast<double>(i));
+    EXPECT_EQ(small.stats().evictions, 0u) << capacity;
+    EXPECT_EQ(small.stats().size, capacity);
+    EXPECT_EQ(small.lookup("key0"), 0.0);
+  }
+}
+
+TEST(ResultCacheTest, SharedByEvaluators) {
+  ResultCache cache(1024, ResultCache::Policy::Clock);
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("2 + 3 * 4", cache), 14);
+  EXPECT_DOUBLE_EQ(ExpressionEvaluator::evaluate("2+3*4", cache), 14);
+  EXPECT_EQ(cache.stats().hits, 1u);
+  EXPECT_THROW(ExpressionEvaluator::evaluate("1 / 0", cache),
+               std::runtime_error);
+  EXPECT_THROW(ExpressionEvaluator::evaluate("1 / 0", cache),
+               std::runtime_error);
+
+  // Compiled expressions key on the code and the variable values
+  auto f = ExpressionEvaluator::compile("x * x + 1");
+  auto g = ExpressionEvaluator::compile("y*y + 1");
+  double three = 3, four = 4;
+  EXPECT_DOUBLE_EQ(f.evaluate(&three, cache), 10);
+  EXPECT_DOUBLE_EQ(g.evaluate(&three, cache), 10);
+  EXPECT_DOUBLE_EQ(g.evaluate(&four, cache), 17);
+  EXPECT_EQ(cache.stats().hits, 2u);
+
+  // Concurrent batch evaluation through one cache matches the uncached run
+  std::stringstream in, again;
+  for (int i = 0; i < 20000; ++i) {
+    in << "sqrt(" << i % 100 << ") * 2\n";
+    again << "sqrt(" << i % 100 << ") * 2\n";
+  }
+  std::ostringstream cached, plain;
+  BatchMode(4, &cache).run(in, cached);
+  BatchMode(4).run(again, plain);
+  EXPECT_EQ(cached.str(), plain.str());
+  EXPECT_GE(cache.stats().hits, 20000u - 100u);
+}
+
 // ==================== Integration Tests ====================
 
 TEST(IntegrationTest, MathUtilsWithExpressionEvaluator) {
@@ -22,6 +22,61 @@ bool ArgumentParser::parse(int argc, char *argv[]) {
         std::cerr << "Valid levels: DEBUG, INFO, WARNING, ERROR" << std::endl;
         return false;
       }
+    } else if (arg == "--journal" && i + 1 < argc) {
+      options_["journal"] = argv[++i];
+    } else if (arg == "--batch" && i + 1 < argc) {
+      options_["batch"] = argv[++i];
+    } else if (arg == "--dates" && i + 1 < argc) {
+      options_["dates"] = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      std::string threads = argv[++i];
+      // Validate thread count
+      if (threads.empty() ||
+          threads.find_first_not_of("0123456789") != std::string::npos ||
+          threads.size() > 4 || std::stoi(threads) == 0) {
+        std::cerr << "Error: Invalid thread count '" << threads << "'"
+                  << std::endl;
+        std::cerr << "Thread count must be a positive integer" << std::endl;
+        return false;
+      }
+      options_["threads"] = threads;
+    } else if (arg == "--cache" && i + 1 < argc) {
+      std::string size = argv[++i];
+      // Validate cache size
+      if (size.empty() ||
+          size.find_first_not_of("0123456789") != std::string::npos ||
+          size.size() > 9) {
+        std::cerr << "Error: Invalid cache size '" << size << "'"
+                  << std::endl;
+        std::cerr << "Cache size must be a non-negative integer" << std::endl;
+        return false;
+      }
+      options_["cache"] = size;
+    } else if (arg == "--cache-policy" && i + 1 < argc) {
+      std::string policy = argv[++i];
+      // Validate cache policy
+      if (policy == "lru" || policy == "clock") {
+        options_["cache-policy"] = policy;
+      } else {
+        std::cerr << "Error: Invalid cache policy '" << policy << "'"
+                  << std::endl;
+        std::cerr << "Valid policies: lru, clock" << std::endl;
+        return false;
+      }
+    } else if (arg == "--precision" && i + 1 < argc) {
+      std::string digits = argv[++i];
+      // Validate digit count
+      if (digits.empty() ||
+          digits.find_first_not_of("0123456789") != std::string::npos ||
+          digits.size() > 7 || std::stoul(digits) == 0 ||
+          std::stoul(digits) > 1000000) {
+        std::cerr << "Error: Invalid precision '" << digits << "'"
+                  << std::endl;
+        std::cerr << "Precision must be between 1 and 1000000 digits"
+                  << std::endl;
+        return false;
+      }
+      options_["precision"] = digits;
     } else if (arg == "--log-file" && i + 1 < argc) {
       options_["log-file"] = argv[++i];
     } else if (arg == "--mode" && i + 1 < argc) {
@@ -60,6 +115,38 @@ std::string ArgumentParser::getHistoryFile() const {
   return getOption("load-history");
 }
 
+bool ArgumentParser::shouldUseJournal() const {
+  return hasOption("journal");
+}
+
+std::string ArgumentParser::getJournalFile() const {
+  return getOption("journal");
+}
+
+bool ArgumentParser::shouldRunBatch() const { return hasOption("batch"); }
+
+std::string ArgumentParser::getBatchFile() const { return getOption("batch"); }
+
+bool ArgumentParser::shouldRunDates() const { return hasOption("dates"); }
+
+std::string ArgumentParser::getDatesFile() const { return getOption("dates"); }
+
+size_t ArgumentParser::getThreadCount() const {
+  return std::stoul(getOption("threads", "0"));
+}
+
+size_t ArgumentParser::getCacheSize() const {
+  return std::stoul(getOption("cache", "0"));
+}
+
+std::string ArgumentParser::getCachePolicy() const {
+  return getOption("cache-policy", "lru");
+}
+
+size_t ArgumentParser::getPrecision() const {
+  return std::stoul(getOption("precision", "0"));
+}
+
 std::string ArgumentParser::getLogLevel() const {
   return getOption("log-level", "INFO");
 }
@@ -76,8 +163,32 @@ void ArgumentParser::showHelp() {
   std::cout << "  --help, -h                Show this help message\n";
   std::cout << "  --calc EXPRESSION         Calculate expression directly\n";
   std::cout << "                            Example: --calc \"2 + 2 * 3\"\n";
+  std::cout << "  --precision N             Evaluate --calc to N significant "
+               "digits;\n";
+  std::cout << "                            interactive: default digits of "
+               "Precision Mode\n";
+  std::cout << "  --batch FILE              Evaluate one expression per line of "
+               "FILE\n";
+  std::cout << "                            (- reads stdin), results in input "
+               "order\n";
+  std::cout << "  --dates FILE              Date arithmetic on CSV rows of FILE "
+               "(- reads stdin):\n";
+  std::cout << "                            DATE,DATE gives days between, "
+               "DATE,N shifts\n";
+  std::cout << "  --threads N               Worker threads for --batch and "
+               "--dates\n";
+  std::cout << "                            Default: all hardware threads\n";
+  std::cout << "  --cache N                 Reuse results of up to N distinct "
+               "expressions\n";
+  std::cout << "                            in --batch (statistics on "
+               "stderr)\n";
+  std::cout << "  --cache-policy POLICY     Cache eviction policy (lru|clock)\n";
+  std::cout << "                            Default: lru\n";
   std::cout
       << "  --load-history FILE       Load calculation history from file\n";
+  std::cout << "  --journal FILE            Recover history from an append-only "
+               "journal\n";
+  std::cout << "                            and save every change to it\n";
   std::cout << "  --log-level LEVEL         Set logging level "
                "(DEBUG|INFO|WARNING|ERROR)\n";
   std::cout << "                            Default: INFO\n";
@@ -89,7 +200,12 @@ void ArgumentParser::showHelp() {
 
   std::cout << "EXAMPLES:\n";
   std::cout << "  calculator_cli --calc \"sqrt(16)\"\n";
+  std::cout << "  calculator_cli --calc \"2^0.5\" --precision 1000\n";
+  std::cout << "  calculator_cli --batch formulas.txt --threads 8\n";
+  std::cout << "  calculator_cli --batch formulas.txt --cache 100000\n";
+  std::cout << "  calculator_cli --dates pairs.csv > days.txt\n";
   std::cout << "  calculator_cli --load-history myhistory.txt\n";
+  std::cout << "  calculator_cli --journal session.journal\n";
   std::cout << "  calculator_cli --log-level DEBUG --log-file debug.log\n";
   std::cout << "  calculator_cli --mode scientific\n\n";
 }
@@ -51,6 +51,66 @@ public:
    */
   std::string getHistoryFile() const;
 
+  /**
+   * @brief Check if a history journal should be used
+   * @return true if --journal option present
+   */
+  bool shouldUseJournal() const;
+
+  /**
+   * @brief Get history journal path
+   * @return File path from --journal option
+   */
+  std::string getJournalFile() const;
+
+  /**
+   * @brief Check if batch evaluation mode requested
+   * @return true if --batch option present
+   */
+  bool shouldRunBatch() const;
+
+  /**
+   * @brief Get batch input file
+   * @return File path from --batch option ("-" means stdin)
+   */
+  std::string getBatchFile() const;
+
+  /**
+   * @brief Check if batch date computation requested
+   * @return true if --dates option present
+   */
+  bool shouldRunDates() const;
+
+  /**
+   * @brief Get date rows file
+   * @return File path from --dates option ("-" means stdin)
+   */
+  std::string getDatesFile() const;
+
+  /**
+   * @brief Get worker thread count
+   * @return Value of --threads, or 0 for all hardware threads
+   */
+  size_t getThreadCount() const;
+
+  /**
+   * @brief Get result cache capacity
+   * @return Value of --cache, or 0 if caching is off
+   */
+  size_t getCacheSize() const;
+
+  /**
+   * @brief Get result cache eviction policy
+   * @return Value of --cache-policy (lru|clock), default "lru"
+   */
+  std::string getCachePolicy() const;
+
+  /**
+   * @brief Get arbitrary-precision digit count
+   * @return Value of --precision, or 0 if not set
+   */
+  size_t getPrecision() const;
+
   /**
    * @brief Get logging level
    * @return Log level (DEBUG, INFO, WARNING, ERROR) or empty if not set
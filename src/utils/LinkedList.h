@@ -1,17 +1,23 @@
 #ifndef LINKEDLIST_H
 #define LINKEDLIST_H
 
+#include "PoolAllocator.h"
 #include <cstddef>
+#include <memory>
 #include <stdexcept>
+#include <utility>
 
 /**
  * @brief Templated doubly-linked list data structure
  * @tparam T Type of elements stored in the list
+ * @tparam Alloc Allocator, rebound to the node type
  *
  * Custom implementation of a doubly-linked list with iterator support.
- * Demonstrates manual memory management and template programming.
+ * Nodes come from a PoolAllocator by default, so adding and removing
+ * elements recycles node slots instead of calling new and delete for
+ * each one, and nodes allocated together sit next to each other.
  */
-template <typename T> class LinkedList {
+template <typename T, typename Alloc = PoolAllocator<T>> class LinkedList {
 private:
   /**
    * @brief Node structure for doubly-linked list
@@ -21,12 +27,19 @@ private:
     Node *next;
     Node *prev;
 
-    Node(const T &value) : data(value), next(nullptr), prev(nullptr) {}
+    template <typename... Args>
+    explicit Node(std::in_place_t, Args &&...args)
+        : data(std::forward<Args>(args)...), next(nullptr), prev(nullptr) {}
   };
 
+  using NodeAlloc =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<Node>;
+  using NodeTraits = std::allocator_traits<NodeAlloc>;
+
   Node *head_;
   Node *tail_;
   size_t size_;
+  NodeAlloc alloc_;
 
 public:
   /**
@@ -34,6 +47,9 @@ public:
    */
   LinkedList() : head_(nullptr), tail_(nullptr), size_(0) {}
 
+  explicit LinkedList(const Alloc &alloc)
+      : head_(nullptr), tail_(nullptr), size_(0), alloc_(alloc) {}
+
   /**
    * @brief Destructor - frees all nodes
    */
@@ -43,7 +59,9 @@ public:
    * @brief Copy constructor
    */
   LinkedList(const LinkedList &other)
-      : head_(nullptr), tail_(nullptr), size_(0) {
+      : head_(nullptr), tail_(nullptr), size_(0),
+        alloc_(NodeTraits::select_on_container_copy_construction(
+            other.alloc_)) {
     Node *current = other.head_;
     while (current) {
       pushBack(current->data);
@@ -51,12 +69,22 @@ public:
     }
   }
 
+  /**
+   * @brief Move constructor - takes over the nodes and their allocator
+   */
+  LinkedList(LinkedList &&other) noexcept
+      : head_(std::exchange(other.head_, nullptr)),
+        tail_(std::exchange(other.tail_, nullptr)),
+        size_(std::exchange(other.size_, 0)), alloc_(other.alloc_) {}
+
   /**
    * @brief Copy assignment operator
    */
   LinkedList &operator=(const LinkedList &other) {
     if (this != &other) {
       clear();
+      if constexpr (NodeTraits::propagate_on_container_copy_assignment::value)
+        alloc_ = other.alloc_;
       Node *current = other.head_;
       while (current) {
         pushBack(current->data);
@@ -66,12 +94,53 @@ public:
     return *this;
   }
 
+  /**
+   * @brief Move assignment operator
+   *
+   * Takes over the nodes when the allocator moves along or the two
+   * allocators share memory; otherwise moves the elements one by one.
+   */
+  LinkedList &operator=(LinkedList &&other) noexcept(
+      NodeTraits::propagate_on_container_move_assignment::value ||
+      NodeTraits::is_always_equal::value) {
+    if (this == &other)
+      return *this;
+    clear();
+    if constexpr (NodeTraits::propagate_on_container_move_assignment::value)
+      alloc_ = other.alloc_;
+    if (alloc_ == other.alloc_) {
+      head_ = std::exchange(other.head_, nullptr);
+      tail_ = std::exchange(other.tail_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+    } else {
+      for (Node *current = other.head_; current; current = current->next)
+        emplaceBack(std::move(current->data));
+      other.clear();
+    }
+    return *this;
+  }
+
   /**
    * @brief Add element to the end
    * @param value Element to add
    */
-  void pushBack(const T &value) {
-    Node *newNode = new Node(value);
+  void pushBack(const T &value) { emplaceBack(value); }
+  void pushBack(T &&value) { emplaceBack(std::move(value)); }
+
+  /**
+   * @brief Add element to the front
+   * @param value Element to add
+   */
+  void pushFront(const T &value) { emplaceFront(value); }
+  void pushFront(T &&value) { emplaceFront(std::move(value)); }
+
+  /**
+   * @brief Construct element in place at the end
+   * @param args Constructor arguments of T
+   * @return Reference to the new element
+   */
+  template <typename... Args> T &emplaceBack(Args &&...args) {
+    Node *newNode = createNode(std::forward<Args>(args)...);
     if (!tail_) {
       head_ = tail_ = newNode;
     } else {
@@ -80,14 +149,16 @@ public:
       tail_ = newNode;
     }
     ++size_;
+    return newNode->data;
   }
 
   /**
-   * @brief Add element to the front
-   * @param value Element to add
+   * @brief Construct element in place at the front
+   * @param args Constructor arguments of T
+   * @return Reference to the new element
    */
-  void pushFront(const T &value) {
-    Node *newNode = new Node(value);
+  template <typename... Args> T &emplaceFront(Args &&...args) {
+    Node *newNode = createNode(std::forward<Args>(args)...);
     if (!head_) {
       head_ = tail_ = newNode;
     } else {
@@ -96,6 +167,7 @@ public:
       head_ = newNode;
     }
     ++size_;
+    return newNode->data;
   }
 
   /**
@@ -104,31 +176,34 @@ public:
    * @param value Element to insert
    * @throws std::out_of_range if index > size
    */
-  void insert(size_t index, const T &value) {
+  void insert(size_t index, const T &value) { emplace(index, value); }
+  void insert(size_t index, T &&value) { emplace(index, std::move(value)); }
+
+  /**
+   * @brief Construct element in place at specific index
+   * @throws std::out_of_range if index > size
+   */
+  template <typename... Args> T &emplace(size_t index, Args &&...args) {
     if (index > size_) {
       throw std::out_of_range("Index out of range");
     }
 
     if (index == 0) {
-      pushFront(value);
-      return;
+      return emplaceFront(std::forward<Args>(args)...);
     }
     if (index == size_) {
-      pushBack(value);
-      return;
+      return emplaceBack(std::forward<Args>(args)...);
     }
 
-    Node *current = head_;
-    for (size_t i = 0; i < index - 1; ++i) {
-      current = current->next;
-    }
+    Node *current = nodeAt(index - 1);
 
-    Node *newNode = new Node(value);
+    Node *newNode = createNode(std::forward<Args>(args)...);
     newNode->next = current->next;
     newNode->prev = current;
     current->next->prev = newNode;
     current->next = newNode;
     ++size_;
+    return newNode->data;
   }
 
   /**
@@ -141,10 +216,7 @@ public:
       throw std::out_of_range("Index out of range");
     }
 
-    Node *toDelete = head_;
-    for (size_t i = 0; i < index; ++i) {
-      toDelete = toDelete->next;
-    }
+    Node *toDelete = nodeAt(index);
 
     if (toDelete->prev) {
       toDelete->prev->next = toDelete->next;
@@ -158,7 +230,7 @@ public:
       tail_ = toDelete->prev;
     }
 
-    delete toDelete;
+    destroyNode(toDelete);
     --size_;
   }
 
@@ -173,11 +245,7 @@ public:
       throw std::out_of_range("Index out of range");
     }
 
-    Node *current = head_;
-    for (size_t i = 0; i < index; ++i) {
-      current = current->next;
-    }
-    return current->data;
+    return nodeAt(index)->data;
   }
 
   /**
@@ -188,11 +256,7 @@ public:
       throw std::out_of_range("Index out of range");
     }
 
-    Node *current = head_;
-    for (size_t i = 0; i < index; ++i) {
-      current = current->next;
-    }
-    return current->data;
+    return nodeAt(index)->data;
   }
 
   /**
@@ -213,7 +277,7 @@ public:
   void clear() {
     while (head_) {
       Node *next = head_->next;
-      delete head_;
+      destroyNode(head_);
       head_ = next;
     }
     tail_ = nullptr;
@@ -257,6 +321,39 @@ public:
    * @brief Get iterator to end
    */
   Iterator end() { return Iterator(nullptr); }
+
+private:
+  // Walks from whichever end is closer; index < size_
+  Node *nodeAt(size_t index) const {
+    Node *current;
+    if (index < size_ / 2) {
+      current = head_;
+      for (size_t i = 0; i < index; ++i)
+        current = current->next;
+    } else {
+      current = tail_;
+      for (size_t i = size_ - 1; i > index; --i)
+        current = current->prev;
+    }
+    return current;
+  }
+
+  template <typename... Args> Node *createNode(Args &&...args) {
+    Node *node = NodeTraits::allocate(alloc_, 1);
+    try {
+      NodeTraits::construct(alloc_, node, std::in_place,
+                            std::forward<Args>(args)...);
+    } catch (...) {
+      NodeTraits::deallocate(alloc_, node, 1);
+      throw;
+    }
+    return node;
+  }
+
+  void destroyNode(Node *node) {
+    NodeTraits::destroy(alloc_, node);
+    NodeTraits::deallocate(alloc_, node, 1);
+  }
 };
 
 #endif // LINKEDLIST_H
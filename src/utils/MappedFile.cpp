@@ -0,0 +1,112 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &filename, Access access) {
+  open(filename, access);
+}
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    data_ = other.data_;
+    size_ = other.size_;
+    open_ = other.open_;
+#ifdef _WIN32
+    buffer_ = std::move(other.buffer_);
+#endif
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.open_ = false;
+  }
+  return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &filename, Access /*access*/) {
+  close();
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  if (!file)
+    return false;
+
+  buffer_.resize(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  if (!file.read(buffer_.data(), buffer_.size())) {
+    buffer_.clear();
+    return false;
+  }
+
+  data_ = buffer_.empty() ? nullptr : buffer_.data();
+  size_ = buffer_.size();
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  buffer_.clear();
+  buffer_.shrink_to_fit();
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &filename, Access access) {
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void *mapping = nullptr;
+  if (size > 0) {
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    // Scans read ahead aggressively; lookups by index fault in single
+    // pages without evicting the ones around them
+    madvise(mapping, size,
+            access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+  }
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+
+  data_ = static_cast<const char *>(mapping);
+  size_ = size;
+  open_ = true;
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_)
+    munmap(const_cast<char *>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+
+#endif
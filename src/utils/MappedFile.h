@@ -0,0 +1,64 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Read-only view of a whole file
+ *
+ * On POSIX systems the file is memory-mapped, so opening it costs no reads
+ * or copies and pages are loaded on first access. Elsewhere the contents
+ * are read into an internal buffer once.
+ */
+class MappedFile {
+public:
+  // Read-ahead hint for the mapping
+  enum class Access { Sequential, Random };
+
+  MappedFile() = default;
+
+  /**
+   * @brief Open and map a file; check isOpen() for the result
+   */
+  explicit MappedFile(const std::string &filename,
+                      Access access = Access::Sequential);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  /**
+   * @brief Map a file, releasing any previous mapping
+   * @return false if the file cannot be opened or mapped
+   */
+  bool open(const std::string &filename, Access access = Access::Sequential);
+
+  /**
+   * @brief Release the mapping
+   */
+  void close();
+
+  bool isOpen() const { return open_; }
+
+  /**
+   * @brief File contents; nullptr for an empty file
+   */
+  const char *data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+#ifdef _WIN32
+  std::vector<char> buffer_;
+#endif
+};
+
+#endif // MAPPEDFILE_H
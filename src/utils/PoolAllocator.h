@@ -0,0 +1,189 @@
+#ifndef POOLALLOCATOR_H
+#define POOLALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Untyped chunk arena behind PoolAllocator
+ *
+ * Slots are grouped into size classes by size and alignment; each class
+ * has its own chunks and free list, so every allocator rebound from the
+ * same pool shares one arena whatever its value type. Chunks double in
+ * size up to kMaxChunkBytes and are released with the arena.
+ */
+class PoolArena {
+public:
+  static constexpr size_t kFirstChunkSlots = 16;
+  static constexpr size_t kMaxChunkBytes = 64 * 1024;
+
+  struct SizeClass {
+    struct FreeSlot {
+      FreeSlot *next;
+    };
+
+    size_t slotSize;
+    size_t alignment;
+    FreeSlot *free = nullptr;
+    char *next = nullptr; // Unused part of the newest chunk
+    char *end = nullptr;
+    size_t capacity = 0;
+    PoolArena *arena;
+  };
+
+  PoolArena() = default;
+  PoolArena(const PoolArena &) = delete;
+  PoolArena &operator=(const PoolArena &) = delete;
+
+  ~PoolArena() {
+    for (const Chunk &chunk : chunks_)
+      ::operator delete(chunk.memory, std::align_val_t(chunk.alignment));
+  }
+
+  /**
+   * @brief The size class for slots of `size` bytes aligned to `alignment`
+   *
+   * The returned pointer stays valid for the lifetime of the arena.
+   */
+  SizeClass *sizeClass(size_t size, size_t alignment) {
+    alignment = std::max(alignment, alignof(SizeClass::FreeSlot));
+    size = std::max(size, sizeof(SizeClass::FreeSlot));
+    size = (size + alignment - 1) / alignment * alignment;
+    for (const auto &existing : classes_) {
+      if (existing->slotSize == size && existing->alignment == alignment)
+        return existing.get();
+    }
+    classes_.push_back(std::make_unique<SizeClass>());
+    SizeClass *created = classes_.back().get();
+    created->slotSize = size;
+    created->alignment = alignment;
+    created->arena = this;
+    return created;
+  }
+
+  static void *allocate(SizeClass &cls) {
+    if (SizeClass::FreeSlot *slot = cls.free) {
+      cls.free = slot->next;
+      return slot;
+    }
+    if (cls.next == cls.end)
+      cls.arena->grow(cls);
+    void *slot = cls.next;
+    cls.next += cls.slotSize;
+    return slot;
+  }
+
+  static void deallocate(SizeClass &cls, void *p) noexcept {
+    auto *slot = static_cast<SizeClass::FreeSlot *>(p);
+    slot->next = cls.free;
+    cls.free = slot;
+  }
+
+private:
+  struct Chunk {
+    void *memory;
+    size_t alignment;
+  };
+
+  void grow(SizeClass &cls) {
+    const size_t maxSlots =
+        std::max<size_t>(kMaxChunkBytes / cls.slotSize, 1);
+    size_t slots = cls.capacity == 0 ? kFirstChunkSlots
+                                     : std::min(cls.capacity, maxSlots);
+    chunks_.reserve(chunks_.size() + 1);
+    void *memory = ::operator new(slots * cls.slotSize,
+                                  std::align_val_t(cls.alignment));
+    chunks_.push_back({memory, cls.alignment});
+    cls.next = static_cast<char *>(memory);
+    cls.end = cls.next + slots * cls.slotSize;
+    cls.capacity += slots;
+  }
+
+  std::vector<std::unique_ptr<SizeClass>> classes_;
+  std::vector<Chunk> chunks_;
+};
+
+/**
+ * @brief Allocator that carves single objects out of large chunks
+ * @tparam T Type of the objects allocated
+ *
+ * Meant for node-based containers, which allocate one object at a time:
+ * allocate(1) pops a recycled slot off a free list or takes the next slot
+ * of the current chunk, and deallocate(p, 1) pushes the slot back, so
+ * neither touches malloc once the pool has grown to the working size.
+ * Requests for more than one object go to std::allocator.
+ *
+ * Copies and rebound copies share the pool (a PoolArena) and compare
+ * equal, so PoolAllocator<U>(PoolAllocator<T>(a)) == a and containers
+ * built from the same allocator can exchange nodes. Containers copied
+ * with std::allocator_traits::select_on_container_copy_construction get
+ * a pool of their own. A pool is not thread-safe.
+ */
+template <typename T> class PoolAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  static constexpr size_t kFirstChunkSlots = PoolArena::kFirstChunkSlots;
+  static constexpr size_t kMaxChunkBytes = PoolArena::kMaxChunkBytes;
+
+  PoolAllocator() : PoolAllocator(std::make_shared<PoolArena>()) {}
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &other) : PoolAllocator(other.arena_) {}
+
+  PoolAllocator select_on_container_copy_construction() const {
+    return PoolAllocator();
+  }
+
+  T *allocate(size_t n) {
+    if (n != 1)
+      return std::allocator<T>().allocate(n);
+    return static_cast<T *>(PoolArena::allocate(*class_));
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (n != 1) {
+      std::allocator<T>().deallocate(p, n);
+      return;
+    }
+    PoolArena::deallocate(*class_, p);
+  }
+
+  /**
+   * @brief Slots of this type's size reserved so far, in use or free
+   */
+  size_t capacity() const { return class_->capacity; }
+
+private:
+  template <typename U> friend class PoolAllocator;
+  template <typename A, typename B>
+  friend bool operator==(const PoolAllocator<A> &a,
+                         const PoolAllocator<B> &b);
+
+  explicit PoolAllocator(std::shared_ptr<PoolArena> arena)
+      : arena_(std::move(arena)),
+        class_(arena_->sizeClass(sizeof(T), alignof(T))) {}
+
+  std::shared_ptr<PoolArena> arena_;
+  PoolArena::SizeClass *class_;
+};
+
+template <typename A, typename B>
+bool operator==(const PoolAllocator<A> &a, const PoolAllocator<B> &b) {
+  return a.arena_ == b.arena_;
+}
+
+template <typename A, typename B>
+bool operator!=(const PoolAllocator<A> &a, const PoolAllocator<B> &b) {
+  return !(a == b);
+}
+
+#endif // POOLALLOCATOR_H
@@ -0,0 +1,71 @@
+#ifndef SMALLVECTOR_H
+#define SMALLVECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief Vector with room for N elements inside the object itself
+ * @tparam T Element type; must be trivially copyable
+ * @tparam N Inline capacity
+ *
+ * Up to N elements live in the object (typically on the stack), so short
+ * sequences are built without touching the heap. Growing past N moves the
+ * elements to a heap buffer that doubles as needed.
+ */
+template <typename T, size_t N> class SmallVector {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SmallVector copies elements with std::copy_n");
+
+public:
+  SmallVector() = default;
+  SmallVector(const SmallVector &) = delete;
+  SmallVector &operator=(const SmallVector &) = delete;
+
+  void push_back(const T &value) {
+    if (size_ == capacity_)
+      grow();
+    data_[size_++] = value;
+  }
+
+  void pop_back() { --size_; }
+  void clear() { size_ = 0; }
+
+  T &back() { return data_[size_ - 1]; }
+  const T &back() const { return data_[size_ - 1]; }
+  T &operator[](size_t index) { return data_[index]; }
+  const T &operator[](size_t index) const { return data_[index]; }
+
+  T *begin() { return data_; }
+  T *end() { return data_ + size_; }
+  const T *begin() const { return data_; }
+  const T *end() const { return data_ + size_; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  /**
+   * @brief Whether the elements have moved to the heap
+   */
+  bool spilled() const { return heap_ != nullptr; }
+
+private:
+  void grow() {
+    size_t capacity = capacity_ * 2;
+    auto heap = std::make_unique<T[]>(capacity);
+    std::copy_n(data_, size_, heap.get());
+    heap_ = std::move(heap);
+    data_ = heap_.get();
+    capacity_ = capacity;
+  }
+
+  T inline_[N];
+  std::unique_ptr<T[]> heap_;
+  T *data_ = inline_;
+  size_t size_ = 0;
+  size_t capacity_ = N;
+};
+
+#endif // SMALLVECTOR_H
@@ -0,0 +1,61 @@
+#include "StringInterner.h"
+#include <stdexcept>
+
+StringInterner::Id StringInterner::intern(std::string_view text) {
+  // Keep the table at most half full so probe sequences stay short
+  if (2 * (hashes_.size() + 1) > slots_.size())
+    grow();
+
+  const uint64_t h = hash(text);
+  const size_t mask = slots_.size() - 1;
+  size_t slot = h & mask;
+  while (slots_[slot] != 0) {
+    Id id = slots_[slot] - 1;
+    if (hashes_[id] == h && get(id) == text)
+      return id;
+    slot = (slot + 1) & mask;
+  }
+
+  if (hashes_.size() >= UINT32_MAX)
+    throw std::length_error("Too many distinct strings");
+  Id id = static_cast<Id>(hashes_.size());
+  arena_.insert(arena_.end(), text.begin(), text.end());
+  offsets_.push_back(arena_.size());
+  hashes_.push_back(h);
+  slots_[slot] = id + 1;
+  return id;
+}
+
+void StringInterner::clear() {
+  arena_.clear();
+  offsets_.assign(1, 0);
+  hashes_.clear();
+  slots_.clear();
+}
+
+uint64_t StringInterner::hash(std::string_view text) {
+  // FNV-1a with a final avalanche so the low bits used for the slot
+  // depend on every byte
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (char c : text) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 0x100000001b3ull;
+  }
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ull;
+  h ^= h >> 32;
+  return h;
+}
+
+void StringInterner::grow() {
+  // Stored hashes make rehashing a pass over the ids, not the strings
+  std::vector<Id> slots(slots_.empty() ? 16 : slots_.size() * 2, 0);
+  const size_t mask = slots.size() - 1;
+  for (Id id = 0; id < hashes_.size(); ++id) {
+    size_t slot = hashes_[id] & mask;
+    while (slots[slot] != 0)
+      slot = (slot + 1) & mask;
+    slots[slot] = id + 1;
+  }
+  slots_.swap(slots);
+}
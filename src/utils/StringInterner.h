@@ -0,0 +1,60 @@
+#ifndef STRINGINTERNER_H
+#define STRINGINTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Deduplicating string store backed by one contiguous arena
+ *
+ * Each distinct string is stored once, back to back in a single buffer,
+ * and identified by a dense 32-bit id. Interning a string that is already
+ * present returns its existing id after one hash probe, so repeated
+ * values cost four bytes per use instead of a heap-allocated copy.
+ */
+class StringInterner {
+public:
+  using Id = uint32_t;
+
+  /**
+   * @brief Id of `text`, adding it if not yet present
+   */
+  Id intern(std::string_view text);
+
+  /**
+   * @brief Contents of an id
+   *
+   * The view is invalidated by the next intern() that adds a string.
+   */
+  std::string_view get(Id id) const {
+    return std::string_view(arena_.data() + offsets_[id],
+                            offsets_[id + 1] - offsets_[id]);
+  }
+
+  /**
+   * @brief Number of distinct strings
+   */
+  size_t size() const { return hashes_.size(); }
+
+  /**
+   * @brief Total bytes of distinct string data
+   */
+  size_t bytes() const { return arena_.size(); }
+
+  void clear();
+
+private:
+  static uint64_t hash(std::string_view text);
+  void grow();
+
+  std::vector<char> arena_;
+  // offsets_[id] .. offsets_[id + 1] is the string with that id
+  std::vector<uint64_t> offsets_{0};
+  std::vector<uint64_t> hashes_;
+  // Open addressing with linear probing; id + 1, or 0 for an empty slot
+  std::vector<Id> slots_;
+};
+
+#endif // STRINGINTERNER_H
@@ -0,0 +1,77 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads for data-parallel loops
+ *
+ * Workers are started once and reused for every parallelFor() call, so
+ * repeated parallel sections do not pay thread creation costs. The calling
+ * thread takes part in the work as worker 0.
+ */
+class ThreadPool {
+public:
+  using RangeFunction =
+      std::function<void(size_t begin, size_t end, size_t worker)>;
+
+  /**
+   * @brief Create a pool
+   * @param threads Total worker count including the caller; 0 picks
+   *                defaultThreadCount()
+   */
+  explicit ThreadPool(size_t threads = 0);
+
+  /**
+   * @brief Stop and join all workers
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Split [0, count) into contiguous ranges and run them in parallel
+   * @param count Number of items
+   * @param body Called once per non-empty range with the worker index
+   *
+   * Ranges are assigned in order, so worker i always gets items before
+   * worker i + 1. Blocks until every range is done. The first exception
+   * thrown by any worker is rethrown in the caller.
+   */
+  void parallelFor(size_t count, const RangeFunction &body);
+
+  /**
+   * @brief Number of workers, including the calling thread
+   */
+  size_t size() const { return workers_.size() + 1; }
+
+  /**
+   * @brief Hardware concurrency, or 1 if unknown
+   */
+  static size_t defaultThreadCount();
+
+private:
+  void workerLoop(size_t worker);
+  void runRange(size_t worker);
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+
+  const RangeFunction *body_ = nullptr;
+  size_t count_ = 0;
+  size_t generation_ = 0;
+  size_t pending_ = 0;
+  bool stopping_ = false;
+  std::exception_ptr error_;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,314 @@
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief List of contiguous element blocks with logarithmic indexing
+ * @tparam T Type of elements stored in the list
+ *
+ * Same interface as LinkedList<T>, but elements are kept kBlockCapacity
+ * at a time in contiguous blocks, and a Fenwick tree over the block sizes
+ * finds the block holding any index in O(log(n / kBlockCapacity)) steps.
+ * at() is therefore logarithmic, and insert() and remove() only shift
+ * elements within one block. Full blocks split in half; a block that
+ * falls below a quarter full merges with a neighbour when both fit.
+ *
+ * Unlike LinkedList, inserting or removing invalidates iterators and
+ * references to elements of the affected block.
+ */
+template <typename T> class UnrolledList {
+public:
+  // Elements per block; about 1 KiB of them, at least 16
+  static constexpr size_t kBlockCapacity =
+      std::max<size_t>(1024 / sizeof(T), 16);
+
+private:
+  using Block = std::vector<T>;
+
+  std::vector<Block> blocks_;
+  // Fenwick tree over blocks_[i].size(), 1-based
+  std::vector<size_t> tree_;
+  size_t size_ = 0;
+
+public:
+  UnrolledList() = default;
+  UnrolledList(const UnrolledList &other) = default;
+  UnrolledList &operator=(const UnrolledList &other) = default;
+
+  UnrolledList(UnrolledList &&other) noexcept
+      : blocks_(std::move(other.blocks_)), tree_(std::move(other.tree_)),
+        size_(std::exchange(other.size_, 0)) {
+    other.blocks_.clear();
+    other.tree_.clear();
+  }
+
+  UnrolledList &operator=(UnrolledList &&other) noexcept {
+    if (this != &other) {
+      blocks_ = std::move(other.blocks_);
+      tree_ = std::move(other.tree_);
+      size_ = std::exchange(other.size_, 0);
+      other.blocks_.clear();
+      other.tree_.clear();
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Add element to the end
+   */
+  void pushBack(const T &value) { emplaceBack(value); }
+  void pushBack(T &&value) { emplaceBack(std::move(value)); }
+
+  /**
+   * @brief Add element to the front
+   */
+  void pushFront(const T &value) { emplaceFront(value); }
+  void pushFront(T &&value) { emplaceFront(std::move(value)); }
+
+  template <typename... Args> T &emplaceBack(Args &&...args) {
+    if (blocks_.empty() || blocks_.back().size() == kBlockCapacity) {
+      blocks_.emplace_back();
+      blocks_.back().reserve(kBlockCapacity);
+      if (tree_.empty())
+        tree_.push_back(0);
+      tree_.push_back(0);
+      // A new last entry covers the blocks below it
+      size_t index = tree_.size() - 1;
+      size_t lowest = index & (~index + 1);
+      for (size_t step = 1; step < lowest; step <<= 1)
+        tree_[index] += tree_[index - step];
+    }
+    T &element = blocks_.back().emplace_back(std::forward<Args>(args)...);
+    ++size_;
+    add(blocks_.size() - 1, 1);
+    return element;
+  }
+
+  template <typename... Args> T &emplaceFront(Args &&...args) {
+    return emplace(0, std::forward<Args>(args)...);
+  }
+
+  /**
+   * @brief Insert element at specific index
+   * @throws std::out_of_range if index > size
+   */
+  void insert(size_t index, const T &value) { emplace(index, value); }
+  void insert(size_t index, T &&value) { emplace(index, std::move(value)); }
+
+  /**
+   * @brief Construct element in place at specific index
+   * @throws std::out_of_range if index > size
+   */
+  template <typename... Args> T &emplace(size_t index, Args &&...args) {
+    if (index > size_) {
+      throw std::out_of_range("Index out of range");
+    }
+    if (index == size_ && (blocks_.empty() ||
+                           blocks_.back().size() < kBlockCapacity)) {
+      return emplaceBack(std::forward<Args>(args)...);
+    }
+
+    // The block holding index, or the last block when appending
+    size_t block, offset;
+    if (index == size_) {
+      block = blocks_.size() - 1;
+      offset = blocks_[block].size();
+    } else {
+      seek(index, block, offset);
+    }
+
+    if (blocks_[block].size() < kBlockCapacity)
+      return emplaceAt(block, offset, std::forward<Args>(args)...);
+
+    // The arguments may refer to elements that split() moves, so build
+    // the value before splitting
+    T value(std::forward<Args>(args)...);
+    split(block);
+    if (offset > blocks_[block].size()) {
+      offset -= blocks_[block].size();
+      ++block;
+    }
+    return emplaceAt(block, offset, std::move(value));
+  }
+
+  /**
+   * @brief Remove element at specific index
+   * @throws std::out_of_range if index >= size
+   */
+  void remove(size_t index) {
+    if (index >= size_) {
+      throw std::out_of_range("Index out of range");
+    }
+
+    size_t block, offset;
+    seek(index, block, offset);
+    Block &target = blocks_[block];
+    target.erase(target.begin() + offset);
+    --size_;
+
+    if (target.empty()) {
+      blocks_.erase(blocks_.begin() + block);
+      rebuild();
+    } else if (target.size() < kBlockCapacity / 4) {
+      merge(block);
+    } else {
+      add(block, -1);
+    }
+  }
+
+  /**
+   * @brief Access element at index
+   * @throws std::out_of_range if index >= size
+   */
+  T &at(size_t index) {
+    if (index >= size_) {
+      throw std::out_of_range("Index out of range");
+    }
+    size_t block, offset;
+    seek(index, block, offset);
+    return blocks_[block][offset];
+  }
+
+  const T &at(size_t index) const {
+    if (index >= size_) {
+      throw std::out_of_range("Index out of range");
+    }
+    size_t block, offset;
+    seek(index, block, offset);
+    return blocks_[block][offset];
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  void clear() {
+    blocks_.clear();
+    tree_.clear();
+    size_ = 0;
+  }
+
+  /**
+   * @brief Iterator for UnrolledList
+   */
+  class Iterator {
+  private:
+    std::vector<Block> *blocks_;
+    size_t block_;
+    size_t offset_;
+
+  public:
+    Iterator(std::vector<Block> *blocks, size_t block)
+        : blocks_(blocks), block_(block), offset_(0) {}
+
+    T &operator*() { return (*blocks_)[block_][offset_]; }
+
+    Iterator &operator++() {
+      if (++offset_ == (*blocks_)[block_].size()) {
+        ++block_;
+        offset_ = 0;
+      }
+      return *this;
+    }
+
+    bool operator!=(const Iterator &other) const {
+      return block_ != other.block_ || offset_ != other.offset_;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return !(*this != other);
+    }
+  };
+
+  Iterator begin() { return Iterator(&blocks_, 0); }
+  Iterator end() { return Iterator(&blocks_, blocks_.size()); }
+
+private:
+  // Block and offset of element index; blocks are never empty
+  void seek(size_t index, size_t &block, size_t &offset) const {
+    size_t position = 0;
+    size_t step = 1;
+    while (step * 2 < tree_.size())
+      step *= 2;
+    for (; step; step >>= 1) {
+      if (position + step < tree_.size() &&
+          tree_[position + step] <= index) {
+        position += step;
+        index -= tree_[position];
+      }
+    }
+    block = position;
+    offset = index;
+  }
+
+  void add(size_t block, ptrdiff_t delta) {
+    for (size_t i = block + 1; i < tree_.size(); i += i & (~i + 1))
+      tree_[i] += delta;
+  }
+
+  void rebuild() {
+    tree_.assign(blocks_.size() + 1, 0);
+    for (size_t i = 1; i < tree_.size(); ++i) {
+      tree_[i] += blocks_[i - 1].size();
+      size_t parent = i + (i & (~i + 1));
+      if (parent < tree_.size())
+        tree_[parent] += tree_[i];
+    }
+  }
+
+  // Inserts into a block with room; vector::emplace copes with arguments
+  // that alias the block's own elements
+  template <typename... Args>
+  T &emplaceAt(size_t block, size_t offset, Args &&...args) {
+    Block &target = blocks_[block];
+    auto position = target.emplace(target.begin() + offset,
+                                   std::forward<Args>(args)...);
+    ++size_;
+    add(block, 1);
+    return *position;
+  }
+
+  // Moves the back half of a full block into a new block after it
+  void split(size_t block) {
+    Block back;
+    back.reserve(kBlockCapacity);
+    Block &front = blocks_[block];
+    size_t half = front.size() / 2;
+    back.insert(back.end(), std::make_move_iterator(front.begin() + half),
+                std::make_move_iterator(front.end()));
+    front.erase(front.begin() + half, front.end());
+    blocks_.insert(blocks_.begin() + block + 1, std::move(back));
+    rebuild();
+  }
+
+  // Joins a small block with a neighbour if both fit in one block
+  void merge(size_t block) {
+    auto fits = [this](size_t left) {
+      return left + 1 < blocks_.size() &&
+             blocks_[left].size() + blocks_[left + 1].size() <=
+                 kBlockCapacity;
+    };
+    size_t left;
+    if (fits(block)) {
+      left = block;
+    } else if (block > 0 && fits(block - 1)) {
+      left = block - 1;
+    } else {
+      add(block, -1);
+      return;
+    }
+    Block &into = blocks_[left];
+    Block &from = blocks_[left + 1];
+    into.insert(into.end(), std::make_move_iterator(from.begin()),
+                std::make_move_iterator(from.end()));
+    blocks_.erase(blocks_.begin() + left + 1);
+    rebuild();
+  }
+};
+
+#endif // UNROLLEDLIST_H